@@ -0,0 +1,64 @@
+#include "AnomalyDetector.h"
+
+#include <math.h>
+
+
+AnomalyDetector::AnomalyDetector(float alpha, uint16_t warmupSamples)
+    : alpha_(alpha), warmupSamples_(warmupSamples) {
+  reset();
+}
+
+
+void AnomalyDetector::reset() {
+  for (int f = 0; f < WF_COUNT; f++) {
+    fields_[f].mean = 0.0f;
+    fields_[f].variance = 0.0f;
+    fields_[f].count = 0;
+  }
+}
+
+
+float AnomalyDetector::stddev(WindowField field) const {
+  float sd = sqrtf(fields_[field].variance);
+  return sd > SENSOR_FIELDS[field].noiseFloor ? sd : SENSOR_FIELDS[field].noiseFloor;
+}
+
+
+AnomalyScore AnomalyDetector::update(const SensorSample &sample, uint8_t sensorMask) {
+  AnomalyScore worst = { 0.0f, WF_HUMIDITY, 0.0f };
+
+  for (int f = 0; f < WF_COUNT; f++) {
+    if (!(sensorMask & sensorFieldBit(f))) {
+      continue;
+    }
+    float value = sampleField(sample, f);
+    if (isnan(value)) {
+      continue;
+    }
+
+    FieldState &state = fields_[f];
+    if (state.count == 0) {
+      state.mean = value;
+      state.count = 1;
+      continue;
+    }
+
+    float delta = value - state.mean;
+    if (state.count >= warmupSamples_) {
+      float z = fabsf(delta) / stddev((WindowField)f);
+      if (z > worst.z) {
+        worst.z = z;
+        worst.field = (WindowField)f;
+        worst.value = value;
+      }
+    } else {
+      state.count++;
+    }
+
+    // Incremental EWMA mean and variance (West 1979)
+    float increment = alpha_ * delta;
+    state.mean += increment;
+    state.variance = (1.0f - alpha_) * (state.variance + delta * increment);
+  }
+  return worst;
+}
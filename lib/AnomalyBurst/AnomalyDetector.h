@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <Telemetry.h>
+
+/**
+ * Streaming anomaly score per sensor field.
+ *
+ * Every field (WindowField) keeps an exponentially weighted mean and
+ * variance. A new reading is scored against the estimate *before* it is
+ * folded in, as z = |x - mean| / stddev, so a spike cannot hide itself.
+ * Memory is O(1) per field and each update is a handful of float
+ * operations, cheap enough for every acquisition cycle.
+ *
+ * The stddev is floored at the field's noise floor (SensorField::noiseFloor):
+ * a quantised, flat signal (SGP30 at its baseline, a resting gyro) would
+ * otherwise have a near-zero variance and turn the smallest step into a
+ * huge z. Fields score 0 until they have seen warmupSamples readings.
+ *
+ * Platform-free so tools/trace_replay can run the same scoring on a
+ * recorded trace.
+ */
+
+/**
+ * @brief Highest-scoring field of one sample
+ */
+struct AnomalyScore {
+  float z;              // 0 while warming up or when no field was scored
+  WindowField field;
+  float value;
+};
+
+class AnomalyDetector {
+public:
+  /**
+   * @param alpha          EWMA weight of a new reading (0..1); ~2/alpha readings of memory
+   * @param warmupSamples  readings per field before it is scored
+   */
+  AnomalyDetector(float alpha, uint16_t warmupSamples);
+
+  /**
+   * @brief Score every field of the sensors in sensorMask, then update their estimates
+   * NaN readings (failed reads) are skipped.
+   */
+  AnomalyScore update(const SensorSample &sample, uint8_t sensorMask);
+
+  void reset();
+
+  float mean(WindowField field) const { return fields_[field].mean; }
+  float stddev(WindowField field) const;
+
+private:
+  struct FieldState {
+    float mean;
+    float variance;
+    uint16_t count;
+  };
+
+  float alpha_;
+  uint16_t warmupSamples_;
+  FieldState fields_[WF_COUNT];
+};
@@ -0,0 +1,122 @@
+#include "BurstRecorder.h"
+
+#include <string.h>
+
+
+BurstRecorder::BurstRecorder()
+    : written_(0), uploadNext_(0), peekEnd_(0), preTriggerRows_(0), burstMs_(0), maxBurstMs_(0),
+      active_(false), burstId_(0), startMs_(0), untilMs_(0), bursts_(0), dropped_(0) {
+  memset(rows_, 0, sizeof(rows_));
+  memset(&trigger_, 0, sizeof(trigger_));
+}
+
+
+void BurstRecorder::configure(uint8_t preTriggerRows, uint32_t burstMs, uint32_t maxBurstMs) {
+  // Keep at least half the ring for rows captured after the trigger
+  preTriggerRows_ = preTriggerRows < BURST_RING_CAPACITY / 2 ? preTriggerRows : BURST_RING_CAPACITY / 2;
+  burstMs_ = burstMs;
+  maxBurstMs_ = maxBurstMs > burstMs ? maxBurstMs : burstMs;
+}
+
+
+BurstEvent BurstRecorder::observe(const SensorSample &sample, uint8_t mask, int64_t timeMs,
+                                  const AnomalyScore &score, bool anomalous, uint32_t nowMs) {
+  BurstEvent event = BURST_NONE;
+
+  if (active_ && (int32_t)(nowMs - untilMs_) >= 0) {
+    active_ = false;
+    event = BURST_ENDED;
+  }
+
+  if (anomalous && !active_) {
+    active_ = true;
+    burstId_ = burstId_ == 0xFFFF ? 1 : burstId_ + 1;
+    startMs_ = nowMs;
+    untilMs_ = nowMs + burstMs_;
+    bursts_++;
+
+    // Tag the history that led up to the trigger (rows already in another burst keep their id)
+    uint32_t first = written_ > preTriggerRows_ ? written_ - preTriggerRows_ : 0;
+    if (first < oldest()) first = oldest();
+    if (first < uploadNext_) first = uploadNext_;
+    uint8_t tagged = 0;
+    for (uint32_t seq = first; seq < written_; seq++) {
+      if (slot(seq).burst == 0) {
+        slot(seq).burst = burstId_;
+        tagged++;
+      }
+    }
+
+    trigger_.burst = burstId_;
+    trigger_.score = score;
+    trigger_.timeMs = timeMs;
+    trigger_.preTriggerRows = tagged;
+    event = BURST_STARTED;
+  } else if (anomalous) {
+    uint32_t until = nowMs + burstMs_;
+    uint32_t limit = startMs_ + maxBurstMs_;
+    untilMs_ = (int32_t)(until - limit) > 0 ? limit : until;
+    event = BURST_EXTENDED;
+  }
+
+  // Overwriting a row the uploader has not taken yet loses it
+  if (written_ >= BURST_RING_CAPACITY) {
+    uint32_t evicted = written_ - BURST_RING_CAPACITY;
+    if (evicted >= uploadNext_) {
+      if (slot(evicted).burst != 0) {
+        dropped_++;
+      }
+      uploadNext_ = evicted + 1;
+    }
+  }
+
+  BurstRow &row = slot(written_);
+  row.sample = sample;
+  row.timeMs = timeMs;
+  row.mask = mask;
+  row.burst = active_ ? burstId_ : 0;
+  written_++;
+  return event;
+}
+
+
+void BurstRecorder::skipUntagged() {
+  // Untagged rows inside the pre-trigger window may still be tagged by a later trigger
+  uint32_t settled = written_ > preTriggerRows_ ? written_ - preTriggerRows_ : 0;
+  while (uploadNext_ < settled && slot(uploadNext_).burst == 0) {
+    uploadNext_++;
+  }
+}
+
+
+size_t BurstRecorder::peek(BurstRow* out, size_t max) {
+  skipUntagged();
+  size_t count = 0;
+  uint32_t seq = uploadNext_;
+  uint16_t burst = seq < written_ ? slot(seq).burst : 0;
+  while (count < max && seq < written_ && burst != 0 && slot(seq).burst == burst) {
+    out[count++] = slot(seq);
+    seq++;
+  }
+  peekEnd_ = seq;
+  return count;
+}
+
+
+void BurstRecorder::commit() {
+  // Rows overwritten since peek() already moved uploadNext_ past peekEnd_
+  if ((int32_t)(peekEnd_ - uploadNext_) > 0) {
+    uploadNext_ = peekEnd_;
+  }
+}
+
+
+size_t BurstRecorder::pending() const {
+  size_t count = 0;
+  for (uint32_t seq = uploadNext_; seq < written_; seq++) {
+    if (slot(seq).burst != 0) {
+      count++;
+    }
+  }
+  return count;
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <AnomalyDetector.h>
+#include <Telemetry.h>
+
+/**
+ * Pre-trigger history and time-limited burst capture.
+ *
+ * Every acquisition cycle is written into a ring of the last
+ * BURST_RING_CAPACITY samples, whatever the data looks like. Normally
+ * nothing is uploaded from it. An anomalous sample starts a burst: the
+ * preTriggerRows samples before it are tagged with a new burst id, and so
+ * is every sample until the burst ends. The uploader takes tagged rows in
+ * order (peek/commit), one burst at a time.
+ *
+ * A burst lasts burstMs from the trigger. Another anomaly during a burst
+ * extends it to burstMs from that sample, but never past maxBurstMs from
+ * the trigger, so a sustained level shift cannot keep the device in burst
+ * mode for good (the EWMA has adapted to the new level by then).
+ *
+ * If the uploader falls a full ring behind, the oldest tagged rows are
+ * overwritten and counted in dropped().
+ *
+ * Not thread-safe: the firmware writes from the sensor task and uploads
+ * from the sender task under one portMUX.
+ */
+
+#ifndef BURST_RING_CAPACITY
+#define BURST_RING_CAPACITY 48    // Samples (48 * 72 B = 3.4 KB)
+#endif
+
+struct BurstRow {
+  SensorSample sample;
+  int64_t timeMs;       // Epoch ms once the clock is synced, else uptime ms
+  uint16_t burst;       // Burst id, 0 = not part of a burst
+  uint8_t mask;         // SensorBit flags of the valid fields
+};
+
+/**
+ * @brief What started a burst
+ */
+struct BurstTrigger {
+  uint16_t burst;
+  AnomalyScore score;
+  int64_t timeMs;
+  uint8_t preTriggerRows;   // History rows tagged with the trigger
+};
+
+enum BurstEvent {
+  BURST_NONE,
+  BURST_STARTED,
+  BURST_EXTENDED,
+  BURST_ENDED
+};
+
+class BurstRecorder {
+public:
+  BurstRecorder();
+
+  void configure(uint8_t preTriggerRows, uint32_t burstMs, uint32_t maxBurstMs);
+
+  /**
+   * @brief Record one acquisition cycle
+   * @param anomalous the cycle's anomaly score crossed the threshold
+   * @param nowMs     monotonic time used for the burst duration
+   */
+  BurstEvent observe(const SensorSample &sample, uint8_t mask, int64_t timeMs,
+                     const AnomalyScore &score, bool anomalous, uint32_t nowMs);
+
+  bool active() const { return active_; }
+
+  /**
+   * @brief Copy up to max of the next tagged rows, all from the same burst
+   * Nothing is consumed until commit().
+   * @return rows copied
+   */
+  size_t peek(BurstRow* out, size_t max);
+
+  /**
+   * @brief Consume the rows handed out by the last peek()
+   */
+  void commit();
+
+  /**
+   * @brief Tagged rows not yet committed
+   */
+  size_t pending() const;
+
+  const BurstTrigger &lastTrigger() const { return trigger_; }
+  uint32_t bursts() const { return bursts_; }
+  uint32_t dropped() const { return dropped_; }
+
+private:
+  BurstRow &slot(uint32_t seq) { return rows_[seq % BURST_RING_CAPACITY]; }
+  const BurstRow &slot(uint32_t seq) const { return rows_[seq % BURST_RING_CAPACITY]; }
+  uint32_t oldest() const { return written_ > BURST_RING_CAPACITY ? written_ - BURST_RING_CAPACITY : 0; }
+  void skipUntagged();
+
+  BurstRow rows_[BURST_RING_CAPACITY];
+  uint32_t written_;      // Rows ever written; row n lives in rows_[n % capacity]
+  uint32_t uploadNext_;   // First row not yet committed
+  uint32_t peekEnd_;      // One past the last row handed out by peek()
+  uint8_t preTriggerRows_;
+  uint32_t burstMs_;
+  uint32_t maxBurstMs_;
+  bool active_;
+  uint16_t burstId_;
+  uint32_t startMs_;
+  uint32_t untilMs_;
+  BurstTrigger trigger_;
+  uint32_t bursts_;
+  uint32_t dropped_;
+};
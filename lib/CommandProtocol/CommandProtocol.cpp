@@ -0,0 +1,160 @@
+#include "CommandProtocol.h"
+
+#include <Telemetry.h>
+
+#include <ctype.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define COMMAND_FIELDS 6   // version;seq;type;issued_ms;expires_ms;params
+
+
+/**
+ * @brief Parse a decimal field that must be consumed completely
+ */
+static bool parseNumber(const char* text, size_t length, uint64_t max, uint64_t &out) {
+  if (length == 0 || length > 20) {
+    return false;
+  }
+  uint64_t value = 0;
+  for (size_t i = 0; i < length; i++) {
+    if (!isdigit((unsigned char)text[i])) {
+      return false;
+    }
+    uint64_t next = value * 10 + (uint64_t)(text[i] - '0');
+    if (next < value || next > max) {
+      return false;
+    }
+    value = next;
+  }
+  out = value;
+  return true;
+}
+
+
+CommandResult commandParse(const char* text, CommandEnvelope &cmd) {
+  memset(&cmd, 0, sizeof(cmd));
+  cmd.type = CMD_TYPE_COUNT;
+  if (!text || strlen(text) > COMMAND_TEXT_MAX) {
+    return CMD_BAD_FORMAT;
+  }
+
+  // Field boundaries; params (the last field) is the rest of the string
+  const char* start[COMMAND_FIELDS];
+  size_t length[COMMAND_FIELDS];
+  const char* p = text;
+  for (int f = 0; f < COMMAND_FIELDS; f++) {
+    start[f] = p;
+    const char* end = f < COMMAND_FIELDS - 1 ? strchr(p, ';') : NULL;
+    if (!end) {
+      if (f < COMMAND_FIELDS - 1) {
+        // Read what we can so a short envelope is still acknowledged against its seq
+        uint64_t seq;
+        if (f >= 2 && parseNumber(start[1], length[1], 0xFFFFFFFF, seq)) {
+          cmd.seq = (uint32_t)seq;
+        }
+        return CMD_BAD_FORMAT;
+      }
+      end = p + strlen(p);
+    }
+    length[f] = (size_t)(end - p);
+    p = *end ? end + 1 : end;
+  }
+
+  uint64_t value;
+  if (!parseNumber(start[0], length[0], 0xFF, value)) {
+    return CMD_BAD_FORMAT;
+  }
+  cmd.version = (uint8_t)value;
+  if (!parseNumber(start[1], length[1], 0xFFFFFFFF, value) || value == 0) {
+    return CMD_BAD_FORMAT;
+  }
+  cmd.seq = (uint32_t)value;
+  if (cmd.version != COMMAND_PROTOCOL_VERSION) {
+    return CMD_BAD_VERSION;   // Later versions may lay out the remaining fields differently
+  }
+
+  for (int t = 0; t < CMD_TYPE_COUNT; t++) {
+    if (strlen(COMMAND_TYPE_NAMES[t]) == length[2] && !strncmp(start[2], COMMAND_TYPE_NAMES[t], length[2])) {
+      cmd.type = (uint8_t)t;
+    }
+  }
+
+  if (!parseNumber(start[3], length[3], INT64_MAX, value)) {
+    return CMD_BAD_FORMAT;
+  }
+  cmd.issuedMs = (int64_t)value;
+  if (!parseNumber(start[4], length[4], INT64_MAX, value)) {
+    return CMD_BAD_FORMAT;
+  }
+  cmd.expiresMs = (int64_t)value;
+
+  if (length[5] > COMMAND_PARAMS_MAX) {
+    return CMD_BAD_PARAMS;
+  }
+  memcpy(cmd.params, start[5], length[5]);
+  cmd.params[length[5]] = '\0';
+
+  return cmd.type == CMD_TYPE_COUNT ? CMD_UNKNOWN_TYPE : CMD_OK;
+}
+
+
+CommandResult commandCheck(const CommandEnvelope &cmd, uint32_t lastSeq, int64_t nowMs) {
+  if (cmd.seq <= lastSeq) {
+    return CMD_DUPLICATE;
+  }
+  if (cmd.expiresMs != 0 && nowMs != 0 && nowMs > cmd.expiresMs) {
+    return CMD_EXPIRED;
+  }
+
+  switch (cmd.type) {
+    case CMD_ACTION: {
+      uint8_t index;
+      bool on;
+      return commandActionParams(cmd.params, index, on) ? CMD_OK : CMD_BAD_PARAMS;
+    }
+    case CMD_TRACE_LEVEL:
+      return cmd.params[0] >= '0' && cmd.params[0] <= '3' && cmd.params[1] == '\0' ? CMD_OK : CMD_BAD_PARAMS;
+    case CMD_PING:
+    case CMD_CONFIG_POLL:
+      return cmd.params[0] == '\0' ? CMD_OK : CMD_BAD_PARAMS;
+    default:
+      return CMD_UNKNOWN_TYPE;
+  }
+}
+
+
+bool commandActionParams(const char* params, uint8_t &index, bool &on) {
+  if (params[0] < '1' || params[0] > '0' + ACTION_COUNT || params[1] != '=') {
+    return false;
+  }
+  const char* value = params + 2;
+  if (!strcmp(value, "ON")) {
+    on = true;
+  } else if (!strcmp(value, "OFF")) {
+    on = false;
+  } else {
+    return false;
+  }
+  index = (uint8_t)(params[0] - '0');
+  return true;
+}
+
+
+size_t commandFormat(const CommandEnvelope &cmd, char* out, size_t capacity) {
+  const char* type = cmd.type < CMD_TYPE_COUNT ? COMMAND_TYPE_NAMES[cmd.type] : "";
+  int length = snprintf(out, capacity, "%u;%" PRIu32 ";%s;%" PRId64 ";%" PRId64 ";%s",
+                        (unsigned)cmd.version, cmd.seq, type, cmd.issuedMs, cmd.expiresMs, cmd.params);
+  return length > 0 && (size_t)length < capacity ? (size_t)length : 0;
+}
+
+
+uint32_t commandTextHash(const char* text) {
+  uint32_t hash = 2166136261u;
+  for (const char* p = text; *p; p++) {
+    hash = (hash ^ (uint8_t)*p) * 16777619u;
+  }
+  return hash;
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Versioned operator command envelope.
+ *
+ * An operator writes one command as a single string to <USER>/Command:
+ *
+ *   1;<seq>;<type>;<issued_ms>;<expires_ms>;<params>
+ *   1;42;action;1760000000000;1760000030000;3=ON
+ *
+ * version is COMMAND_PROTOCOL_VERSION. seq increases with every command
+ * the operator issues; the device executes a command at most once and
+ * ignores any seq at or below the last one it executed. issued_ms and
+ * expires_ms are Unix epoch milliseconds (0 = not given / never expires);
+ * a command past its expiry is acknowledged but not executed. params is
+ * the rest of the string and its meaning depends on the type.
+ *
+ * Every command the device takes up is answered at <USER>/Command_Ack with
+ * the seq, a CommandResult and the receive/execute timestamps, so the
+ * operator can tell whether and when it acted.
+ *
+ * One short string instead of a JSON document keeps a poll to a single
+ * small read and the parse off the heap.
+ */
+
+#define COMMAND_PROTOCOL_VERSION  1
+#define COMMAND_TEXT_MAX          96    // Longest envelope accepted
+#define COMMAND_PARAMS_MAX        32
+
+enum CommandType {
+  CMD_PING,           // No-op; measures the round trip
+  CMD_ACTION,         // "<n>=ON|OFF": set Actions/action_n (1..ACTION_COUNT)
+  CMD_TRACE_LEVEL,    // "<0..3>": TraceLog level until the next config apply
+  CMD_CONFIG_POLL,    // Check <USER>/Config now instead of at the next poll
+  CMD_TYPE_COUNT
+};
+
+static const char* const COMMAND_TYPE_NAMES[CMD_TYPE_COUNT] = {
+  "ping", "action", "trace_level", "config_poll"
+};
+
+enum CommandResult {
+  CMD_OK,
+  CMD_DUPLICATE,        // seq already executed
+  CMD_EXPIRED,
+  CMD_BAD_VERSION,
+  CMD_BAD_FORMAT,
+  CMD_UNKNOWN_TYPE,
+  CMD_BAD_PARAMS,
+  CMD_FAILED,           // Valid, but executing it failed
+  CMD_RESULT_COUNT
+};
+
+static const char* const COMMAND_RESULT_NAMES[CMD_RESULT_COUNT] = {
+  "ok", "duplicate", "expired", "bad_version", "bad_format", "unknown_type", "bad_params", "failed"
+};
+
+struct CommandEnvelope {
+  uint8_t version;
+  uint32_t seq;
+  uint8_t type;           // CommandType
+  int64_t issuedMs;       // Operator clock, epoch ms (0 = not given)
+  int64_t expiresMs;      // Epoch ms (0 = never)
+  char params[COMMAND_PARAMS_MAX + 1];
+};
+
+/**
+ * @brief What the device writes back to <USER>/Command_Ack
+ * Times are device epoch ms (0 while its clock is not synced).
+ */
+struct CommandAck {
+  uint32_t seq;
+  uint8_t type;           // CommandType (CMD_TYPE_COUNT if unreadable)
+  uint8_t result;         // CommandResult
+  int64_t issuedMs;       // Copied from the envelope
+  int64_t receivedMs;     // Poll that picked the command up
+  int64_t executedMs;     // Execution finished (or the command was refused)
+
+  /**
+   * @brief Issue-to-execution time, -1 when either clock is unknown
+   * Spans two clocks (operator and device), so it is only as good as their sync.
+   */
+  int64_t latencyMs() const { return issuedMs != 0 && executedMs != 0 ? executedMs - issuedMs : -1; }
+};
+
+/**
+ * @brief Parse an envelope string
+ * seq is filled in as soon as it is read, so even a rejected command can be
+ * acknowledged against its seq.
+ */
+CommandResult commandParse(const char* text, CommandEnvelope &cmd);
+
+/**
+ * @brief Sequence, expiry and parameter checks on a parsed envelope
+ * @param lastSeq seq of the last executed command
+ * @param nowMs   device epoch ms, 0 if the clock is not synced (expiry is then not checked)
+ */
+CommandResult commandCheck(const CommandEnvelope &cmd, uint32_t lastSeq, int64_t nowMs);
+
+/**
+ * @brief Split CMD_ACTION params ("3=ON")
+ * @param index 1-based action number
+ */
+bool commandActionParams(const char* params, uint8_t &index, bool &on);
+
+/**
+ * @brief Format an envelope (operator side and tests)
+ * @return length written, excluding the terminator; 0 if out is too small
+ */
+size_t commandFormat(const CommandEnvelope &cmd, char* out, size_t capacity);
+
+/**
+ * @brief Fingerprint of an envelope string (FNV-1a), to skip one already handled
+ */
+uint32_t commandTextHash(const char* text);
@@ -0,0 +1,31 @@
+#include "DataReadyTiming.h"
+
+#include <stdlib.h>
+
+
+DataReadyTiming::DataReadyTiming(uint32_t periodUs)
+    : periodUs_(periodUs), lastCount_(0), lastReadUs_(0), streaming_(false) {
+}
+
+
+void DataReadyTiming::record(const DataReadyEdge &edge, int64_t readUs, DataReadyStats &stats) {
+  stats.reads++;
+
+  if (edge.count != 0) {
+    stats.latencyUs.add((float)(readUs - edge.us));
+    uint32_t newEdges = edge.count - lastCount_;   // Wraps correctly
+    if (newEdges == 0) {
+      stats.duplicates++;
+    } else if (streaming_ && newEdges > 1) {
+      stats.missed += newEdges - 1;
+    }
+  }
+
+  if (streaming_) {
+    stats.jitterUs.add((float)llabs(readUs - lastReadUs_ - (int64_t)periodUs_));
+  }
+
+  lastCount_ = edge.count;
+  lastReadUs_ = readUs;
+  streaming_ = true;
+}
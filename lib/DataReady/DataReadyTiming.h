@@ -0,0 +1,102 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <WindowStats.h>
+
+/**
+ * Timing of sensor reads against the sensor's own data-ready signal.
+ *
+ * The sensor pulses data-ready each time it latches a new sample, and the
+ * ISR keeps the edge count and the time of the latest edge. Every read is
+ * scored against that edge:
+ *
+ *   latency    age of the sample when read (latest edge -> read done)
+ *   jitter     |read interval - sensor period| within one stream
+ *   duplicate  no edge since the previous read (same sample read twice)
+ *   missed     edges skipped since the previous read (samples lost)
+ *
+ * A polled reader wakes on its own timer, which drifts against the sensor's
+ * oscillator: the sample age sweeps across a whole period and duplicates
+ * or misses appear every time the two clocks slip by one sample. A reader
+ * woken by the interrupt follows the sensor, so latency is just the wake-up
+ * and bus time.
+ *
+ * Platform-free so tools/imu_irq_sim can drive it from synthetic interrupts.
+ */
+
+/**
+ * @brief Snapshot of the data-ready ISR state
+ */
+struct DataReadyEdge {
+  uint32_t count;   // Edges since boot (0 = none seen: INT not wired or not enabled)
+  int64_t us;       // Time of the latest edge, same clock as the reads
+};
+
+/**
+ * @brief Read timing over one report window
+ * The only part another task needs: the reader's cursor (DataReadyTiming)
+ * stays with the reading task, so sharing this under a lock is enough.
+ */
+struct DataReadyStats {
+  WindowStats latencyUs;
+  WindowStats jitterUs;
+  uint32_t reads;
+  uint32_t duplicates;
+  uint32_t missed;
+
+  DataReadyStats() { reset(); }
+
+  void reset() {
+    latencyUs.reset();
+    jitterUs.reset();
+    reads = 0;
+    duplicates = 0;
+    missed = 0;
+  }
+};
+
+/**
+ * @brief One reader's position in the data-ready stream
+ * Owned by the reading task; only record() touches shared state (its stats argument).
+ */
+class DataReadyTiming {
+public:
+  /**
+   * @param periodUs nominal sensor period (1e6 / data-ready rate)
+   */
+  explicit DataReadyTiming(uint32_t periodUs);
+
+  /**
+   * @brief Score one completed read into stats
+   * @param edge   ISR state taken just before the read started
+   * @param readUs time the read finished
+   */
+  void record(const DataReadyEdge &edge, int64_t readUs, DataReadyStats &stats);
+
+  /**
+   * @brief Start a new stream: the next read is not compared with the previous one
+   * Duplicates are still detected across the gap.
+   */
+  void restart() { streaming_ = false; }
+
+  /**
+   * @brief True if the sensor has latched a sample this reader has not read yet
+   */
+  bool fresh(const DataReadyEdge &edge) const { return edge.count != lastCount_; }
+
+  /**
+   * @brief Treat every sample latched so far as read
+   * An interrupt-driven reader calls this before waiting, so it starts on a
+   * new edge instead of a sample that may already be a period old.
+   */
+  void discard(const DataReadyEdge &edge) { lastCount_ = edge.count; }
+
+  uint32_t periodUs() const { return periodUs_; }
+
+private:
+  uint32_t periodUs_;
+  uint32_t lastCount_;
+  int64_t lastReadUs_;
+  bool streaming_;
+};
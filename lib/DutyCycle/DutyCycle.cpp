@@ -0,0 +1,142 @@
+#include "DutyCycle.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <type_traits>
+
+static_assert(DUTY_CYCLE_CAPACITY <= 255, "DutyCycleState indexes samples with uint8_t");
+static_assert(std::is_trivial<DutyCycleState>::value, "DutyCycleState lives in RTC memory and must not have constructors");
+static_assert(sizeof(DutySample) == DUTY_SAMPLE_BYTES, "DutySample must stay packed: it is also the GPRS frame sample");
+
+
+static int16_t toFixed(float value, float scale) {
+  if (isnan(value)) {
+    return INT16_MIN;   // Reserved for "no reading"
+  }
+  float scaled = roundf(value * scale);
+  if (scaled > INT16_MAX) return INT16_MAX;
+  if (scaled < INT16_MIN + 1) return INT16_MIN + 1;
+  return (int16_t)scaled;
+}
+
+static float fromFixed(int16_t value, float scale) {
+  return value == INT16_MIN ? NAN : value / scale;
+}
+
+
+void dutyCycleReset(DutyCycleState &state) {
+  memset(&state, 0, sizeof(state));
+  state.magic = DUTY_CYCLE_MAGIC;
+}
+
+
+bool dutyCycleValid(const DutyCycleState &state) {
+  return state.magic == DUTY_CYCLE_MAGIC && state.count <= DUTY_CYCLE_CAPACITY
+      && state.head < DUTY_CYCLE_CAPACITY;
+}
+
+
+int64_t dutyCycleWakeLatencyUs(const DutyCycleState &state, int64_t nowUs) {
+  if (state.sleepStartUs == 0) {
+    return -1;
+  }
+  return nowUs - (state.sleepStartUs + state.plannedSleepUs);
+}
+
+
+void dutySamplePack(const SensorSample &sample, uint8_t mask, uint32_t offsetMs, DutySample &slot) {
+  slot.offsetMs = offsetMs;
+  for (int f = 0; f < WF_COUNT; f++) {
+    slot.value[f] = toFixed(sampleField(sample, f), SENSOR_FIELDS[f].fixedScale);
+  }
+  slot.mask = mask;
+  slot.reserved = 0;
+}
+
+
+uint8_t dutySampleUnpack(const DutySample &slot, SensorSample &sample) {
+  memset(&sample, 0, sizeof(sample));
+  for (int f = 0; f < WF_COUNT; f++) {
+    // Fields of sensors that were not read on that wake come back as "no reading"
+    bool valid = (slot.mask & sensorFieldBit(f)) != 0;
+    setSampleField(sample, f, valid ? fromFixed(slot.value[f], SENSOR_FIELDS[f].fixedScale) : NAN);
+  }
+  return slot.mask;
+}
+
+
+void dutyCyclePush(DutyCycleState &state, const SensorSample &sample, uint8_t mask, int64_t timeMs) {
+  if (state.count == 0) {
+    state.baseMs = timeMs;
+  }
+  if (state.count == DUTY_CYCLE_CAPACITY) {
+    // Full: overwrite the oldest sample
+    state.head = (state.head + 1) % DUTY_CYCLE_CAPACITY;
+    state.count--;
+    state.stats.overwritten++;
+  }
+
+  int64_t offset = timeMs - state.baseMs;
+  dutySamplePack(sample, mask, offset < 0 ? 0 : (uint32_t)offset,
+                 state.samples[(state.head + state.count) % DUTY_CYCLE_CAPACITY]);
+  state.count++;
+}
+
+
+uint8_t dutyCycleSample(const DutyCycleState &state, uint8_t i, SensorSample &sample, int64_t &timeMs) {
+  const DutySample &slot = state.samples[(state.head + i) % DUTY_CYCLE_CAPACITY];
+  timeMs = state.baseMs + slot.offsetMs;
+  return dutySampleUnpack(slot, sample);
+}
+
+
+void dutyCycleConsume(DutyCycleState &state, uint8_t n) {
+  if (n >= state.count) {
+    state.head = 0;
+    state.count = 0;
+    return;
+  }
+  // Rebase so the remaining offsets stay small
+  int64_t newBase = state.baseMs + state.samples[(state.head + n) % DUTY_CYCLE_CAPACITY].offsetMs;
+  uint32_t shift = (uint32_t)(newBase - state.baseMs);
+  state.head = (state.head + n) % DUTY_CYCLE_CAPACITY;
+  state.count -= n;
+  for (uint8_t i = 0; i < state.count; i++) {
+    uint32_t &offset = state.samples[(state.head + i) % DUTY_CYCLE_CAPACITY].offsetMs;
+    offset = offset > shift ? offset - shift : 0;
+  }
+  state.baseMs = newBase;
+}
+
+
+void dutyCycleClockStepped(DutyCycleState &state, int64_t deltaMs) {
+  state.baseMs += deltaMs;
+  if (state.sleepStartUs != 0) {
+    state.sleepStartUs += deltaMs * 1000;
+  }
+}
+
+
+bool dutyCycleUploadDue(const DutyCycleState &state, const DutyCycleConfig &config) {
+  if (state.count >= DUTY_CYCLE_CAPACITY) {
+    return true;
+  }
+  return config.uploadEvery <= 1 || state.wakeCount % config.uploadEvery == 0;
+}
+
+
+uint64_t dutyCycleSleepUs(const DutyCycleConfig &config, uint64_t awakeUs) {
+  uint64_t periodUs = (uint64_t)config.periodMs * 1000ULL;
+  uint64_t minUs = (uint64_t)config.minSleepMs * 1000ULL;
+  if (awakeUs + minUs >= periodUs) {
+    return minUs;
+  }
+  return periodUs - awakeUs;
+}
+
+
+float dutyCycleEnergyMj(const DutyEnergyModel &model, float activeMs, float radioMs, float sleepMs) {
+  // mA * ms * V = uJ; / 1000 -> mJ
+  return model.supplyV * (model.activeMa * activeMs + model.radioMa * radioMs + model.sleepMa * sleepMs) / 1000.0f;
+}
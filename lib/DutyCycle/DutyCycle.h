@@ -0,0 +1,169 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <Telemetry.h>
+
+/**
+ * Deep-sleep duty cycle bookkeeping.
+ *
+ * In duty-cycle mode the device wakes from deep sleep, takes one sample,
+ * appends it to a buffer kept in RTC slow memory and goes back to sleep.
+ * Every DutyCycleConfig::uploadEvery wakes (or when the buffer fills) it
+ * also brings up Wi-Fi and uploads the whole buffer.
+ *
+ * Everything that survives a deep sleep lives in one DutyCycleState, which
+ * the firmware places in RTC memory (RTC_DATA_ATTR). Samples are packed
+ * into fixed-point DutySample records (32 bytes) so a useful backlog fits
+ * in the 8 KB RTC slow memory. The state must stay trivially constructible:
+ * a constructor would run again on every wake and wipe it.
+ *
+ * Timing comes from the RTC-backed system clock, which keeps running
+ * through deep sleep: wake latency is measured against the planned wake
+ * time and the energy model integrates the measured phase durations.
+ *
+ * Platform-free so tools/duty_cycle_sim can run the same logic on the host.
+ */
+
+#ifndef DUTY_CYCLE_CAPACITY
+#define DUTY_CYCLE_CAPACITY 48    // Buffered samples (48 * 32 B = 1.5 KB of RTC memory)
+#endif
+
+#define DUTY_CYCLE_MAGIC 0x44435933UL   // "DCY3"; bump when DutyCycleState changes layout
+
+/**
+ * @brief One buffered sample in fixed point
+ * One value per SENSOR_FIELDS entry, scaled by its fixedScale; INT16_MIN = no reading.
+ */
+struct DutySample {
+  uint32_t offsetMs;        // From DutyCycleState::baseMs
+  int16_t value[WF_COUNT];  // Indexed by WindowField
+  uint8_t mask;             // SensorBit flags of the fields that are valid
+  uint8_t reserved;
+};
+
+#define DUTY_SAMPLE_BYTES (4 + 2 * WF_COUNT + 2)
+
+/**
+ * @brief Pack a reading into fixed point (fields outside mask are ignored on unpack)
+ */
+void dutySamplePack(const SensorSample &sample, uint8_t mask, uint32_t offsetMs, DutySample &slot);
+
+/**
+ * @brief Unpack a fixed-point reading; fields outside its mask come back as NaN
+ * @return the sample's mask
+ */
+uint8_t dutySampleUnpack(const DutySample &slot, SensorSample &sample);
+
+/**
+ * @brief Average supply current of each phase, for the energy estimate
+ */
+struct DutyEnergyModel {
+  float supplyV;
+  float activeMa;           // CPU awake, radio off (boot + sensing)
+  float radioMa;            // Wi-Fi associating / uploading
+  float sleepMa;            // Deep sleep, whole board including sensors
+};
+
+struct DutyCycleConfig {
+  uint32_t periodMs;        // Wake-to-wake period
+  uint16_t uploadEvery;     // Upload on every Nth wake
+  uint32_t minSleepMs;      // Floor when a wake overruns the period
+};
+
+/**
+ * @brief Count/mean/max of a duration (all-zero is the empty state)
+ */
+struct DutyTiming {
+  uint32_t count;
+  float sumMs;
+  float maxMs;
+
+  void add(float ms) {
+    count++;
+    sumMs += ms;
+    if (ms > maxMs) maxMs = ms;
+  }
+  float mean() const { return count ? sumMs / count : 0.0f; }
+};
+
+/**
+ * @brief Measurements accumulated across wakes, reset after each upload report
+ */
+struct DutyCycleStats {
+  DutyTiming wakeLatency;      // Planned wake time -> sample taken
+  DutyTiming awake;            // Wake -> back to sleep, sampling-only wakes
+  DutyTiming upload;           // Radio-on time of upload wakes
+  float energyMj;              // Modelled energy since the last report
+  uint32_t samples;            // Samples taken since the last report
+  uint32_t uploads;
+  uint32_t uploadFailures;
+  uint32_t overwritten;        // Oldest samples lost to a full buffer
+};
+
+struct DutyCycleState {
+  uint32_t magic;
+  uint32_t wakeCount;
+  int64_t baseMs;                 // Time reference of the buffered samples
+  int64_t sleepStartUs;           // Clock when we went to sleep (0 = cold boot)
+  int64_t statsStartUs;           // Clock when stats were last reported
+  uint32_t plannedSleepUs;
+  uint8_t head;                   // Oldest buffered sample
+  uint8_t count;
+  uint16_t chunkIndex;            // ML chunk claimed for an upload that hasn't landed yet (0 = none)
+  DutySample samples[DUTY_CYCLE_CAPACITY];
+  DutyCycleStats stats;
+};
+
+/**
+ * @brief Start from scratch (cold boot or layout change)
+ */
+void dutyCycleReset(DutyCycleState &state);
+
+/**
+ * @brief True if the state survived a deep sleep intact
+ */
+bool dutyCycleValid(const DutyCycleState &state);
+
+/**
+ * @brief Latency from the planned wake time to now, -1 on the first wake
+ */
+int64_t dutyCycleWakeLatencyUs(const DutyCycleState &state, int64_t nowUs);
+
+/**
+ * @brief Buffer one sample; overwrites the oldest one when full
+ */
+void dutyCyclePush(DutyCycleState &state, const SensorSample &sample, uint8_t mask, int64_t timeMs);
+
+/**
+ * @brief Buffered sample i (0 = oldest) back in SensorSample form
+ * @return the sample's mask; timeMs receives its timestamp
+ */
+uint8_t dutyCycleSample(const DutyCycleState &state, uint8_t i, SensorSample &sample, int64_t &timeMs);
+
+/**
+ * @brief Drop the n oldest samples (after they were uploaded)
+ */
+void dutyCycleConsume(DutyCycleState &state, uint8_t n);
+
+/**
+ * @brief Shift buffered timestamps after the clock was stepped (e.g. first NTP fix)
+ */
+void dutyCycleClockStepped(DutyCycleState &state, int64_t deltaMs);
+
+/**
+ * @brief True if this wake should bring up the radio
+ */
+bool dutyCycleUploadDue(const DutyCycleState &state, const DutyCycleConfig &config);
+
+/**
+ * @brief Sleep that keeps wakes on the period grid
+ * @param awakeUs time spent awake in this wake, including boot
+ */
+uint64_t dutyCycleSleepUs(const DutyCycleConfig &config, uint64_t awakeUs);
+
+/**
+ * @brief Modelled energy of one wake plus the sleep that follows, in mJ
+ */
+float dutyCycleEnergyMj(const DutyEnergyModel &model, float activeMs, float radioMs, float sleepMs);
@@ -0,0 +1,112 @@
+#include "GprsBatch.h"
+
+#include <string.h>
+
+
+uint16_t gprsCrc16(const uint8_t* data, size_t length) {
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < length; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+  return crc;
+}
+
+
+void GprsBatch::push(const SensorSample &sample, uint8_t mask, int64_t timeMs) {
+  if (count_ == 0) {
+    baseMs_ = timeMs;
+  }
+  if (count_ == GPRS_BATCH_CAPACITY) {
+    // Full: drop the oldest and rebase on the new first sample
+    uint32_t shift = samples_[1].offsetMs;
+    memmove(&samples_[0], &samples_[1], (GPRS_BATCH_CAPACITY - 1) * sizeof(DutySample));
+    for (uint8_t i = 0; i < GPRS_BATCH_CAPACITY - 1; i++) {
+      samples_[i].offsetMs = samples_[i].offsetMs > shift ? samples_[i].offsetMs - shift : 0;
+    }
+    baseMs_ += shift;
+    count_--;
+    dropped_++;
+  }
+  int64_t offset = timeMs - baseMs_;
+  dutySamplePack(sample, mask, offset < 0 ? 0 : (uint32_t)offset, samples_[count_++]);
+}
+
+
+static uint8_t* putU16(uint8_t* p, uint16_t v) { p[0] = v; p[1] = v >> 8; return p + 2; }
+static uint8_t* putU32(uint8_t* p, uint32_t v) { p = putU16(p, v); return putU16(p, v >> 16); }
+static uint16_t getU16(const uint8_t* p) { return p[0] | (p[1] << 8); }
+static uint32_t getU32(const uint8_t* p) { return getU16(p) | ((uint32_t)getU16(p + 2) << 16); }
+
+
+size_t GprsBatch::encode(const char* deviceId, uint8_t* out, size_t capacity) const {
+  size_t idLength = strlen(deviceId);
+  if (idLength > GPRS_DEVICE_ID_MAX) {
+    idLength = GPRS_DEVICE_ID_MAX;
+  }
+  size_t length = 3 + 1 + 1 + idLength + 8 + 1 + count_ * GPRS_SAMPLE_BYTES + 2;
+  if (count_ == 0 || length > capacity) {
+    return 0;
+  }
+
+  uint8_t* p = out;
+  memcpy(p, "VSB", 3); p += 3;
+  *p++ = GPRS_BATCH_VERSION;
+  *p++ = (uint8_t)idLength;
+  memcpy(p, deviceId, idLength); p += idLength;
+  p = putU32(p, (uint32_t)baseMs_);
+  p = putU32(p, (uint32_t)((uint64_t)baseMs_ >> 32));
+  *p++ = count_;
+  for (uint8_t i = 0; i < count_; i++) {
+    const DutySample &s = samples_[i];
+    p = putU32(p, s.offsetMs);
+    for (int f = 0; f < WF_COUNT; f++) p = putU16(p, s.value[f]);
+    *p++ = s.mask;
+    *p++ = 0;
+  }
+  p = putU16(p, gprsCrc16(out, p - out));
+  return p - out;
+}
+
+
+int gprsBatchParse(const uint8_t* data, size_t length, GprsBatchFrame &frame) {
+  if (length < 5) {
+    return 0;
+  }
+  if (memcmp(data, "VSB", 3) != 0 || data[3] != GPRS_BATCH_VERSION || data[4] > GPRS_DEVICE_ID_MAX) {
+    return -1;
+  }
+  size_t idLength = data[4];
+  size_t header = 5 + idLength + 8 + 1;
+  if (length < header) {
+    return 0;
+  }
+  uint8_t count = data[header - 1];
+  if (count > GPRS_BATCH_CAPACITY) {
+    return -1;
+  }
+  size_t total = header + count * GPRS_SAMPLE_BYTES + 2;
+  if (length < total) {
+    return 0;
+  }
+  if (gprsCrc16(data, total - 2) != getU16(data + total - 2)) {
+    return -1;
+  }
+
+  memcpy(frame.deviceId, data + 5, idLength);
+  frame.deviceId[idLength] = '\0';
+  const uint8_t* p = data + 5 + idLength;
+  frame.baseMs = (int64_t)((uint64_t)getU32(p) | ((uint64_t)getU32(p + 4) << 32));
+  frame.count = count;
+  p = data + header;
+  for (uint8_t i = 0; i < count; i++, p += GPRS_SAMPLE_BYTES) {
+    DutySample &s = frame.samples[i];
+    s.offsetMs = getU32(p);
+    for (int f = 0; f < WF_COUNT; f++) s.value[f] = (int16_t)getU16(p + 4 + 2 * f);
+    s.mask = p[4 + 2 * WF_COUNT];
+    s.reserved = p[5 + 2 * WF_COUNT];
+  }
+  return (int)total;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <DutyCycle.h>
+#include <Telemetry.h>
+
+/**
+ * Compact binary sample batch for the GPRS fallback uplink.
+ *
+ * Cellular data is slow and billed per byte, so while Wi-Fi is down the
+ * samples are packed with the same fixed-point DutySample layout the
+ * duty-cycle buffer uses and sent as one frame per TCP connection:
+ *
+ *   "VSB" | version u8 | idLength u8 | id[idLength] | baseMs i64 | count u8 |
+ *   count x sample | crc16 u16
+ *
+ *   sample: offsetMs u32 | value i16[WF_COUNT] | mask u8 | reserved u8
+ *
+ * value[] follows SENSOR_FIELDS order, each scaled by its fixedScale
+ * (INT16_MIN = no reading); adding a field there changes the sample size,
+ * so bump GPRS_BATCH_VERSION with it.
+ *
+ * All integers are little endian; the CRC is CRC-16/CCITT-FALSE over every
+ * preceding byte. tools/gprs_sim/tcp_sink decodes frames back to JSON.
+ */
+
+#define GPRS_BATCH_VERSION      2
+#define GPRS_BATCH_CAPACITY     32
+#define GPRS_SAMPLE_BYTES       DUTY_SAMPLE_BYTES
+#define GPRS_DEVICE_ID_MAX      32
+#define GPRS_BATCH_MAX_BYTES    (3 + 1 + 1 + GPRS_DEVICE_ID_MAX + 8 + 1 + GPRS_BATCH_CAPACITY * GPRS_SAMPLE_BYTES + 2)
+
+class GprsBatch {
+public:
+  GprsBatch() : baseMs_(0), count_(0), dropped_(0) {}
+
+  void clear() { count_ = 0; }
+  uint8_t size() const { return count_; }
+  uint32_t dropped() const { return dropped_; }
+
+  /**
+   * @brief Add a sample; drops the oldest one when the batch is full
+   */
+  void push(const SensorSample &sample, uint8_t mask, int64_t timeMs);
+
+  /**
+   * @brief Encode the batch as one frame
+   * @return frame length, 0 if empty or out is too small
+   */
+  size_t encode(const char* deviceId, uint8_t* out, size_t capacity) const;
+
+private:
+  int64_t baseMs_;
+  DutySample samples_[GPRS_BATCH_CAPACITY];
+  uint8_t count_;
+  uint32_t dropped_;
+};
+
+/**
+ * @brief One decoded frame
+ */
+struct GprsBatchFrame {
+  char deviceId[GPRS_DEVICE_ID_MAX + 1];
+  int64_t baseMs;
+  uint8_t count;
+  DutySample samples[GPRS_BATCH_CAPACITY];
+};
+
+/**
+ * @brief Parse a frame at the start of data
+ * @return frame length; 0 if more bytes are needed; -1 if the bytes are not a valid frame
+ */
+int gprsBatchParse(const uint8_t* data, size_t length, GprsBatchFrame &frame);
+
+uint16_t gprsCrc16(const uint8_t* data, size_t length);
@@ -0,0 +1,25 @@
+#include "LinkSelector.h"
+
+
+LinkSelector::LinkSelector(uint32_t failoverMs, uint32_t recoverMs)
+  : failoverMs_(failoverMs), recoverMs_(recoverMs), active_(LINK_WIFI),
+    wifiUp_(true), stableSinceMs_(0), switches_(0) {}
+
+
+bool LinkSelector::update(bool wifiUp, uint32_t nowMs) {
+  if (wifiUp != wifiUp_) {
+    wifiUp_ = wifiUp;
+    stableSinceMs_ = nowMs;
+  }
+  uint32_t stableMs = nowMs - stableSinceMs_;
+
+  if (active_ == LINK_WIFI && !wifiUp_ && stableMs >= failoverMs_) {
+    active_ = LINK_GPRS;
+  } else if (active_ == LINK_GPRS && wifiUp_ && stableMs >= recoverMs_) {
+    active_ = LINK_WIFI;
+  } else {
+    return false;
+  }
+  switches_++;
+  return true;
+}
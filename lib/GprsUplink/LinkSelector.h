@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * Chooses between Wi-Fi and the GPRS fallback.
+ *
+ * Wi-Fi has to be down continuously for failoverMs before traffic moves to
+ * GPRS, and back up continuously for recoverMs before it moves back, so a
+ * flapping access point does not bounce the modem bearer up and down.
+ */
+
+enum UplinkLink {
+  LINK_WIFI,
+  LINK_GPRS
+};
+
+static const char* const UPLINK_LINK_NAMES[] = { "wifi", "gprs" };
+
+class LinkSelector {
+public:
+  LinkSelector(uint32_t failoverMs, uint32_t recoverMs);
+
+  /**
+   * @brief Feed the current Wi-Fi state
+   * @return true if the active link changed on this call
+   */
+  bool update(bool wifiUp, uint32_t nowMs);
+
+  UplinkLink active() const { return active_; }
+  uint32_t switches() const { return switches_; }
+
+private:
+  uint32_t failoverMs_;
+  uint32_t recoverMs_;
+  UplinkLink active_;
+  bool wifiUp_;
+  uint32_t stableSinceMs_;    // When wifiUp_ last changed
+  uint32_t switches_;
+};
@@ -0,0 +1,123 @@
+#include "RuntimeConfig.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/**
+ * @brief Copy value into out without surrounding quotes and whitespace
+ */
+static bool unquote(const char* value, char* out, size_t capacity) {
+  while (isspace((unsigned char)*value)) value++;
+  size_t length = strlen(value);
+  while (length > 0 && isspace((unsigned char)value[length - 1])) length--;
+  if (length >= 2 && value[0] == '"' && value[length - 1] == '"') {
+    value++;
+    length -= 2;
+  }
+  if (length >= capacity) {
+    return false;
+  }
+  memcpy(out, value, length);
+  out[length] = '\0';
+  return true;
+}
+
+
+static bool inRange(uint32_t value, uint32_t min, uint32_t max) {
+  return value >= min && value <= max;
+}
+
+
+static RuntimeConfigResult parseUnsigned(const char* value, uint32_t min, uint32_t max, uint32_t &out) {
+  char text[16];
+  if (!unquote(value, text, sizeof(text)) || !isdigit((unsigned char)text[0])) {
+    return CONFIG_BAD_VALUE;
+  }
+  // strtoull, not strtoul: unsigned long is 32 bits on the ESP32 and would
+  // saturate e.g. 4294967296 to 0xFFFFFFFF instead of failing the range check.
+  // unquote() caps the text at 15 digits, which always fits 64 bits.
+  char* end;
+  unsigned long long number = strtoull(text, &end, 10);
+  if (*end != '\0') {
+    return CONFIG_BAD_VALUE;
+  }
+  if (number > 0xFFFFFFFFULL || !inRange((uint32_t)number, min, max)) {
+    return CONFIG_OUT_OF_RANGE;
+  }
+  out = (uint32_t)number;
+  return CONFIG_OK;
+}
+
+
+RuntimeConfigResult runtimeConfigSet(RuntimeConfig &config, const char* key, const char* value) {
+  if (!strcmp(key, "version")) {
+    return parseUnsigned(value, 1, 0xFFFFFFFF, config.version);
+  }
+
+#define RUNTIME_CONFIG_SET(name, member, min, max) \
+  if (!strcmp(key, name)) { \
+    return parseUnsigned(value, min, max, config.member); \
+  }
+  RUNTIME_CONFIG_FIELDS(RUNTIME_CONFIG_SET)
+#undef RUNTIME_CONFIG_SET
+
+  if (!strcmp(key, "target_phone")) {
+    char phone[RUNTIME_CONFIG_PHONE_MAX + 1];
+    if (!unquote(value, phone, sizeof(phone))) {
+      return CONFIG_BAD_VALUE;
+    }
+    // '+' then digits only: the number is pasted into an AT command
+    size_t digits = 0;
+    for (const char* p = phone[0] == '+' ? phone + 1 : phone; *p; p++, digits++) {
+      if (!isdigit((unsigned char)*p)) {
+        return CONFIG_BAD_VALUE;
+      }
+    }
+    if (digits < 3) {
+      return CONFIG_BAD_VALUE;
+    }
+    strcpy(config.targetPhone, phone);
+    return CONFIG_OK;
+  }
+  return CONFIG_UNKNOWN_KEY;
+}
+
+
+RuntimeConfigResult runtimeConfigValidate(const RuntimeConfig &config) {
+  if (config.version == 0) {
+    return CONFIG_NO_VERSION;
+  }
+  // Ranges again: a blob read back from NVS never went through runtimeConfigSet
+#define RUNTIME_CONFIG_RANGE(name, member, min, max) \
+  if (!inRange(config.member, min, max)) { \
+    return CONFIG_OUT_OF_RANGE; \
+  }
+  RUNTIME_CONFIG_FIELDS(RUNTIME_CONFIG_RANGE)
+#undef RUNTIME_CONFIG_RANGE
+  if (config.targetPhone[0] == '\0' || memchr(config.targetPhone, '\0', sizeof(config.targetPhone)) == NULL) {
+    return CONFIG_BAD_VALUE;
+  }
+  return CONFIG_OK;
+}
+
+
+size_t runtimeConfigToJson(const RuntimeConfig &config, char* out, size_t capacity) {
+  size_t length = 0;
+#define APPEND(...) \
+  do { \
+    int n = snprintf(out + length, length < capacity ? capacity - length : 0, __VA_ARGS__); \
+    length += n > 0 ? n : 0; \
+  } while (0)
+
+  APPEND("{\"version\":%lu", (unsigned long)config.version);
+#define RUNTIME_CONFIG_JSON(name, member, min, max) APPEND(",\"" name "\":%lu", (unsigned long)config.member);
+  RUNTIME_CONFIG_FIELDS(RUNTIME_CONFIG_JSON)
+#undef RUNTIME_CONFIG_JSON
+  APPEND(",\"target_phone\":\"%s\"}", config.targetPhone);
+#undef APPEND
+
+  return length < capacity ? length : capacity - 1;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Settings that can be retuned in the field without a reflash.
+ *
+ * The source of truth is a flat, versioned document at <USER>/Config:
+ *
+ *   { "version": 4, "live_period_ms": 10000, "target_phone": "+94770000000", ... }
+ *
+ * Keys left out take their built-in defaults, so the document always
+ * describes the complete configuration. A document is parsed into a
+ * candidate copy key by key (runtimeConfigSet) and checked as a whole
+ * (runtimeConfigValidate); the live configuration is only replaced once
+ * the whole candidate passed. Only documents with a higher version than the
+ * active one are applied.
+ *
+ * The struct is also the NVS cache blob, so bump RUNTIME_CONFIG_SCHEMA
+ * whenever a field is added, removed or reordered.
+ */
+
+#define RUNTIME_CONFIG_SCHEMA     2
+#define RUNTIME_CONFIG_PHONE_MAX  16    // E.164: '+' and up to 15 digits
+
+struct RuntimeConfig {
+  uint32_t version;           // Document version (0 = built-in defaults)
+  uint32_t sensorPeriodMs;    // Sensor task acquisition cycle
+  uint32_t livePeriodMs;      // Live Sensor_Data uploads
+  uint32_t mlPeriodMs;        // ML record / batch sample
+  uint32_t actionPollMs;      // Actions/action_n polling
+  uint32_t metricsPeriodMs;   // Uplink_Metrics and time sync reports
+  uint32_t configPollMs;      // Check <USER>/Config/version
+  uint32_t maxMlRecords;      // ML_Training_Data rotation size
+  uint32_t smsRetries;        // Re-sends of a failed SMS alert
+  uint32_t traceLogLevel;     // TraceLogLevel
+  uint32_t anomalyZTenths;    // Burst trigger: anomaly z-score * 10
+  uint32_t burstMs;           // Burst length after the last anomaly
+  uint32_t burstSensorPeriodMs; // Acquisition cycle while a burst runs
+  char targetPhone[RUNTIME_CONFIG_PHONE_MAX + 1];
+};
+
+// Numeric fields: X(key, member, min, max)
+#define RUNTIME_CONFIG_FIELDS(X) \
+  X("sensor_period_ms",  sensorPeriodMs,  500,  600000) \
+  X("live_period_ms",    livePeriodMs,    1000, 3600000) \
+  X("ml_period_ms",      mlPeriodMs,      1000, 3600000) \
+  X("action_poll_ms",    actionPollMs,    1000, 600000) \
+  X("metrics_period_ms", metricsPeriodMs, 10000, 86400000) \
+  X("config_poll_ms",    configPollMs,    5000, 86400000) \
+  X("max_ml_records",    maxMlRecords,    1,    10000) \
+  X("sms_retries",       smsRetries,      0,    5) \
+  X("trace_log_level",   traceLogLevel,   0,    3) \
+  X("anomaly_z_tenths",  anomalyZTenths,  20,   200) \
+  X("burst_ms",          burstMs,         5000, 600000) \
+  X("burst_sensor_period_ms", burstSensorPeriodMs, 500, 600000)
+
+enum RuntimeConfigResult {
+  CONFIG_OK,
+  CONFIG_UNKNOWN_KEY,
+  CONFIG_BAD_VALUE,       // Not a number / not a phone number
+  CONFIG_OUT_OF_RANGE,
+  CONFIG_NO_VERSION,      // Document without a positive "version"
+  CONFIG_RESULT_COUNT
+};
+
+static const char* const RUNTIME_CONFIG_RESULT_NAMES[CONFIG_RESULT_COUNT] = {
+  "ok", "unknown_key", "bad_value", "out_of_range", "no_version"
+};
+
+/**
+ * @brief Set one document key on a candidate config
+ * @param value the JSON value as text; quotes around strings are optional
+ */
+RuntimeConfigResult runtimeConfigSet(RuntimeConfig &config, const char* key, const char* value);
+
+/**
+ * @brief Whole-config checks: a version, every field in range, a phone number
+ * Run on a candidate after every key has been set, and on a blob read back from NVS.
+ */
+RuntimeConfigResult runtimeConfigValidate(const RuntimeConfig &config);
+
+/**
+ * @brief Write the config as a flat JSON document (the <USER>/Config format)
+ * @return length written, excluding the terminator (truncated if capacity is too small)
+ */
+size_t runtimeConfigToJson(const RuntimeConfig &config, char* out, size_t capacity);
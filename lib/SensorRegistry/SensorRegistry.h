@@ -0,0 +1,90 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <Telemetry.h>
+
+/**
+ * Compile-time list of sensor drivers.
+ *
+ * A driver is a struct with static members only:
+ *
+ *   struct Aht10Driver {
+ *     static const LiveNode NODE = LIVE_AHT10;  // Which sensor; its fields are in SENSOR_FIELDS
+ *     static const bool FITTED = true;
+ *     static bool begin();                      // Probe and configure; false = not responding
+ *     static bool read(SensorSample &s);        // Fill the sensor's fields of s
+ *   };
+ *
+ * SensorRegistry<Drivers...> unrolls the per-sensor loops (probe, read,
+ * status) over that list at compile time, in list order. A sensor left out
+ * of a build is listed as NotFitted<NODE>: its functions are empty, so the
+ * sensor's library is never referenced and nothing probes it at boot.
+ * Everything a sensor uploads comes from its SENSOR_FIELDS entries, so a
+ * driver only deals with the hardware.
+ */
+
+template <LiveNode Node>
+struct NotFitted {
+  static const LiveNode NODE = Node;
+  static const bool FITTED = false;
+  static bool begin() { return false; }
+  static bool read(SensorSample &) { return false; }
+};
+
+template <typename... Drivers>
+struct SensorRegistry;
+
+template <>
+struct SensorRegistry<> {
+  static constexpr uint8_t fittedMask() { return 0; }
+  static uint8_t begin(uint8_t) { return 0; }
+  static uint8_t read(uint8_t, SensorSample &) { return 0; }
+};
+
+template <typename Driver, typename... Rest>
+struct SensorRegistry<Driver, Rest...> {
+  static_assert(((Driver::FITTED ? 1 << Driver::NODE : 0) & SensorRegistry<Rest...>::fittedMask()) == 0,
+                "sensor listed twice");
+
+  /**
+   * @brief SensorBit mask of the sensors compiled into this build
+   */
+  static constexpr uint8_t fittedMask() {
+    return (uint8_t)((Driver::FITTED ? 1 << Driver::NODE : 0) | SensorRegistry<Rest...>::fittedMask());
+  }
+
+  /**
+   * @brief Probe every fitted sensor in allowed
+   * @return SensorBit mask of the sensors that answered
+   */
+  static uint8_t begin(uint8_t allowed) {
+    uint8_t ok = 0;
+    if (Driver::FITTED && (allowed & (1 << Driver::NODE)) && Driver::begin()) {
+      ok = (uint8_t)(1 << Driver::NODE);
+    }
+    return ok | SensorRegistry<Rest...>::begin(allowed);
+  }
+
+  /**
+   * @brief Read every sensor in working into s
+   * @return SensorBit mask of the sensors whose read succeeded
+   */
+  static uint8_t read(uint8_t working, SensorSample &s) {
+    uint8_t ok = 0;
+    if (Driver::FITTED && (working & (1 << Driver::NODE)) && Driver::read(s)) {
+      ok = (uint8_t)(1 << Driver::NODE);
+    }
+    return ok | SensorRegistry<Rest...>::read(working, s);
+  }
+};
+
+/**
+ * @brief <USER>/Sensor_Status text of one sensor
+ */
+inline const char* sensorStatusText(uint8_t fittedMask, uint8_t workingMask, int node) {
+  if (!(fittedMask & (1 << node))) {
+    return "Not Fitted";
+  }
+  return (workingMask & (1 << node)) ? "Working" : "Not Working";
+}
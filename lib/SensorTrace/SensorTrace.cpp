@@ -0,0 +1,146 @@
+#include "SensorTrace.h"
+
+#include <string.h>
+
+static_assert(sensorMaxFieldCount() == TRACE_MAX_VALUES, "TRACE_MAX_VALUES must match the largest sensor in SENSOR_FIELDS");
+
+
+uint8_t traceValueCount(uint8_t sensor) {
+  return sensor < TRACE_SENSOR_COUNT ? sensorFieldCount(sensor) : 0;
+}
+
+
+/**
+ * @brief Integer readings travel as uint16, everything else as raw float bits
+ */
+static bool traceValueIsInteger(uint8_t sensor, int i) {
+  return SENSOR_FIELDS[sensorFirstField(sensor) + i].decimals == 0;
+}
+
+
+size_t traceWriteHeader(uint8_t* out) {
+  out[0] = TRACE_MAGIC_0;
+  out[1] = TRACE_MAGIC_1;
+  out[2] = TRACE_MAGIC_2;
+  out[3] = TRACE_VERSION;
+  out[4] = out[5] = out[6] = out[7] = 0;
+  return TRACE_HEADER_SIZE;
+}
+
+
+size_t traceEncode(uint8_t* out, size_t capacity, uint64_t &lastUs,
+                   uint8_t sensor, uint64_t timeUs, const float* values) {
+  uint8_t count = traceValueCount(sensor);
+  if (count == 0) {
+    return 0;
+  }
+
+  uint8_t record[TRACE_MAX_RECORD];
+  size_t length = 0;
+  record[length++] = sensor;
+
+  // Time delta as an unsigned LEB128 varint (1-3 bytes at normal sample rates)
+  uint64_t delta = (timeUs >= lastUs) ? timeUs - lastUs : 0;
+  do {
+    uint8_t byte = delta & 0x7F;
+    delta >>= 7;
+    record[length++] = byte | (delta ? 0x80 : 0);
+  } while (delta);
+
+  for (int i = 0; i < count; i++) {
+    if (traceValueIsInteger(sensor, i)) {
+      uint16_t v = (uint16_t)values[i];
+      record[length++] = v & 0xFF;
+      record[length++] = v >> 8;
+    } else {
+      uint32_t bits;
+      memcpy(&bits, &values[i], sizeof(bits));
+      record[length++] = bits & 0xFF;
+      record[length++] = (bits >> 8) & 0xFF;
+      record[length++] = (bits >> 16) & 0xFF;
+      record[length++] = bits >> 24;
+    }
+  }
+
+  if (length > capacity) {
+    return 0;
+  }
+  memcpy(out, record, length);
+  lastUs = timeUs;
+  return length;
+}
+
+
+TraceReader::TraceReader(const uint8_t* data, size_t length)
+  : data_(data), length_(length), offset_(TRACE_HEADER_SIZE), timeUs_(0), valid_(false) {
+  valid_ = length >= TRACE_HEADER_SIZE &&
+           data[0] == TRACE_MAGIC_0 && data[1] == TRACE_MAGIC_1 &&
+           data[2] == TRACE_MAGIC_2 && data[3] == TRACE_VERSION;
+}
+
+
+bool TraceReader::next(TraceEvent &event) {
+  if (!valid_ || offset_ >= length_) {
+    return false;
+  }
+
+  size_t pos = offset_;
+  uint8_t sensor = data_[pos++];
+  uint8_t count = traceValueCount(sensor);
+  if (count == 0) {
+    valid_ = false;   // Corrupt stream - stop rather than misinterpret the rest
+    return false;
+  }
+
+  uint64_t delta = 0;
+  int shift = 0;
+  for (;;) {
+    if (pos >= length_ || shift > 63) {
+      return false;
+    }
+    uint8_t byte = data_[pos++];
+    delta |= (uint64_t)(byte & 0x7F) << shift;
+    shift += 7;
+    if (!(byte & 0x80)) {
+      break;
+    }
+  }
+
+  size_t payload = 0;
+  for (int i = 0; i < count; i++) {
+    payload += traceValueIsInteger(sensor, i) ? 2u : 4u;
+  }
+  if (pos + payload > length_) {
+    return false;   // Truncated tail (e.g. power lost mid-write)
+  }
+
+  for (int i = 0; i < count; i++) {
+    if (traceValueIsInteger(sensor, i)) {
+      event.values[i] = (float)(uint16_t)(data_[pos] | (data_[pos + 1] << 8));
+      pos += 2;
+    } else {
+      uint32_t bits = (uint32_t)data_[pos] | ((uint32_t)data_[pos + 1] << 8) |
+                      ((uint32_t)data_[pos + 2] << 16) | ((uint32_t)data_[pos + 3] << 24);
+      memcpy(&event.values[i], &bits, sizeof(bits));
+      pos += 4;
+    }
+  }
+
+  timeUs_ += delta;
+  event.timeUs = timeUs_;
+  event.sensor = sensor;
+  offset_ = pos;
+  return true;
+}
+
+
+void traceApply(const TraceEvent &event, SensorSample &sample, WindowStats* window) {
+  uint8_t count = traceValueCount(event.sensor);
+  int first = sensorFirstField(event.sensor);
+  for (int i = 0; i < count; i++) {
+    setSampleField(sample, first + i, event.values[i]);
+    if (window) {
+      window[first + i].add(event.values[i]);
+    }
+  }
+}
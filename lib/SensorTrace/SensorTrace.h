@@ -0,0 +1,94 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <Telemetry.h>
+
+/**
+ * Compact binary trace of raw sensor readings.
+ *
+ * File layout: 8-byte header ("VST" magic, version, 4 reserved bytes)
+ * followed by records of
+ *   [sensor id : 1 byte][time delta since previous record : LEB128 varint, us]
+ *   [payload   : fixed per sensor, little-endian]
+ * A sensor's payload is its SENSOR_FIELDS entries in table order: the exact
+ * float bits read from the driver, or a uint16 for integer readings
+ * (decimals 0, e.g. SGP30), so a replay reproduces the acquisition input
+ * bit for bit. Adding a field changes the layout: bump TRACE_VERSION.
+ */
+
+#define TRACE_MAGIC_0   'V'
+#define TRACE_MAGIC_1   'S'
+#define TRACE_MAGIC_2   'T'
+#define TRACE_VERSION   1
+#define TRACE_HEADER_SIZE 8
+
+#define TRACE_MAX_VALUES   7    // Most fields of one sensor (MPU6050); checked against SENSOR_FIELDS
+#define TRACE_MAX_RECORD   (1 + 10 + TRACE_MAX_VALUES * 4)
+
+// Same ids as LiveNode; the values are that sensor's SENSOR_FIELDS entries
+enum TraceSensor {
+  TRACE_AHT10 = LIVE_AHT10,
+  TRACE_MLX90614 = LIVE_MLX90614,
+  TRACE_MPU6050 = LIVE_MPU6050,
+  TRACE_SGP30 = LIVE_SGP30,
+  TRACE_SENSOR_COUNT = LIVE_NODE_COUNT
+};
+
+/**
+ * @brief One decoded trace record
+ */
+struct TraceEvent {
+  uint64_t timeUs;                  // Absolute time since the trace started
+  uint8_t sensor;                   // TraceSensor
+  float values[TRACE_MAX_VALUES];
+};
+
+/**
+ * @brief Number of values carried by a sensor's record (its SENSOR_FIELDS count, 0 if unknown)
+ */
+uint8_t traceValueCount(uint8_t sensor);
+
+/**
+ * @brief Write the file header
+ * @return bytes written (TRACE_HEADER_SIZE)
+ */
+size_t traceWriteHeader(uint8_t* out);
+
+/**
+ * @brief Encode one record
+ * @param lastUs timestamp of the previous record; updated on success
+ * @return bytes written, 0 if the record does not fit in capacity
+ */
+size_t traceEncode(uint8_t* out, size_t capacity, uint64_t &lastUs,
+                   uint8_t sensor, uint64_t timeUs, const float* values);
+
+/**
+ * @brief Sequential decoder over an in-memory trace
+ */
+class TraceReader {
+public:
+  TraceReader(const uint8_t* data, size_t length);
+
+  bool valid() const { return valid_; }
+
+  /**
+   * @brief Decode the next record
+   * @return false at end of trace or on a truncated/corrupt record
+   */
+  bool next(TraceEvent &event);
+
+private:
+  const uint8_t* data_;
+  size_t length_;
+  size_t offset_;
+  uint64_t timeUs_;
+  bool valid_;
+};
+
+/**
+ * @brief Apply a decoded event to the acquisition state, as the read functions do
+ * @param window per-field accumulators to fold the readings into (may be NULL)
+ */
+void traceApply(const TraceEvent &event, SensorSample &sample, WindowStats* window);
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Byte transport and clock under the SIM800 AT driver.
+ *
+ * On the device this is the UART wired to the modem (StreamModemPort); on
+ * a Linux host it is a pseudo-terminal opened on tools/gprs_sim/modem_sim,
+ * so the same driver code can be exercised without hardware.
+ */
+class ModemPort {
+public:
+  virtual ~ModemPort() {}
+
+  virtual int available() = 0;
+  virtual int read() = 0;                               // -1 when nothing is pending
+  virtual size_t write(const uint8_t* data, size_t length) = 0;
+  virtual uint32_t millis() = 0;
+  virtual void idle() {}                                // Called while waiting for a reply
+
+  size_t print(const char* text) { return write((const uint8_t*)text, strlen(text)); }
+};
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+
+/**
+ * @brief ModemPort over an Arduino Stream (HardwareSerial)
+ */
+class StreamModemPort : public ModemPort {
+public:
+  explicit StreamModemPort(Stream &stream) : stream_(stream) {}
+
+  int available() override { return stream_.available(); }
+  int read() override { return stream_.read(); }
+  size_t write(const uint8_t* data, size_t length) override { return stream_.write(data, length); }
+  uint32_t millis() override { return ::millis(); }
+  void idle() override { delay(1); }   // Let other tasks on this core run
+
+private:
+  Stream &stream_;
+};
+#endif
@@ -0,0 +1,160 @@
+#include "Sim800.h"
+
+#include <stdio.h>
+#include <string.h>
+
+
+Sim800::Sim800(ModemPort &port) : port_(port), responseLength_(0), gprsUp_(false) {
+  response_[0] = '\0';
+}
+
+
+void Sim800::discardInput() {
+  while (port_.available()) {
+    port_.read();
+  }
+  responseLength_ = 0;
+  response_[0] = '\0';
+}
+
+
+void Sim800::append(char c) {
+  if (c == '\0') {
+    return;   // Line noise; would end the string early
+  }
+  if (responseLength_ + 1 >= sizeof(response_)) {
+    // Keep the newer half so a reply after a burst of URCs can still match
+    size_t keep = sizeof(response_) / 2;
+    memmove(response_, response_ + responseLength_ - keep, keep);
+    responseLength_ = keep;
+  }
+  response_[responseLength_++] = c;
+  response_[responseLength_] = '\0';
+}
+
+
+bool Sim800::waitFor(const char* expect, uint32_t timeoutMs, const char* failure) {
+  uint32_t start = port_.millis();
+  while (port_.millis() - start < timeoutMs) {
+    bool received = false;
+    while (port_.available()) {
+      int c = port_.read();
+      if (c < 0) {
+        break;
+      }
+      append((char)c);
+      received = true;
+    }
+    if (received) {
+      if (strstr(response_, expect)) {
+        return true;
+      }
+      if (strstr(response_, "ERROR") || (failure && strstr(response_, failure))) {
+        return false;
+      }
+    } else {
+      port_.idle();
+    }
+  }
+  return false;
+}
+
+
+bool Sim800::command(const char* line, const char* expect, uint32_t timeoutMs, const char* failure) {
+  discardInput();
+  port_.print(line);
+  port_.print("\r\n");
+  return waitFor(expect, timeoutMs, failure);
+}
+
+
+bool Sim800::begin() {
+  // A few tries: the first AT after power-up also syncs the modem's auto-baud
+  bool alive = false;
+  for (int attempt = 0; attempt < 3 && !alive; attempt++) {
+    alive = command("AT", "OK", SIM800_COMMAND_MS);
+  }
+  if (!alive) {
+    return false;
+  }
+  command("ATE0", "OK", SIM800_COMMAND_MS);   // Echo off keeps replies short
+  return command("AT+CMGF=1", "OK", SIM800_COMMAND_MS);
+}
+
+
+bool Sim800::sendSms(const char* number, const char* text) {
+  char line[48];
+  snprintf(line, sizeof(line), "AT+CMGS=\"%s\"", number);
+  if (!command(line, SIM800_PROMPT, SIM800_COMMAND_MS)) {
+    return false;
+  }
+  port_.print(text);
+  const uint8_t ctrlZ = 26;
+  port_.write(&ctrlZ, 1);
+  return waitFor("+CMGS:", SIM800_SMS_MS);
+}
+
+
+bool Sim800::gprsAttach(const char* apn) {
+  if (gprsUp_) {
+    return true;
+  }
+  command("AT+CIPSHUT", "SHUT OK", SIM800_COMMAND_MS);   // Clear any half-open context
+  if (!command("AT+CGATT?", "+CGATT: 1", SIM800_COMMAND_MS)) {
+    return false;   // Not attached to the packet domain (no coverage / no data plan)
+  }
+  if (!command("AT+CIPMUX=0", "OK", SIM800_COMMAND_MS)) {
+    return false;
+  }
+  char line[80];
+  snprintf(line, sizeof(line), "AT+CSTT=\"%s\"", apn);
+  if (!command(line, "OK", SIM800_COMMAND_MS)) {
+    return false;
+  }
+  if (!command("AT+CIICR", "OK", SIM800_BEARER_MS)) {
+    return false;
+  }
+  // AT+CIFSR answers with the bare IP address and no OK
+  if (!command("AT+CIFSR", ".", SIM800_COMMAND_MS)) {
+    return false;
+  }
+  gprsUp_ = true;
+  return true;
+}
+
+
+void Sim800::gprsDetach() {
+  command("AT+CIPSHUT", "SHUT OK", SIM800_COMMAND_MS);
+  gprsUp_ = false;
+}
+
+
+bool Sim800::tcpSend(const char* host, uint16_t port, const uint8_t* data, size_t length) {
+  if (!gprsUp_ || length == 0 || length > SIM800_MAX_SEND_BYTES) {
+    return false;
+  }
+
+  char line[96];
+  snprintf(line, sizeof(line), "AT+CIPSTART=\"TCP\",\"%s\",%u", host, (unsigned)port);
+  if (!command(line, "CONNECT OK", SIM800_CONNECT_MS, "CONNECT FAIL")) {
+    // A leftover connection answers "ERROR" then "ALREADY CONNECT"; it can still be used.
+    // Both lines usually arrive together and command() has already buffered them.
+    if (!strstr(response_, "ALREADY CONNECT") && !waitFor("ALREADY CONNECT", 200)) {
+      gprsDetach();
+      return false;
+    }
+  }
+
+  snprintf(line, sizeof(line), "AT+CIPSEND=%u", (unsigned)length);
+  bool sent = command(line, SIM800_PROMPT, SIM800_COMMAND_MS);
+  if (sent) {
+    port_.write(data, length);
+    sent = waitFor("SEND OK", SIM800_SEND_MS, "SEND FAIL");
+  }
+
+  command("AT+CIPCLOSE", "CLOSE OK", SIM800_COMMAND_MS);
+  if (!sent) {
+    gprsDetach();
+  }
+  return sent;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ModemPort.h"
+
+/**
+ * AT command driver for the SIM800A: SMS plus a single GPRS TCP session.
+ *
+ * All calls block until the modem answers or the step's timeout expires,
+ * so they belong on the uplink task. Replies are matched against a
+ * bounded buffer; "ERROR" (and step-specific failures such as
+ * "CONNECT FAIL") end a wait early. lastResponse() holds the reply of
+ * the last command for logging.
+ *
+ * GPRS sequence (single connection mode):
+ *   AT+CIPSHUT, AT+CIPMUX=0, AT+CSTT="apn", AT+CIICR, AT+CIFSR     (bearer)
+ *   AT+CIPSTART="TCP","host",port -> CONNECT OK
+ *   AT+CIPSEND=<n> -> "> " -> <n bytes> -> SEND OK
+ *   AT+CIPCLOSE, and AT+CIPSHUT to drop the bearer
+ */
+
+#define SIM800_RESPONSE_BYTES   256
+#define SIM800_COMMAND_MS       2000
+#define SIM800_SMS_MS           10000   // +CMGS confirmation can take a while
+#define SIM800_BEARER_MS        30000   // AT+CIICR (spec allows up to 85 s)
+#define SIM800_CONNECT_MS       20000   // CONNECT OK after AT+CIPSTART
+#define SIM800_SEND_MS          15000   // SEND OK after the payload
+#define SIM800_MAX_SEND_BYTES   1360    // AT+CIPSEND limit per call in single connection mode
+#define SIM800_PROMPT           "\n> "   // Data prompt after AT+CMGS / AT+CIPSEND; a bare '>' in line noise must not match
+
+class Sim800 {
+public:
+  explicit Sim800(ModemPort &port);
+
+  /**
+   * @brief Check the modem answers and set echo off and SMS text mode
+   */
+  bool begin();
+
+  bool sendSms(const char* number, const char* text);
+
+  /**
+   * @brief Bring up the GPRS bearer (no-op if it is already up)
+   */
+  bool gprsAttach(const char* apn);
+
+  /**
+   * @brief Drop the bearer (AT+CIPSHUT)
+   */
+  void gprsDetach();
+
+  bool gprsUp() const { return gprsUp_; }
+
+  /**
+   * @brief Open a TCP connection, send the payload and close it
+   * A failure drops the bearer so the next attempt starts clean.
+   */
+  bool tcpSend(const char* host, uint16_t port, const uint8_t* data, size_t length);
+
+  /**
+   * @brief Send one command line and wait for expect
+   */
+  bool command(const char* line, const char* expect, uint32_t timeoutMs, const char* failure = NULL);
+
+  /**
+   * @brief Wait for expect in the modem output
+   * "ERROR", or the optional failure string, ends the wait early with false.
+   */
+  bool waitFor(const char* expect, uint32_t timeoutMs, const char* failure = NULL);
+
+  const char* lastResponse() const { return response_; }
+
+private:
+  ModemPort &port_;
+  char response_[SIM800_RESPONSE_BYTES];
+  size_t responseLength_;
+  bool gprsUp_;
+
+  void discardInput();
+  void append(char c);
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stddef.h>
+#include <string.h>
+
+/**
+ * @brief String with its storage inline, for globals that used Arduino String
+ *
+ * Capacity is fixed at build time, so assigning never touches the heap; a
+ * longer value is truncated (truncated() reports it). Compares against C
+ * strings, so "status == \"Working\"" style checks read as before.
+ */
+template <size_t Capacity>
+class FixedString {
+public:
+  FixedString() : truncated_(false) { text_[0] = '\0'; }
+  FixedString(const char* text) { assign(text); }
+
+  FixedString &operator=(const char* text) {
+    assign(text);
+    return *this;
+  }
+
+  void assign(const char* text) {
+    size_t length = text ? strlen(text) : 0;
+    truncated_ = length > Capacity;
+    if (truncated_) {
+      length = Capacity;
+    }
+    memcpy(text_, text ? text : "", length);
+    text_[length] = '\0';
+  }
+
+  const char* c_str() const { return text_; }
+  size_t length() const { return strlen(text_); }
+  bool truncated() const { return truncated_; }
+
+  bool operator==(const char* text) const { return strcmp(text_, text) == 0; }
+  bool operator!=(const char* text) const { return strcmp(text_, text) != 0; }
+
+private:
+  char text_[Capacity + 1];
+  bool truncated_;
+};
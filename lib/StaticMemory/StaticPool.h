@@ -0,0 +1,92 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Fixed pool of scratch objects reserved at build time.
+ *
+ * Per-job scratch (JSON documents, chunk text, encode batches) is leased
+ * from a pool instead of being constructed on the stack or the heap for
+ * every call, so a job's memory is part of the static plan and the pool
+ * objects keep their internal capacity between jobs. acquire() clears the
+ * object (T must have clear()) and returns NULL when every slot is in use;
+ * size the pool for the deepest nesting of leases in one job.
+ *
+ * Not thread-safe: give each pool a single owning task.
+ *
+ *   PoolLease<FirebaseJson, 2> json(jsonPool);
+ *   if (!json) return;
+ *   json->set("key", 1);
+ */
+template <typename T, size_t N>
+class StaticPool {
+public:
+  StaticPool() : inUse_(0), highWater_(0), exhausted_(0) {
+    for (size_t i = 0; i < N; i++) {
+      used_[i] = false;
+    }
+  }
+
+  T* acquire() {
+    for (size_t i = 0; i < N; i++) {
+      if (!used_[i]) {
+        used_[i] = true;
+        if (++inUse_ > highWater_) {
+          highWater_ = inUse_;
+        }
+        items_[i].clear();
+        return &items_[i];
+      }
+    }
+    exhausted_++;
+    return NULL;
+  }
+
+  void release(T* item) {
+    size_t i = (size_t)(item - items_);
+    if (i < N && used_[i]) {
+      used_[i] = false;
+      inUse_--;
+    }
+  }
+
+  size_t capacity() const { return N; }
+  size_t inUse() const { return inUse_; }
+  size_t highWater() const { return highWater_; }
+  uint32_t exhausted() const { return exhausted_; }
+  size_t bytes() const { return sizeof(items_); }
+
+private:
+  T items_[N];
+  bool used_[N];
+  size_t inUse_;
+  size_t highWater_;
+  uint32_t exhausted_;
+};
+
+/**
+ * @brief Scoped lease: releases the object when it goes out of scope
+ */
+template <typename T, size_t N>
+class PoolLease {
+public:
+  explicit PoolLease(StaticPool<T, N> &pool) : pool_(pool), item_(pool.acquire()) {}
+  ~PoolLease() {
+    if (item_) {
+      pool_.release(item_);
+    }
+  }
+
+  explicit operator bool() const { return item_ != NULL; }
+  T* get() const { return item_; }
+  T* operator->() const { return item_; }
+  T &operator*() const { return *item_; }
+
+private:
+  PoolLease(const PoolLease &);
+  PoolLease &operator=(const PoolLease &);
+
+  StaticPool<T, N> &pool_;
+  T* item_;
+};
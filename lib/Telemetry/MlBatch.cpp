@@ -0,0 +1,166 @@
+#include "MlBatch.h"
+
+#include <math.h>
+#include <stdarg.h>
+#include <string.h>
+
+/**
+ * @brief Bounded append-only writer over a caller buffer
+ */
+struct ChunkWriter {
+  char* out;
+  size_t capacity;
+  size_t length;
+  bool overflow;
+
+  void text(const char* s) {
+    size_t n = strlen(s);
+    if (length + n >= capacity) {
+      overflow = true;
+      return;
+    }
+    memcpy(out + length, s, n);
+    length += n;
+    out[length] = '\0';
+  }
+
+  void format(const char* fmt, ...) {
+    if (overflow) {
+      return;
+    }
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(out + length, capacity - length, fmt, args);
+    va_end(args);
+    if (n < 0 || (size_t)n >= capacity - length) {
+      overflow = true;
+      return;
+    }
+    length += n;
+  }
+
+  // Fixed-point number with trailing zeros trimmed ("29.50" -> "29.5", "400.00" -> "400")
+  void number(float value, uint8_t decimals) {
+    if (isnan(value) || isinf(value)) {
+      text("null");
+      return;
+    }
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%.*f", decimals, (double)value);
+    if (decimals > 0) {
+      char* end = buf + strlen(buf) - 1;
+      while (*end == '0') *end-- = '\0';
+      if (*end == '.') *end = '\0';
+    }
+    if (strcmp(buf, "-0") == 0) {
+      strcpy(buf, "0");
+    }
+    text(buf);
+  }
+};
+
+
+uint8_t actionsOnMask(const char* const* actions) {
+  uint8_t mask = 0;
+  for (int i = 0; i < ACTION_COUNT; i++) {
+    if (strcmp(actions[i], "ON") == 0) {
+      mask |= 1 << i;
+    }
+  }
+  return mask;
+}
+
+
+size_t MlBatch::encode(char* out, size_t capacity, uint8_t workingMask, bool windowStats) const {
+  if (capacity == 0 || count_ == 0) {
+    return 0;
+  }
+  out[0] = '\0';
+  ChunkWriter w = { out, capacity, 0, false };
+
+  w.format("{\"v\":%d,\"n\":%d,\"mask\":%d,\"t0\":%.0f,\"dt\":[",
+           ML_BATCH_VERSION, count_, workingMask, rows_[0].timeMs);
+  for (int r = 0; r < count_; r++) {
+    double delta = (r == 0) ? 0.0 : rows_[r].timeMs - rows_[r - 1].timeMs;
+    w.format(r ? ",%.0f" : "%.0f", delta);
+  }
+
+  w.text("],\"actions_on\":[");
+  for (int r = 0; r < count_; r++) {
+    w.format(r ? ",%d" : "%d", rows_[r].actionsOn);
+  }
+  w.text("]");
+
+  // Sample columns, grouped under their sensor object
+  const char* openSensor = NULL;
+  for (int f = 0; f < WF_COUNT; f++) {
+    const SensorField &col = SENSOR_FIELDS[f];
+    const char* sensor = LIVE_NODE_NAMES[col.node];
+    if (!(workingMask & sensorFieldBit(f))) {
+      continue;
+    }
+    if (!openSensor || strcmp(openSensor, sensor) != 0) {
+      w.text(openSensor ? "}," : ",");
+      w.format("\"%s\":{", sensor);
+      openSensor = sensor;
+    } else {
+      w.text(",");
+    }
+    w.format("\"%s\":[", col.name);
+    for (int r = 0; r < count_; r++) {
+      if (r) w.text(",");
+      w.number(sampleField(rows_[r].sample, f), col.decimals);
+    }
+    w.text("]");
+  }
+  if (openSensor) {
+    w.text("}");
+  }
+
+  // Window aggregate columns: Window/<sensor>/<field>/{min,max,mean,std,n}
+  if (windowStats) {
+    static const char* const STAT_NAMES[5] = { "min", "max", "mean", "std", "n" };
+    openSensor = NULL;
+    w.text(",\"Window\":{");
+    for (int f = 0; f < WF_COUNT; f++) {
+      const SensorField &col = SENSOR_FIELDS[f];
+      const char* sensor = LIVE_NODE_NAMES[col.node];
+      if (!(workingMask & sensorFieldBit(f))) {
+        continue;
+      }
+      if (!openSensor || strcmp(openSensor, sensor) != 0) {
+        if (openSensor) w.text("},");
+        w.format("\"%s\":{", sensor);
+        openSensor = sensor;
+      } else {
+        w.text(",");
+      }
+      w.format("\"%s\":{", col.name);
+      for (int stat = 0; stat < 5; stat++) {
+        w.format(stat ? ",\"%s\":[" : "\"%s\":[", STAT_NAMES[stat]);
+        for (int r = 0; r < count_; r++) {
+          if (r) w.text(",");
+          const WindowStats &ws = rows_[r].window[f];
+          if (stat == 4) {
+            w.format("%u", (unsigned)ws.count);
+          } else if (ws.count == 0) {
+            w.text("null");
+          } else {
+            float v = (stat == 0) ? ws.minValue : (stat == 1) ? ws.maxValue :
+                      (stat == 2) ? ws.mean : ws.stddev();
+            w.number(v, col.decimals + (stat == 3 ? 1 : 0));
+          }
+        }
+        w.text("]");
+      }
+      w.text("}");
+    }
+    if (openSensor) {
+      w.text("}");
+    }
+    w.text("}");
+  }
+
+  w.text("}");
+  return w.overflow ? 0 : w.length;
+}
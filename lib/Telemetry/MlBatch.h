@@ -0,0 +1,77 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <Telemetry.h>
+
+/**
+ * Columnar batch of ML training samples.
+ *
+ * Collects up to ML_BATCH_CAPACITY rows on the device and encodes them as
+ * one chunk document where every field is a column array and time is a
+ * base timestamp plus per-row deltas:
+ *
+ *   {"v":1,"n":K,"mask":15,"t0":<ms>,"dt":[0,5000,...],"actions_on":[0,...],
+ *    "AHT10":{"humidity":[...],"temperature":[...]}, ...,
+ *    "Window":{"AHT10":{"humidity":{"min":[...],"max":[...],"mean":[...],
+ *                                   "std":[...],"n":[...]}}, ...}}
+ *
+ * Key names are written once per chunk instead of once per sample, values
+ * are rounded to each field's sensor resolution, and the five action
+ * strings shrink to one bitmask per row (bit i set = action_{i+1} is "ON").
+ * That mapping is lossy: any value other than "ON" (e.g. "AUTO", "") is
+ * stored as off, so chunks only suit models trained on ON versus not-ON.
+ * tools/ml_chunks/decode_ml_chunks.py turns chunks back into per-sample
+ * records in the ML_Training_Data shape.
+ *
+ * Encoding writes into a caller-supplied buffer and never allocates.
+ */
+
+#ifndef ML_BATCH_CAPACITY
+#define ML_BATCH_CAPACITY 24
+#endif
+
+#define ML_BATCH_VERSION 1
+
+/**
+ * @brief One sample row of a batch
+ */
+struct MlBatchRow {
+  double timeMs;                 // Sample timestamp (epoch ms once the clock is synced)
+  SensorSample sample;
+  uint8_t actionsOn;             // Bit i = action_{i+1} is "ON"
+  WindowStats window[WF_COUNT];  // Aggregates of the window this row closes
+};
+
+class MlBatch {
+public:
+  MlBatch() : count_(0) {}
+
+  void clear() { count_ = 0; }
+  uint8_t size() const { return count_; }
+  bool full() const { return count_ >= ML_BATCH_CAPACITY; }
+
+  /**
+   * @brief Slot for the next row (NULL when full); commit it with push()
+   */
+  MlBatchRow* nextRow() { return full() ? NULL : &rows_[count_]; }
+  void push() { if (!full()) count_++; }
+
+  /**
+   * @brief Encode the batch as one chunk document
+   * @param workingMask  SensorBit flags of the columns to include
+   * @param windowStats  include the Window aggregate columns
+   * @return bytes written excluding the terminator, 0 if out is too small
+   */
+  size_t encode(char* out, size_t capacity, uint8_t workingMask, bool windowStats) const;
+
+private:
+  MlBatchRow rows_[ML_BATCH_CAPACITY];
+  uint8_t count_;
+};
+
+/**
+ * @brief Bitmask of actions whose value is "ON" (every other value reads as off)
+ */
+uint8_t actionsOnMask(const char* const* actions);
@@ -0,0 +1,287 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <WindowStats.h>
+
+/**
+ * @brief Snapshot of every sensor reading taken by the acquisition task
+ */
+struct SensorSample {
+  float humidity;
+  float temperature;
+  float ambient;
+  float object;
+  float accelX, accelY, accelZ;
+  float gyroX, gyroY, gyroZ;
+  float temperatureMPU;
+  uint16_t tvoc;
+  uint16_t eco2;
+  int64_t epochUs;   // Acquisition time, Unix epoch microseconds (0 = clock not synced)
+};
+
+// Bit per sensor in the "working" mask passed to the payload builders (bit n = LiveNode n)
+enum SensorBit {
+  SENSOR_BIT_AHT10    = 1 << 0,
+  SENSOR_BIT_MLX90614 = 1 << 1,
+  SENSOR_BIT_MPU6050  = 1 << 2,
+  SENSOR_BIT_SGP30    = 1 << 3
+};
+
+// Live upload targets, one RTDB node each under <USER>/Sensor_Data/
+enum LiveNode {
+  LIVE_AHT10,
+  LIVE_MLX90614,
+  LIVE_MPU6050,
+  LIVE_SGP30,
+  LIVE_NODE_COUNT
+};
+
+static const char* const LIVE_NODE_NAMES[LIVE_NODE_COUNT] = { "AHT10", "MLX90614", "MPU6050", "SGP30" };
+
+#define ACTION_COUNT 5
+
+// Windowed aggregation fields (one WindowStats per uploaded field)
+enum WindowField {
+  WF_HUMIDITY,
+  WF_TEMPERATURE,
+  WF_AMBIENT,
+  WF_OBJECT,
+  WF_ACCEL_X,
+  WF_ACCEL_Y,
+  WF_ACCEL_Z,
+  WF_GYRO_X,
+  WF_GYRO_Y,
+  WF_GYRO_Z,
+  WF_TEMP_MPU,
+  WF_TVOC,
+  WF_ECO2,
+  WF_COUNT
+};
+
+/**
+ * @brief Value of one WindowField in a sample
+ */
+inline float sampleField(const SensorSample &s, int field) {
+  switch (field) {
+    case WF_HUMIDITY:    return s.humidity;
+    case WF_TEMPERATURE: return s.temperature;
+    case WF_AMBIENT:     return s.ambient;
+    case WF_OBJECT:      return s.object;
+    case WF_ACCEL_X:     return s.accelX;
+    case WF_ACCEL_Y:     return s.accelY;
+    case WF_ACCEL_Z:     return s.accelZ;
+    case WF_GYRO_X:      return s.gyroX;
+    case WF_GYRO_Y:      return s.gyroY;
+    case WF_GYRO_Z:      return s.gyroZ;
+    case WF_TEMP_MPU:    return s.temperatureMPU;
+    case WF_TVOC:        return (float)s.tvoc;
+    case WF_ECO2:        return (float)s.eco2;
+    default:             return 0.0f;
+  }
+}
+
+/**
+ * @brief Store one WindowField into a sample (integer readings round, NaN stores 0)
+ */
+inline void setSampleField(SensorSample &s, int field, float value) {
+  uint16_t count = (value > 0.0f) ? (uint16_t)(value + 0.5f) : 0;   // False for NaN
+  switch (field) {
+    case WF_HUMIDITY:    s.humidity = value; break;
+    case WF_TEMPERATURE: s.temperature = value; break;
+    case WF_AMBIENT:     s.ambient = value; break;
+    case WF_OBJECT:      s.object = value; break;
+    case WF_ACCEL_X:     s.accelX = value; break;
+    case WF_ACCEL_Y:     s.accelY = value; break;
+    case WF_ACCEL_Z:     s.accelZ = value; break;
+    case WF_GYRO_X:      s.gyroX = value; break;
+    case WF_GYRO_Y:      s.gyroY = value; break;
+    case WF_GYRO_Z:      s.gyroZ = value; break;
+    case WF_TEMP_MPU:    s.temperatureMPU = value; break;
+    case WF_TVOC:        s.tvoc = count; break;
+    case WF_ECO2:        s.eco2 = count; break;
+    default:             break;
+  }
+}
+
+/**
+ * @brief Declaration of one uploaded field
+ *
+ * SENSOR_FIELDS is the single list of what each sensor produces: the live
+ * payload, ML records, ML chunk columns, window aggregation, anomaly
+ * scoring, the fixed-point DutySample (duty-cycle buffer and GPRS frames)
+ * and the sensor schema report are all generated from it. A sensor's fields are
+ * contiguous and in the order its driver reads them (which is also the
+ * SensorTrace payload order).
+ */
+struct SensorField {
+  uint8_t node;           // Owning sensor (LiveNode; also its TraceSensor id)
+  const char* liveKey;    // Key in <USER>/Sensor_Data/<sensor>
+  const char* name;       // Key under the sensor object in ML records and chunks
+  const char* unit;
+  uint8_t decimals;       // Sensor resolution; 0 = integer reading
+  float noiseFloor;       // Smallest stddev used for anomaly scoring (sensor units)
+  float fixedScale;       // int16 fixed point = value * fixedScale; sized to the sensor's range
+};
+
+// Indexed by WindowField
+static constexpr SensorField SENSOR_FIELDS[WF_COUNT] = {
+  { LIVE_AHT10,    "Humidity",    "humidity",    "%RH",   2, 0.5f,   100.0f },
+  { LIVE_AHT10,    "Temperature", "temperature", "C",     2, 0.2f,   100.0f },
+  { LIVE_MLX90614, "Ambient",     "ambient",     "C",     2, 0.2f,   100.0f },
+  { LIVE_MLX90614, "Object",      "object",      "C",     2, 0.2f,   100.0f },
+  { LIVE_MPU6050,  "Accel_X",     "accel_x",     "m/s^2", 3, 0.05f,  400.0f },    // +-8 g
+  { LIVE_MPU6050,  "Accel_Y",     "accel_y",     "m/s^2", 3, 0.05f,  400.0f },
+  { LIVE_MPU6050,  "Accel_Z",     "accel_z",     "m/s^2", 3, 0.05f,  400.0f },
+  { LIVE_MPU6050,  "Gyro_X",      "gyro_x",      "rad/s", 4, 0.02f,  1000.0f },   // +-500 deg/s
+  { LIVE_MPU6050,  "Gyro_Y",      "gyro_y",      "rad/s", 4, 0.02f,  1000.0f },
+  { LIVE_MPU6050,  "Gyro_Z",      "gyro_z",      "rad/s", 4, 0.02f,  1000.0f },
+  { LIVE_MPU6050,  "Temp_MPU",    "temperature", "C",     2, 0.2f,   100.0f },
+  { LIVE_SGP30,    "TVOC",        "tvoc",        "ppb",   0, 10.0f,  0.5f },      // 0-60000, 2 ppb steps
+  { LIVE_SGP30,    "eCO2",        "eco2",        "ppm",   0, 20.0f,  0.5f },      // 400-60000, 2 ppm steps
+};
+static_assert(SENSOR_FIELDS[WF_COUNT - 1].name != nullptr && SENSOR_FIELDS[WF_COUNT - 1].fixedScale > 0.0f,
+              "SENSOR_FIELDS needs a complete entry for every WindowField");
+
+/**
+ * @brief SensorBit of the sensor that owns a field
+ */
+inline uint8_t sensorFieldBit(int field) {
+  return (uint8_t)(1 << SENSOR_FIELDS[field].node);
+}
+
+/**
+ * @brief Number of fields a sensor produces
+ * constexpr (single-expression recursion) so per-sensor layouts can be checked at compile time.
+ */
+constexpr uint8_t sensorFieldCount(int node, int f = 0) {
+  return f >= WF_COUNT ? 0 : (SENSOR_FIELDS[f].node == node ? 1 : 0) + sensorFieldCount(node, f + 1);
+}
+
+/**
+ * @brief First WindowField of a sensor (WF_COUNT if it has none)
+ */
+constexpr int sensorFirstField(int node, int f = 0) {
+  return f >= WF_COUNT ? WF_COUNT : SENSOR_FIELDS[f].node == node ? f : sensorFirstField(node, f + 1);
+}
+
+/**
+ * @brief Largest sensorFieldCount() over all sensors
+ */
+constexpr uint8_t sensorMaxFieldCount(int node = 0) {
+  return node >= LIVE_NODE_COUNT ? 0
+       : sensorFieldCount(node) > sensorMaxFieldCount(node + 1) ? sensorFieldCount(node) : sensorMaxFieldCount(node + 1);
+}
+
+/**
+ * @brief True if every sensor's fields are contiguous in SENSOR_FIELDS
+ */
+constexpr bool sensorFieldsContiguous(int f = 1) {
+  return f >= WF_COUNT ? true
+       : (SENSOR_FIELDS[f].node == SENSOR_FIELDS[f - 1].node || sensorFirstField(SENSOR_FIELDS[f].node) == f)
+         && sensorFieldsContiguous(f + 1);
+}
+
+static_assert(sensorFieldsContiguous(), "A sensor's SENSOR_FIELDS entries must be contiguous");
+
+// ------------------------------------------------------------------
+// Payload builders
+//
+// Templated on the JSON type so the device can build straight into
+// FirebaseJson while host tools use their own writer with the same
+// set(path, value) interface. Paths may contain '/' to nest objects.
+// ------------------------------------------------------------------
+
+/**
+ * @brief Set one field of a sample, as an integer for integer readings
+ */
+template <typename Json>
+void setSensorField(Json &json, const char* key, const SensorSample &s, int field) {
+  float value = sampleField(s, field);
+  if (SENSOR_FIELDS[field].decimals == 0) {
+    json.set(key, (int)value);
+  } else {
+    json.set(key, value);
+  }
+}
+
+/**
+ * @brief Build the <USER>/Sensor_Data/<node> payload for one sensor
+ */
+template <typename Json>
+void buildLivePayload(Json &json, LiveNode node, const SensorSample &s) {
+  for (int f = 0; f < WF_COUNT; f++) {
+    if (SENSOR_FIELDS[f].node == node) {
+      setSensorField(json, SENSOR_FIELDS[f].liveKey, s, f);
+    }
+  }
+}
+
+/**
+ * @brief Add min/max/mean/std/n of one window under the given JSON path
+ */
+template <typename Json>
+void addWindowStats(Json &json, const char* path, const WindowStats &stats) {
+  if (stats.count == 0) {
+    return; // No samples this window - leave the field out
+  }
+
+  char key[64];
+  snprintf(key, sizeof(key), "%s/min", path);
+  json.set(key, stats.minValue);
+  snprintf(key, sizeof(key), "%s/max", path);
+  json.set(key, stats.maxValue);
+  snprintf(key, sizeof(key), "%s/mean", path);
+  json.set(key, stats.mean);
+  snprintf(key, sizeof(key), "%s/std", path);
+  json.set(key, stats.stddev());
+  snprintf(key, sizeof(key), "%s/n", path);
+  json.set(key, (int)stats.count);
+}
+
+/**
+ * @brief Build one <USER>/ML_Training_Data/record_NNN document
+ * @param workingMask SensorBit flags of sensors that passed init
+ * @param window      per-field aggregates of the closing window (may be NULL)
+ * @param actions     ACTION_COUNT current action strings
+ * @param uptimeMs    device uptime at upload (kept for existing consumers)
+ */
+template <typename Json>
+void buildMlRecord(Json &json, const SensorSample &s, uint8_t workingMask,
+                   const WindowStats* window, const char* const* actions,
+                   double uptimeMs) {
+  json.set("timestamp_ms", uptimeMs);
+  if (s.epochUs != 0) {
+    json.set("epoch_us", (double)s.epochUs);   // Exact in a double until year 2255
+  }
+
+  // Each working sensor's readings, then its window aggregates under Window/
+  for (int node = 0; node < LIVE_NODE_COUNT; node++) {
+    if (!(workingMask & (1 << node))) {
+      continue;
+    }
+    char key[48];
+    for (int f = 0; f < WF_COUNT; f++) {
+      if (SENSOR_FIELDS[f].node == node) {
+        snprintf(key, sizeof(key), "%s/%s", LIVE_NODE_NAMES[node], SENSOR_FIELDS[f].name);
+        setSensorField(json, key, s, f);
+      }
+    }
+    if (window) {
+      for (int f = 0; f < WF_COUNT; f++) {
+        if (SENSOR_FIELDS[f].node == node) {
+          snprintf(key, sizeof(key), "Window/%s/%s", LIVE_NODE_NAMES[node], SENSOR_FIELDS[f].name);
+          addWindowStats(json, key, window[f]);
+        }
+      }
+    }
+  }
+
+  // Add action states for context
+  for (int i = 0; i < ACTION_COUNT; i++) {
+    char key[20];
+    snprintf(key, sizeof(key), "Actions/action_%d", i + 1);
+    json.set(key, actions[i]);
+  }
+}
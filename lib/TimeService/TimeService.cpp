@@ -0,0 +1,83 @@
+#include "TimeService.h"
+
+#include <string.h>
+
+
+TimeService::TimeService()
+  : anchorMonoUs_(0), anchorEpochUs_(0), slewUs_(0),
+    prevSyncMonoUs_(0), prevSyncEpochUs_(0), drift_(0.0f) {
+  memset(&quality_, 0, sizeof(quality_));
+}
+
+
+int64_t TimeService::appliedSlew(int64_t elapsedUs) const {
+  // Correction applied so far: at most TIME_MAX_SLEW_PPM of elapsed time
+  int64_t limit = elapsedUs * TIME_MAX_SLEW_PPM / 1000000;
+  if (slewUs_ > limit) return limit;
+  if (slewUs_ < -limit) return -limit;
+  return slewUs_;
+}
+
+
+int64_t TimeService::epochUs(int64_t monoUs) const {
+  if (!quality_.synced) {
+    return 0;
+  }
+  int64_t elapsed = monoUs - anchorMonoUs_;
+  return anchorEpochUs_ + elapsed + (int64_t)(elapsed * drift_) + appliedSlew(elapsed);
+}
+
+
+void TimeService::onSync(int64_t monoUs, int64_t epochUs) {
+  if (!quality_.synced) {
+    // First fix: step straight to it
+    anchorMonoUs_ = monoUs;
+    anchorEpochUs_ = epochUs;
+    slewUs_ = 0;
+    prevSyncMonoUs_ = monoUs;
+    prevSyncEpochUs_ = epochUs;
+    quality_.synced = true;
+    quality_.syncCount = 1;
+    quality_.stepCount = 1;
+    quality_.lastOffsetUs = 0;
+    quality_.lastSyncMonoUs = monoUs;
+    return;
+  }
+
+  int64_t predicted = this->epochUs(monoUs);
+  int64_t offset = epochUs - predicted;
+
+  // Re-estimate drift from the span between this sync and the previous one
+  int64_t monoSpan = monoUs - prevSyncMonoUs_;
+  if (monoSpan >= TIME_MIN_DRIFT_WINDOW_US) {
+    float measured = (float)(epochUs - prevSyncEpochUs_ - monoSpan) / (float)monoSpan;
+    if (measured * 1e6f < TIME_MAX_DRIFT_PPM && measured * 1e6f > -TIME_MAX_DRIFT_PPM) {
+      drift_ += 0.5f * (measured - drift_);   // Smooth out SNTP jitter
+    }
+  }
+  prevSyncMonoUs_ = monoUs;
+  prevSyncEpochUs_ = epochUs;
+
+  // Re-anchor on the current prediction so the clock stays continuous
+  anchorMonoUs_ = monoUs;
+  if (offset > TIME_STEP_THRESHOLD_US || offset < -TIME_STEP_THRESHOLD_US) {
+    anchorEpochUs_ = epochUs;
+    slewUs_ = 0;
+    quality_.stepCount++;
+  } else {
+    anchorEpochUs_ = predicted;
+    slewUs_ = offset;
+  }
+
+  quality_.syncCount++;
+  quality_.lastOffsetUs = offset;
+  quality_.lastSyncMonoUs = monoUs;
+}
+
+
+TimeSyncQuality TimeService::quality(int64_t monoUs) const {
+  TimeSyncQuality q = quality_;
+  q.driftPpm = drift_ * 1e6f;
+  q.pendingSlewUs = slewUs_ - appliedSlew(monoUs - anchorMonoUs_);
+  return q;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * Monotonic-to-epoch clock.
+ *
+ * Keeps a linear model epoch = anchorEpoch + (mono - anchorMono) * (1 + drift)
+ * fed by periodic SNTP observations. Between syncs a timestamp is a couple
+ * of multiplies away from the monotonic timer, so it is cheap enough to
+ * stamp every reading at acquisition.
+ *
+ * On each sync the drift is re-estimated from the previous sync and the
+ * residual offset is slewed in at a bounded rate, so timestamps never jump
+ * backwards. Offsets larger than TIME_STEP_THRESHOLD_US (and the very first
+ * sync) are stepped instead.
+ *
+ * Not thread safe: callers on more than one task must serialise access.
+ */
+
+#define TIME_MAX_SLEW_PPM        500         // Max correction rate (0.5 ms per second)
+#define TIME_STEP_THRESHOLD_US   1000000LL   // Step instead of slewing beyond 1 s
+#define TIME_MAX_DRIFT_PPM       500.0f      // Reject drift estimates beyond this (bad sample)
+#define TIME_MIN_DRIFT_WINDOW_US 60000000LL  // Need >= 60 s between syncs to estimate drift
+
+/**
+ * @brief Health of the epoch clock, for reporting
+ */
+struct TimeSyncQuality {
+  bool synced;
+  uint32_t syncCount;
+  uint32_t stepCount;
+  int64_t lastOffsetUs;      // Prediction error measured at the last sync
+  float driftPpm;            // Estimated oscillator drift
+  int64_t pendingSlewUs;     // Correction not yet applied
+  int64_t lastSyncMonoUs;
+};
+
+class TimeService {
+public:
+  TimeService();
+
+  /**
+   * @brief Feed one SNTP observation
+   * @param monoUs  monotonic time when the observation was taken
+   * @param epochUs Unix epoch time in microseconds reported by SNTP
+   */
+  void onSync(int64_t monoUs, int64_t epochUs);
+
+  /**
+   * @brief Epoch microseconds at the given monotonic time (0 before the first sync)
+   */
+  int64_t epochUs(int64_t monoUs) const;
+
+  bool synced() const { return quality_.synced; }
+
+  /**
+   * @brief Current sync quality (pendingSlewUs evaluated at monoUs)
+   */
+  TimeSyncQuality quality(int64_t monoUs) const;
+
+private:
+  int64_t anchorMonoUs_;
+  int64_t anchorEpochUs_;
+  int64_t slewUs_;            // Correction to spread in from the anchor onward
+  int64_t prevSyncMonoUs_;
+  int64_t prevSyncEpochUs_;
+  float drift_;               // Fractional rate error (ppm * 1e-6)
+  TimeSyncQuality quality_;
+
+  int64_t appliedSlew(int64_t elapsedUs) const;
+};
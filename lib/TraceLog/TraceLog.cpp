@@ -0,0 +1,182 @@
+#include "TraceLog.h"
+
+#include <atomic>
+
+#if defined(ESP_PLATFORM)
+#include <freertos/FreeRTOS.h>
+#include <esp_timer.h>
+
+static inline uint8_t currentCore() { return (uint8_t)xPortGetCoreID(); }
+static inline uint32_t nowUs() { return (uint32_t)esp_timer_get_time(); }
+
+// Keeps tasks on this core (and its ISRs) out while a slot is written
+#define TRACELOG_LOCAL_LOCK()   UBaseType_t tlogIrqState_ = portSET_INTERRUPT_MASK_FROM_ISR()
+#define TRACELOG_LOCAL_UNLOCK() portCLEAR_INTERRUPT_MASK_FROM_ISR(tlogIrqState_)
+#else
+#include <chrono>
+
+// Host builds: a single producer thread per ring
+static inline uint8_t currentCore() { return 0; }
+static inline uint32_t nowUs() {
+  return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#define TRACELOG_LOCAL_LOCK()
+#define TRACELOG_LOCAL_UNLOCK()
+#endif
+
+static_assert((TRACELOG_RING_SIZE & (TRACELOG_RING_SIZE - 1)) == 0, "TRACELOG_RING_SIZE must be a power of two");
+
+
+/**
+ * @brief Single-producer/single-consumer record ring
+ * head_ is only written by the owning core, tail_ only by the drain task.
+ */
+struct TraceLogRing {
+  TraceLogRecord slots[TRACELOG_RING_SIZE];
+  std::atomic<uint32_t> head;
+  std::atomic<uint32_t> tail;
+  std::atomic<uint32_t> dropped;
+  uint32_t droppedReported;   // Drain side only
+};
+
+static TraceLogRing rings[TRACELOG_CORES];
+
+volatile uint8_t traceLogLevel = TL_WARN;
+
+
+void traceLogSetLevel(uint8_t level) {
+  if (level >= TL_LEVEL_COUNT) {
+    level = TL_LEVEL_COUNT - 1;
+  }
+  traceLogLevel = level;
+  TLOG(TL_LOG_LEVEL, level);
+}
+
+
+void traceLogWrite(uint16_t formatId, const TraceLogArg* args, uint8_t argCount) {
+  uint32_t timeUs = nowUs();
+  if (argCount > TRACELOG_MAX_ARGS) {
+    argCount = TRACELOG_MAX_ARGS;
+  }
+
+  TRACELOG_LOCAL_LOCK();
+  uint8_t core = currentCore();
+  TraceLogRing &ring = rings[core];
+  uint32_t head = ring.head.load(std::memory_order_relaxed);
+  if (head - ring.tail.load(std::memory_order_acquire) >= TRACELOG_RING_SIZE) {
+    ring.dropped.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    TraceLogRecord &slot = ring.slots[head & (TRACELOG_RING_SIZE - 1)];
+    slot.timeUs = timeUs;
+    slot.formatId = formatId;
+    slot.core = core;
+    slot.argCount = argCount;
+    for (uint8_t i = 0; i < argCount; i++) {
+      slot.args[i] = args[i].bits;
+    }
+    ring.head.store(head + 1, std::memory_order_release);   // Publish the slot
+  }
+  TRACELOG_LOCAL_UNLOCK();
+}
+
+
+static void putU16(uint8_t* p, uint16_t v) { p[0] = v; p[1] = v >> 8; }
+static void putU32(uint8_t* p, uint32_t v) { p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24; }
+static uint16_t getU16(const uint8_t* p) { return p[0] | (p[1] << 8); }
+static uint32_t getU32(const uint8_t* p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+
+size_t traceLogEncodeFrame(const TraceLogRecord &record, uint8_t* out, size_t capacity) {
+  size_t length = 2 + 1 + 2 + 4 + 1 + 4 * record.argCount + 1;
+  if (record.argCount > TRACELOG_MAX_ARGS || length > capacity) {
+    return 0;
+  }
+  uint8_t* p = out;
+  *p++ = TRACELOG_SYNC0;
+  *p++ = TRACELOG_SYNC1;
+  *p++ = record.core;
+  putU16(p, record.formatId); p += 2;
+  putU32(p, record.timeUs); p += 4;
+  *p++ = record.argCount;
+  for (uint8_t i = 0; i < record.argCount; i++) {
+    putU32(p, record.args[i]); p += 4;
+  }
+  uint8_t check = 0;
+  for (uint8_t* q = out + 2; q < p; q++) {
+    check ^= *q;
+  }
+  *p++ = check;
+  return length;
+}
+
+
+size_t traceLogParseFrame(const uint8_t* data, size_t length, TraceLogRecord &record) {
+  const size_t fixed = 2 + 1 + 2 + 4 + 1;
+  if (length < fixed + 1 || data[0] != TRACELOG_SYNC0 || data[1] != TRACELOG_SYNC1) {
+    return 0;
+  }
+  uint8_t argCount = data[9];
+  size_t frameLength = fixed + 4 * argCount + 1;
+  if (argCount > TRACELOG_MAX_ARGS || length < frameLength) {
+    return 0;
+  }
+  uint8_t check = 0;
+  for (size_t i = 2; i < frameLength - 1; i++) {
+    check ^= data[i];
+  }
+  if (check != data[frameLength - 1]) {
+    return 0;
+  }
+
+  record.core = data[2];
+  record.formatId = getU16(data + 3);
+  record.timeUs = getU32(data + 5);
+  record.argCount = argCount;
+  for (uint8_t i = 0; i < argCount; i++) {
+    record.args[i] = getU32(data + fixed + 4 * i);
+  }
+  return frameLength;
+}
+
+
+size_t traceLogDrain(uint8_t* out, size_t capacity) {
+  size_t written = 0;
+
+  for (uint8_t core = 0; core < TRACELOG_CORES; core++) {
+    TraceLogRing &ring = rings[core];
+
+    // Report overflow before the records that survived it
+    uint32_t dropped = ring.dropped.load(std::memory_order_relaxed);
+    if (dropped != ring.droppedReported) {
+      TraceLogRecord notice;
+      notice.timeUs = nowUs();
+      notice.formatId = TL_LOG_DROPPED;
+      notice.core = core;
+      notice.argCount = 2;
+      notice.args[0] = dropped - ring.droppedReported;
+      notice.args[1] = core;
+      size_t n = traceLogEncodeFrame(notice, out + written, capacity - written);
+      if (n == 0) {
+        return written;
+      }
+      written += n;
+      ring.droppedReported = dropped;
+    }
+
+    uint32_t tail = ring.tail.load(std::memory_order_relaxed);
+    while (tail != ring.head.load(std::memory_order_acquire)) {
+      size_t n = traceLogEncodeFrame(ring.slots[tail & (TRACELOG_RING_SIZE - 1)],
+                                     out + written, capacity - written);
+      if (n == 0) {
+        return written;   // Out of space; the rest waits for the next call
+      }
+      written += n;
+      tail++;
+      ring.tail.store(tail, std::memory_order_release);
+    }
+  }
+  return written;
+}
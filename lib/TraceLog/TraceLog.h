@@ -0,0 +1,110 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <TraceLogFormats.h>
+
+/**
+ * Deferred-format binary trace logger.
+ *
+ * A log call stores a timestamp, a format id (see TraceLogFormats.h) and up
+ * to TRACELOG_MAX_ARGS raw 32-bit arguments in a ring owned by the calling
+ * core; no formatting and no UART I/O happens on the caller's task. A
+ * low-priority task calls traceLogDrain() to turn pending records into
+ * frames for the serial port, and tools/tracelog_decode formats them on the
+ * host.
+ *
+ * Each core has its own single-producer/single-consumer ring, so the two
+ * cores never contend. Tasks on the same core are kept apart by briefly
+ * masking that core's interrupts around the slot write. When a ring is full
+ * the record is dropped and counted; the drain reports drops as a
+ * TL_LOG_DROPPED record.
+ *
+ *   TLOG(TL_MPU_ACCEL, ax, ay, az);
+ *
+ * Arguments are only evaluated when the entry's level is enabled.
+ *
+ * Frame layout (little endian), as written by traceLogDrain():
+ *   0xA5 0x5A | core u8 | id u16 | timeUs u32 | argCount u8 | args u32[argCount] | xor u8
+ * The xor covers every byte after the sync pair. Frames may be interleaved
+ * with plain text on the same port; the decoder passes that through.
+ */
+
+#ifndef TRACELOG_RING_SIZE
+#define TRACELOG_RING_SIZE 64   // Records per core (power of two)
+#endif
+
+#define TRACELOG_MAX_ARGS   4
+#define TRACELOG_CORES      2
+#define TRACELOG_SYNC0      0xA5
+#define TRACELOG_SYNC1      0x5A
+#define TRACELOG_FRAME_MAX  (2 + 1 + 2 + 4 + 1 + 4 * TRACELOG_MAX_ARGS + 1)
+
+/**
+ * @brief One deferred log record
+ */
+struct TraceLogRecord {
+  uint32_t timeUs;                    // Low 32 bits of the monotonic timer
+  uint16_t formatId;
+  uint8_t core;
+  uint8_t argCount;
+  uint32_t args[TRACELOG_MAX_ARGS];
+};
+
+/**
+ * @brief A log argument stored as its raw 32-bit pattern
+ */
+struct TraceLogArg {
+  uint32_t bits;
+  TraceLogArg(int v) : bits((uint32_t)v) {}
+  TraceLogArg(unsigned v) : bits(v) {}
+  TraceLogArg(long v) : bits((uint32_t)v) {}
+  TraceLogArg(unsigned long v) : bits((uint32_t)v) {}
+  TraceLogArg(float v) { memcpy(&bits, &v, sizeof(bits)); }
+  TraceLogArg(double v) { float f = (float)v; memcpy(&bits, &f, sizeof(bits)); }
+};
+
+// Highest level recorded; entries above it cost one compare
+extern volatile uint8_t traceLogLevel;
+
+inline bool traceLogEnabled(uint16_t formatId) {
+  return TRACELOG_LEVELS[formatId] <= traceLogLevel;
+}
+
+/**
+ * @brief Change the runtime level (also logs the change)
+ */
+void traceLogSetLevel(uint8_t level);
+
+/**
+ * @brief Append a record to the calling core's ring (drops it when full)
+ */
+void traceLogWrite(uint16_t formatId, const TraceLogArg* args, uint8_t argCount);
+
+/**
+ * @brief Move pending records from both rings into serial frames
+ * @return bytes written to out; call again while it returns non-zero
+ */
+size_t traceLogDrain(uint8_t* out, size_t capacity);
+
+/**
+ * @brief Encode one record as a frame
+ * @return frame length, 0 if out is too small
+ */
+size_t traceLogEncodeFrame(const TraceLogRecord &record, uint8_t* out, size_t capacity);
+
+/**
+ * @brief Parse one frame starting at data[0] (the first sync byte)
+ * @return frame length, 0 if the bytes are not a valid frame
+ */
+size_t traceLogParseFrame(const uint8_t* data, size_t length, TraceLogRecord &record);
+
+#define TLOG(id, ...) \
+  do { \
+    if (traceLogEnabled(id)) { \
+      const TraceLogArg tlogArgs_[] = { 0, ##__VA_ARGS__ }; \
+      traceLogWrite((id), tlogArgs_ + 1, sizeof(tlogArgs_) / sizeof(tlogArgs_[0]) - 1); \
+    } \
+  } while (0)
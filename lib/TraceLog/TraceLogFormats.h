@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * Format table for the binary trace logger.
+ *
+ * Every log site is one entry: X(id, level, "format"). The device only
+ * stores the id and the raw argument words; the format string is applied
+ * on the host by tools/tracelog_decode, which includes this same table, so
+ * the two can never disagree about what an id means.
+ *
+ * Supported conversions: %d %u %x (32-bit integers), %f with optional
+ * precision such as %.2f (float), and %%. Strings cannot be deferred, so
+ * log an index or a code instead (e.g. a LiveNode or an HTTP status).
+ *
+ * Append new entries at the end: ids are positions in this table, and
+ * reordering breaks decoding of dumps captured from older firmware.
+ */
+
+enum TraceLogLevel {
+  TL_ERROR = 0,
+  TL_WARN  = 1,
+  TL_INFO  = 2,
+  TL_DEBUG = 3,
+  TL_LEVEL_COUNT
+};
+
+static const char* const TRACELOG_LEVEL_NAMES[TL_LEVEL_COUNT] = { "E", "W", "I", "D" };
+
+#define TRACELOG_FORMATS(X) \
+  X(TL_LOG_DROPPED,        TL_WARN,  "trace log overflow: %u records dropped on core %u") \
+  X(TL_LOG_LEVEL,          TL_ERROR, "log level set to %u") \
+  X(TL_AHT10_READING,      TL_DEBUG, "AHT10 temperature %.2f C, humidity %.2f %%") \
+  X(TL_AHT10_FAILED,       TL_WARN,  "AHT10 read failed") \
+  X(TL_MLX_READING,        TL_DEBUG, "MLX90614 ambient %.2f C, object %.2f C") \
+  X(TL_MLX_FAILED,         TL_WARN,  "MLX90614 read failed") \
+  X(TL_MPU_ACCEL,          TL_DEBUG, "MPU6050 acceleration X: %.3f, Y: %.3f, Z: %.3f m/s^2") \
+  X(TL_MPU_GYRO,           TL_DEBUG, "MPU6050 rotation X: %.4f, Y: %.4f, Z: %.4f rad/s") \
+  X(TL_MPU_TEMP,           TL_DEBUG, "MPU6050 temperature %.2f degC") \
+  X(TL_VIBRATION,          TL_DEBUG, "vibration dominant %.2f Hz, entropy %.3f") \
+  X(TL_SGP_READING,        TL_DEBUG, "SGP30 TVOC %u ppb, eCO2 %u ppm") \
+  X(TL_SGP_FAILED,         TL_WARN,  "SGP30 read failed") \
+  X(TL_SGP_BASELINE,       TL_INFO,  "SGP30 baseline eCO2 0x%x, TVOC 0x%x") \
+  X(TL_LIVE_UPLOADED,      TL_DEBUG, "live node %u uploaded") \
+  X(TL_LIVE_FAILED,        TL_WARN,  "live node %u upload failed (HTTP %d)") \
+  X(TL_ACTION_READ,        TL_DEBUG, "action_%u on=%u") \
+  X(TL_ACTION_FAILED,      TL_WARN,  "action_%u read failed (HTTP %d)") \
+  X(TL_ML_SAVED,           TL_INFO,  "ML record %u saved") \
+  X(TL_ML_FAILED,          TL_WARN,  "ML record save failed (HTTP %d)") \
+  X(TL_ML_ROTATED,         TL_INFO,  "ML rotation: exceeded %u entries, starting new cycle") \
+  X(TL_ML_BATCH_UPLOADED,  TL_INFO,  "ML chunk uploaded: %u samples in %u bytes") \
+  X(TL_ML_BATCH_FAILED,    TL_WARN,  "ML chunk upload failed (HTTP %d)") \
+  X(TL_ML_BATCH_DROPPED,   TL_WARN,  "ML batch full and upload pending - sample dropped") \
+  X(TL_ML_BATCH_OVERSIZE,  TL_ERROR, "ML chunk exceeds ML_CHUNK_BUFFER_BYTES - batch discarded") \
+  X(TL_UPLINK_METRICS,     TL_DEBUG, "uplink metrics uploaded") \
+  X(TL_UPLINK_METRICS_FAILED, TL_WARN, "uplink metrics upload failed (HTTP %d)") \
+  X(TL_TIME_REPORT_FAILED, TL_WARN,  "time sync report failed (HTTP %d)") \
+  X(TL_TRACE_FULL,         TL_WARN,  "sensor trace file limit reached - recording stopped") \
+  X(TL_TRACE_DROPPED,      TL_WARN,  "sensor trace dropped %u records") \
+  X(TL_SMS_SENT,           TL_INFO,  "SMS alert for action %u sent") \
+  X(TL_SMS_FAILED,         TL_WARN,  "SMS alert for action %u failed") \
+  X(TL_LINK_SWITCHED,      TL_WARN,  "uplink switched to %u (0 wifi, 1 gprs), switch #%u") \
+  X(TL_GPRS_ATTACH_FAILED, TL_WARN,  "GPRS bearer attach failed") \
+  X(TL_GPRS_SENT,          TL_INFO,  "GPRS batch sent: %u samples in %u bytes") \
+  X(TL_GPRS_FAILED,        TL_WARN,  "GPRS batch send failed, %u samples kept") \
+  X(TL_GPRS_OVERWRITTEN,   TL_WARN,  "GPRS batch full: %u samples overwritten so far") \
+  X(TL_CONFIG_LOADED,      TL_INFO,  "runtime config v%u active at boot (0 = built-in defaults)") \
+  X(TL_CONFIG_APPLIED,     TL_INFO,  "runtime config v%u applied") \
+  X(TL_CONFIG_REJECTED,    TL_WARN,  "runtime config v%u rejected: result %u") \
+  X(TL_BURST_STARTED,      TL_WARN,  "burst %u started: field %u at z=%.1f (value %.3f)") \
+  X(TL_BURST_ENDED,        TL_INFO,  "burst %u ended") \
+  X(TL_BURST_UPLOADED,     TL_INFO,  "burst %u chunk uploaded: %u samples in %u bytes") \
+  X(TL_BURST_FAILED,       TL_WARN,  "burst chunk upload failed (HTTP %d)") \
+  X(TL_BURST_DROPPED,      TL_WARN,  "burst ring overrun: %u samples lost so far") \
+  X(TL_HEAP_REPORT,        TL_INFO,  "heap: %u bytes free, largest block %u, fragmentation %.1f%%") \
+  X(TL_HEAP_REPORT_FAILED, TL_WARN,  "heap report upload failed (HTTP %d)") \
+  X(TL_COMMAND_EXECUTED,   TL_INFO,  "command seq %u (type %u) executed, %d ms after issue") \
+  X(TL_COMMAND_REJECTED,   TL_WARN,  "command seq %u rejected: result %u") \
+  X(TL_COMMAND_ACK_FAILED, TL_WARN,  "command seq %u ack upload failed (HTTP %d)") \
+  X(TL_MPU_IRQ_TIMEOUT,    TL_WARN,  "MPU6050 data-ready interrupt silent for %u ms, polling instead") \
+  X(TL_BURST_TRIGGER_FAILED, TL_WARN, "burst %u trigger upload failed (HTTP %d)")
+
+#define TRACELOG_ID(id, level, format) id,
+enum TraceLogFormatId : uint16_t {
+  TRACELOG_FORMATS(TRACELOG_ID)
+  TL_FORMAT_COUNT
+};
+#undef TRACELOG_ID
+
+#define TRACELOG_LEVEL(id, level, format) level,
+static const uint8_t TRACELOG_LEVELS[TL_FORMAT_COUNT] = { TRACELOG_FORMATS(TRACELOG_LEVEL) };
+#undef TRACELOG_LEVEL
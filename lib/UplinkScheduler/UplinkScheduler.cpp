@@ -0,0 +1,116 @@
+#include "UplinkScheduler.h"
+
+#include <string.h>
+
+// Wrap-safe "a is before b" for millis() timestamps
+static inline bool timeBefore(uint32_t a, uint32_t b) {
+  return (int32_t)(a - b) < 0;
+}
+
+
+UplinkScheduler::UplinkScheduler() {
+  memset(count_, 0, sizeof(count_));
+  for (int c = 0; c < UPLINK_CLASS_COUNT; c++) {
+    metrics_[c] = UplinkClassMetrics();   // Value-init zeroes the counters
+  }
+}
+
+
+bool UplinkScheduler::enqueue(uint8_t kind, UplinkClass jobClass, uint16_t param,
+                              uint32_t nowMs, uint32_t deadlineMs, uint8_t attempt) {
+  UplinkClassMetrics &m = metrics_[jobClass];
+
+  // Merge with an identical queued job: keep the original enqueue time so
+  // latency reflects how long the request really waited, and extend the
+  // deadline so a fresh live update is not dropped for an old one's lateness.
+  for (int i = 0; i < count_[jobClass]; i++) {
+    UplinkJob &queued = queue_[jobClass][i];
+    if (queued.kind == kind && queued.param == param) {
+      queued.deadlineMs = deadlineMs;
+      if (attempt > queued.attempt) {
+        queued.attempt = attempt;
+      }
+      m.merged++;
+      return true;
+    }
+  }
+
+  if (count_[jobClass] >= UPLINK_QUEUE_CAPACITY) {
+    m.overflowed++;
+    return false;
+  }
+
+  UplinkJob &job = queue_[jobClass][count_[jobClass]++];
+  job.kind = kind;
+  job.jobClass = jobClass;
+  job.param = param;
+  job.enqueuedMs = nowMs;
+  job.deadlineMs = deadlineMs;
+  job.attempt = attempt;
+
+  m.enqueued++;
+  m.depth = count_[jobClass];
+  if (m.depth > m.maxDepth) {
+    m.maxDepth = m.depth;
+  }
+  return true;
+}
+
+
+bool UplinkScheduler::next(uint32_t nowMs, UplinkJob &job) {
+  for (int c = 0; c < UPLINK_CLASS_COUNT; c++) {
+    // Live updates are superseded by the next one; sending a stale one only delays others
+    if (c == UPLINK_LIVE) {
+      for (int i = count_[c] - 1; i >= 0; i--) {
+        if (timeBefore(queue_[c][i].deadlineMs, nowMs)) {
+          removeAt(c, i);
+          metrics_[c].expired++;
+        }
+      }
+    }
+
+    if (count_[c] == 0) {
+      continue;
+    }
+
+    // Earliest deadline first within the class
+    int best = 0;
+    for (int i = 1; i < count_[c]; i++) {
+      if (timeBefore(queue_[c][i].deadlineMs, queue_[c][best].deadlineMs)) {
+        best = i;
+      }
+    }
+    job = queue_[c][best];
+    removeAt(c, best);
+    return true;
+  }
+  return false;
+}
+
+
+void UplinkScheduler::complete(const UplinkJob &job, uint32_t startMs, uint32_t endMs) {
+  UplinkClassMetrics &m = metrics_[job.jobClass];
+  m.executed++;
+  if (timeBefore(job.deadlineMs, endMs)) {
+    m.missedDeadline++;
+  }
+  m.waitMs.add((float)(startMs - job.enqueuedMs));
+  m.runMs.add((float)(endMs - startMs));
+}
+
+
+void UplinkScheduler::resetLatency() {
+  for (int c = 0; c < UPLINK_CLASS_COUNT; c++) {
+    metrics_[c].waitMs.reset();
+    metrics_[c].runMs.reset();
+  }
+}
+
+
+void UplinkScheduler::removeAt(int jobClass, int index) {
+  for (int i = index; i < count_[jobClass] - 1; i++) {
+    queue_[jobClass][i] = queue_[jobClass][i + 1];
+  }
+  count_[jobClass]--;
+  metrics_[jobClass].depth = count_[jobClass];
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <WindowStats.h>
+
+/**
+ * Priority-class uplink job queue.
+ *
+ * Jobs are small descriptors (kind + parameter); the work itself runs in
+ * the caller when the job is dequeued, so payloads are always built from
+ * the freshest data. Classes are served in strict priority order and jobs
+ * inside a class earliest-deadline-first. A job identical to one already
+ * queued in its class (same kind and param) is merged instead of queued
+ * twice. A retry carries its count in attempt rather than in param, so it
+ * still merges with a fresh request for the same thing.
+ *
+ * Not thread safe: callers on more than one task must serialise access.
+ */
+
+enum UplinkClass {
+  UPLINK_ALERT,     // SMS alerts - never dropped
+  UPLINK_COMMAND,   // Action/command polling
+  UPLINK_LIVE,      // Live Sensor_Data - dropped once past its deadline
+  UPLINK_BULK,      // ML records, status, metrics, backlog
+  UPLINK_CLASS_COUNT
+};
+
+#define UPLINK_QUEUE_CAPACITY 8   // Per class
+
+static const char* const UPLINK_CLASS_NAMES[UPLINK_CLASS_COUNT] = { "alert", "command", "live", "bulk" };
+
+struct UplinkJob {
+  uint8_t kind;          // Application-defined job type
+  uint8_t jobClass;      // UplinkClass
+  uint16_t param;        // Job argument (e.g. action index)
+  uint32_t enqueuedMs;
+  uint32_t deadlineMs;
+  uint8_t attempt;       // Retries so far (0 = first try); not part of the merge key
+};
+
+/**
+ * @brief Per-class counters and latency distribution
+ */
+struct UplinkClassMetrics {
+  uint16_t depth;
+  uint16_t maxDepth;
+  uint32_t enqueued;
+  uint32_t merged;       // Folded into an identical queued job
+  uint32_t overflowed;   // Rejected because the class queue was full
+  uint32_t expired;      // Dropped past deadline (live class only)
+  uint32_t dropped;      // Dequeued but not run (its link was down)
+  uint32_t executed;
+  uint32_t missedDeadline; // Executed, but after its deadline
+  WindowStats waitMs;    // Enqueue -> start of execution
+  WindowStats runMs;     // Execution time
+};
+
+class UplinkScheduler {
+public:
+  UplinkScheduler();
+
+  /**
+   * @brief Queue a job (or merge it with an identical queued one)
+   * A merge keeps the higher attempt, so retries stay bounded.
+   * @return false if the class queue is full
+   */
+  bool enqueue(uint8_t kind, UplinkClass jobClass, uint16_t param,
+               uint32_t nowMs, uint32_t deadlineMs, uint8_t attempt = 0);
+
+  /**
+   * @brief Pop the most urgent job, discarding stale live updates
+   * @return false if nothing is runnable
+   */
+  bool next(uint32_t nowMs, UplinkJob &job);
+
+  /**
+   * @brief Record that a job returned by next() has finished
+   */
+  void complete(const UplinkJob &job, uint32_t startMs, uint32_t endMs);
+
+  /**
+   * @brief Record that a job returned by next() was discarded without running
+   */
+  void drop(const UplinkJob &job) { metrics_[job.jobClass].dropped++; }
+
+  const UplinkClassMetrics &metrics(UplinkClass jobClass) const { return metrics_[jobClass]; }
+
+  /**
+   * @brief Reset the latency distributions (counters keep running)
+   */
+  void resetLatency();
+
+private:
+  UplinkJob queue_[UPLINK_CLASS_COUNT][UPLINK_QUEUE_CAPACITY];
+  uint8_t count_[UPLINK_CLASS_COUNT];
+  UplinkClassMetrics metrics_[UPLINK_CLASS_COUNT];
+
+  void removeAt(int jobClass, int index);
+};
@@ -0,0 +1,172 @@
+#include "VibrationFeatures.h"
+
+#include <math.h>
+#include <string.h>
+
+// Use the ESP32 optimised esp-dsp kernels when building for the target,
+// otherwise fall back to a portable radix-2 implementation.
+#if defined(ESP_PLATFORM) && defined(__has_include)
+  #if __has_include(<esp_dsp.h>)
+    #include <esp_dsp.h>
+    #define VIBRATION_USE_ESP_DSP 1
+  #endif
+#endif
+#ifndef VIBRATION_USE_ESP_DSP
+  #define VIBRATION_USE_ESP_DSP 0
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Working buffers are static so nothing is allocated per window
+static float fftData[2 * VIBRATION_FFT_SIZE];   // Interleaved re/im
+static float hannWindow[VIBRATION_FFT_SIZE];
+static bool vibrationReady = false;
+
+#if !VIBRATION_USE_ESP_DSP
+static float twiddleCos[VIBRATION_FFT_SIZE / 2];
+static float twiddleSin[VIBRATION_FFT_SIZE / 2];
+#endif
+
+
+bool vibrationInit() {
+  if (vibrationReady) {
+    return true;
+  }
+
+#if VIBRATION_USE_ESP_DSP
+  if (dsps_fft2r_init_fc32(NULL, VIBRATION_FFT_SIZE) != ESP_OK) {
+    return false;
+  }
+  dsps_wind_hann_f32(hannWindow, VIBRATION_FFT_SIZE);
+#else
+  for (int k = 0; k < VIBRATION_FFT_SIZE / 2; k++) {
+    double angle = 2.0 * M_PI * k / VIBRATION_FFT_SIZE;
+    twiddleCos[k] = (float)cos(angle);
+    twiddleSin[k] = (float)sin(angle);
+  }
+  // Symmetric Hann (divides by N - 1), as esp-dsp's dsps_wind_hann_f32() does, so host and device match
+  for (int i = 0; i < VIBRATION_FFT_SIZE; i++) {
+    hannWindow[i] = 0.5f - 0.5f * (float)cos(2.0 * M_PI * i / (VIBRATION_FFT_SIZE - 1));
+  }
+#endif
+
+  vibrationReady = true;
+  return true;
+}
+
+
+const char* vibrationBackend() {
+  return VIBRATION_USE_ESP_DSP ? "esp-dsp" : "portable";
+}
+
+
+void vibrationFft(float* data, int n) {
+#if VIBRATION_USE_ESP_DSP
+  dsps_fft2r_fc32(data, n);
+  dsps_bit_rev_fc32(data, n);
+#else
+  // Bit-reversal permutation
+  for (int i = 1, j = 0; i < n; i++) {
+    int bit = n >> 1;
+    for (; j & bit; bit >>= 1) {
+      j ^= bit;
+    }
+    j ^= bit;
+    if (i < j) {
+      float tr = data[2 * i];
+      float ti = data[2 * i + 1];
+      data[2 * i] = data[2 * j];
+      data[2 * i + 1] = data[2 * j + 1];
+      data[2 * j] = tr;
+      data[2 * j + 1] = ti;
+    }
+  }
+
+  // Iterative radix-2 butterflies, W = exp(-j*2*pi*k/len)
+  for (int len = 2; len <= n; len <<= 1) {
+    int half = len >> 1;
+    int stride = VIBRATION_FFT_SIZE / len;
+    for (int start = 0; start < n; start += len) {
+      for (int k = 0; k < half; k++) {
+        float wr = twiddleCos[k * stride];
+        float wi = -twiddleSin[k * stride];
+        int a = 2 * (start + k);
+        int b = 2 * (start + k + half);
+        float xr = data[b] * wr - data[b + 1] * wi;
+        float xi = data[b] * wi + data[b + 1] * wr;
+        data[b] = data[a] - xr;
+        data[b + 1] = data[a + 1] - xi;
+        data[a] += xr;
+        data[a + 1] += xi;
+      }
+    }
+  }
+#endif
+}
+
+
+void vibrationCompute(const float* samples, float sampleRateHz, VibrationFeatures &out) {
+  memset(&out, 0, sizeof(out));
+  if (!vibrationReady && !vibrationInit()) {
+    return;
+  }
+
+  const int n = VIBRATION_FFT_SIZE;
+
+  // Remove DC (gravity) so it doesn't dominate the spectrum
+  float mean = 0.0f;
+  for (int i = 0; i < n; i++) {
+    mean += samples[i];
+  }
+  mean /= (float)n;
+
+  float sumSquares = 0.0f;
+  for (int i = 0; i < n; i++) {
+    float centred = samples[i] - mean;
+    sumSquares += centred * centred;
+    fftData[2 * i] = centred * hannWindow[i];
+    fftData[2 * i + 1] = 0.0f;
+  }
+  out.rms = sqrtf(sumSquares / (float)n);
+
+  vibrationFft(fftData, n);
+
+  // One-sided power spectrum, skipping the DC bin
+  const float binHz = sampleRateHz / (float)n;
+  float totalPower = 0.0f;
+  int dominantBin = 0;
+  for (int k = 1; k <= n / 2; k++) {
+    float re = fftData[2 * k];
+    float im = fftData[2 * k + 1];
+    float power = re * re + im * im;
+    fftData[k] = power;   // Reuse the low half of the buffer for the spectrum
+    totalPower += power;
+
+    if (power > out.dominantPower) {
+      out.dominantPower = power;
+      dominantBin = k;
+    }
+
+    float freq = k * binHz;
+    int band = 0;
+    while (band + 1 < VIBRATION_BAND_COUNT && freq >= VIBRATION_BAND_EDGES_HZ[band + 1]) {
+      band++;
+    }
+    out.bandEnergy[band] += power;
+  }
+  out.dominantHz = dominantBin * binHz;
+
+  // Spectral entropy, normalised by log(bin count) so it stays in 0..1
+  if (totalPower > 0.0f) {
+    float entropy = 0.0f;
+    for (int k = 1; k <= n / 2; k++) {
+      float p = fftData[k] / totalPower;
+      if (p > 0.0f) {
+        entropy -= p * logf(p);
+      }
+    }
+    out.spectralEntropy = entropy / logf((float)(n / 2));
+  }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdint.h>
+
+// ===================== VIBRATION FEATURE CONFIGURATION =====================
+
+// FFT block length (power of two). 128 samples at 100 Hz = 1.28 s window.
+#ifndef VIBRATION_FFT_SIZE
+#define VIBRATION_FFT_SIZE 128
+#endif
+
+// Lower edges of the reported energy bands in Hz; the last band runs to Nyquist.
+// Band 1 (4-12 Hz) covers the physiological/pathological tremor range.
+#define VIBRATION_BAND_COUNT 4
+static const float VIBRATION_BAND_EDGES_HZ[VIBRATION_BAND_COUNT] = { 0.0f, 4.0f, 12.0f, 25.0f };
+
+// ========================================================================== //
+
+/**
+ * @brief Spectral features of one block of accelerometer samples
+ */
+struct VibrationFeatures {
+  float dominantHz;                          // Frequency of the strongest non-DC bin
+  float dominantPower;                       // Power of that bin
+  float bandEnergy[VIBRATION_BAND_COUNT];    // Summed power per band
+  float spectralEntropy;                     // Normalised Shannon entropy, 0 (pure tone) .. 1 (white)
+  float rms;                                 // RMS of the block after DC removal
+};
+
+/**
+ * @brief Prepare FFT tables and the analysis window. Call once before use.
+ * @return false if the DSP backend could not be initialised
+ */
+bool vibrationInit();
+
+/**
+ * @brief Name of the FFT backend compiled in ("esp-dsp" or "portable")
+ */
+const char* vibrationBackend();
+
+/**
+ * @brief In-place forward complex FFT, natural-order output
+ * @param data interleaved re/im pairs, 2 * n floats
+ * @param n    number of complex points (power of two, <= VIBRATION_FFT_SIZE)
+ */
+void vibrationFft(float* data, int n);
+
+/**
+ * @brief Compute spectral features of VIBRATION_FFT_SIZE real samples
+ * @param samples      input block (not modified)
+ * @param sampleRateHz rate the block was captured at
+ * @param out          filled with the block's features
+ */
+void vibrationCompute(const float* samples, float sampleRateHz, VibrationFeatures &out);
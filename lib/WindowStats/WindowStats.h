@@ -0,0 +1,86 @@
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+
+/**
+ * @brief Streaming min/max/mean/variance accumulator for one sensor field
+ *
+ * Uses Welford's online algorithm, so memory stays O(1) per field no matter
+ * how many samples land in an upload window. All math is single precision
+ * to stay on the ESP32 hardware FPU.
+ */
+struct WindowStats {
+  uint32_t count;
+  float minValue;
+  float maxValue;
+  float mean;
+  float m2;   // Sum of squared deviations from the running mean
+
+  WindowStats() { reset(); }
+
+  /**
+   * @brief Clear the accumulator at the start of a new window
+   */
+  void reset() {
+    count = 0;
+    minValue = 0.0f;
+    maxValue = 0.0f;
+    mean = 0.0f;
+    m2 = 0.0f;
+  }
+
+  /**
+   * @brief Fold one sample into the window (NaN readings are ignored)
+   */
+  void add(float value) {
+    if (isnan(value)) {
+      return;
+    }
+
+    count++;
+    if (count == 1) {
+      minValue = value;
+      maxValue = value;
+    } else {
+      if (value < minValue) minValue = value;
+      if (value > maxValue) maxValue = value;
+    }
+
+    float delta = value - mean;
+    mean += delta / (float)count;
+    m2 += delta * (value - mean);
+  }
+
+  /**
+   * @brief Fold another window's samples into this one (pairwise Welford update)
+   */
+  void merge(const WindowStats &other) {
+    if (other.count == 0) {
+      return;
+    }
+    if (count == 0) {
+      *this = other;
+      return;
+    }
+
+    uint32_t total = count + other.count;
+    float delta = other.mean - mean;
+    mean += delta * (float)other.count / (float)total;
+    m2 += other.m2 + delta * delta * (float)count * (float)other.count / (float)total;
+    if (other.minValue < minValue) minValue = other.minValue;
+    if (other.maxValue > maxValue) maxValue = other.maxValue;
+    count = total;
+  }
+
+  /**
+   * @brief Sample variance of the window (0 with fewer than two samples)
+   */
+  float variance() const {
+    return (count > 1) ? m2 / (float)(count - 1) : 0.0f;
+  }
+
+  float stddev() const {
+    return sqrtf(variance());
+  }
+};
@@ -1,11 +1,7 @@
 #include <Arduino.h>
 
 #include <Wire.h>
-#include <Adafruit_MLX90614.h>
-#include <Adafruit_AHTX0.h>
-#include <Adafruit_MPU6050.h>
 #include <Adafruit_Sensor.h>
-#include <Adafruit_SGP30.h>
 
 #include <HardwareSerial.h>
 
@@ -14,10 +10,45 @@
 #include "addons/TokenHelper.h"
 #include "addons/RTDBHelper.h"
 #include <time.h>
+#include <esp_sntp.h>
+#include <esp_sleep.h>
+#include <sys/time.h>
+#include <LittleFS.h>
+
+#include <WindowStats.h>
+#include <VibrationFeatures.h>
+#include <Telemetry.h>
+#include <MlBatch.h>
+#include <SensorRegistry.h>
+#include <DataReadyTiming.h>
+#include <SensorTrace.h>
+#include <UplinkScheduler.h>
+#include <TimeService.h>
+#include <TraceLog.h>
+#include <DutyCycle.h>
+#include <Sim800.h>
+#include <GprsBatch.h>
+#include <LinkSelector.h>
+#include <RuntimeConfig.h>
+#include <Preferences.h>
+#include <AnomalyDetector.h>
+#include <BurstRecorder.h>
+#include <CommandProtocol.h>
+#include <FixedString.h>
+#include <StaticPool.h>
+#include <esp_heap_caps.h>
 
 
 // ===================== CONFIGURE HERE =====================
 
+// Fitted Sensors
+// Set a sensor to 0 to build without it: its library is not compiled in, nothing probes it
+// at boot, and it is reported as "Not Fitted" with no live, ML or chunk fields
+#define SENSOR_AHT10     1
+#define SENSOR_MLX90614  1
+#define SENSOR_MPU6050   1
+#define SENSOR_SGP30     1
+
 // Serial Debug Output Control
 // Set to 1 to enable serial output, 0 to disable (saves performance)
 #define ENABLE_SERIAL_DEBUG 0
@@ -33,6 +64,59 @@
   #define DEBUG_PRINTF(fmt, ...)
 #endif
 
+// Binary Trace Log
+// Sensor and uplink events are logged as compact binary frames (format id + raw args) and
+// written to the serial port by a low-priority task; decode a capture on the host with
+// tools/tracelog_decode. Send '0'..'3' on the serial console to change the level at runtime
+// (0 = errors, 1 = warnings, 2 = info, 3 = every reading).
+#define ENABLE_TRACE_LOG      1
+#define TRACE_LOG_LEVEL       TL_WARN
+#define TRACE_LOG_DRAIN_MS    100
+
+#if !ENABLE_TRACE_LOG
+  #undef TLOG
+  #define TLOG(id, ...)
+#endif
+
+// Vibration Feature Extraction
+// Set to 1 to capture a VIBRATION_FFT_SIZE accelerometer block every sensor cycle and
+// upload dominant frequency, band energies and spectral entropy (adds ~1.3 s per cycle)
+#define ENABLE_VIBRATION_FEATURES 0
+#define VIBRATION_SAMPLE_RATE_HZ  100  // Block sampling rate; MPU6050 DLPF is opened to 44 Hz
+
+#if ENABLE_VIBRATION_FEATURES && !SENSOR_MPU6050
+  #error "ENABLE_VIBRATION_FEATURES needs SENSOR_MPU6050"
+#endif
+
+// MPU6050 Data-Ready Interrupt
+// The MPU6050 INT pin pulses whenever a new sample is latched, at MPU_SAMPLE_RATE_HZ.
+// MPU_INT_WIRED is a board option: set it to 1 only if INT is wired to MPU_INT_PIN. Shipped boards
+// leave the pin unconnected, so by default DATA_RDY is not enabled and no ISR is attached (a
+// floating pin would fire it on noise). With INT wired, ENABLE_MPU_INTERRUPT 1 has the sensor task
+// sleep on that interrupt before every IMU read, so vibration blocks follow the sensor's clock;
+// 0 polls on the task's own timer. The ISR timestamps samples in both modes, so mpu/* in
+// Uplink_Metrics compares the two.
+#define MPU_INT_WIRED         0
+#define ENABLE_MPU_INTERRUPT  0
+#define MPU_INT_PIN           27
+
+#if ENABLE_MPU_INTERRUPT && !MPU_INT_WIRED
+  #error "ENABLE_MPU_INTERRUPT needs MPU_INT_WIRED (INT connected to MPU_INT_PIN)"
+#endif
+#define MPU_SAMPLE_RATE_HZ    VIBRATION_SAMPLE_RATE_HZ  // 1 kHz DLPF rate / whole divider
+
+#if 1000 % MPU_SAMPLE_RATE_HZ
+  #error "MPU_SAMPLE_RATE_HZ must divide 1000"
+#endif
+
+// Sensor Trace Recording
+// Set to 1 to record every raw reading to LittleFS (/trace.bin) for replay on the host.
+// The previous boot's trace is kept as /trace_prev.bin. On the serial console send
+// 'd' to dump the current trace, 'p' the previous one, 'x' to erase both.
+#define ENABLE_TRACE_RECORDING 0
+#define TRACE_MAX_FILE_BYTES   (512 * 1024)
+#define TRACE_BUFFER_BYTES     2048   // RAM staging between sensor task and flash writes
+
 // ===================== DEVICE CONFIGURATION =====================
 #define WIFI_SSID      "2263081slt"
 #define WIFI_PASSWORD  "199202FJ5"
@@ -46,6 +130,106 @@
 #define USER_NAME      "User1"
 
 #define TARGET_PHONE_NUMBER "+94769054603"
+#define SMS_ALERT_RETRIES   2   // Re-queue a failed alert this many times (timing: tools/gprs_sim/alert_latency_bench)
+
+// Runtime Configuration
+// The sensor/uplink periods, ML rotation size, phone number, SMS retries and trace level
+// here are defaults: a versioned document at <USER>/Config overrides them without a
+// reflash (keys and ranges in lib/RuntimeConfig, check a document with
+// tools/runtime_config). The last applied document is kept in NVS, so a reboot starts
+// with it instead of waiting for the network. The outcome of each document goes to
+// <USER>/Config_Status.
+#define SENSOR_PERIOD_MS      2600    // TaskSensorReadings acquisition cycle
+#define MAX_ML_RECORDS        100     // ML_Training_Data rotation size
+#define CONFIG_POLL_MS        30000   // How often <USER>/Config/version is checked
+#define CONFIG_NVS_NAMESPACE  "vitalshield"
+
+// Command Protocol
+// Operators send versioned command envelopes to <USER>/Command ("1;<seq>;<type>;<issued_ms>;
+// <expires_ms>;<params>", see lib/CommandProtocol) and the device acknowledges each one with
+// its result and execution time at <USER>/Command_Ack; tools/command_rtt measures the round
+// trip. The envelope is polled with the actions. "action" commands write through to
+// Actions/action_n, so dashboards that still use those nodes keep working during the
+// migration; set to 0 once nothing writes them directly any more.
+#define ENABLE_LEGACY_ACTIONS  1
+
+// Time Synchronisation
+// SNTP runs in the background; samples are stamped from the monotonic timer
+#define NTP_RESYNC_INTERVAL_MS  (15 * 60 * 1000)  // Background SNTP resync period
+
+// Uplink Scheduling (default periods at which TaskFirebaseSender queues each job)
+#define UPLINK_LIVE_PERIOD_MS     5000    // Live Sensor_Data; stale updates are dropped
+#define UPLINK_ML_PERIOD_MS       5000    // ML_Training_Data record
+#define UPLINK_ACTION_POLL_MS     5000    // Actions/action_n polling
+#define UPLINK_METRICS_PERIOD_MS  60000   // Uplink_Metrics report
+#define UPLINK_ALERT_DEADLINE_MS  30000
+#define UPLINK_BULK_DEADLINE_MS   60000
+
+// Columnar ML Batching
+// 0 = one ML_Training_Data/record_NNN document per sample (legacy layout)
+// K = collect K samples and upload one ML_Training_Chunks/chunk_NNN column document
+//     (K <= ML_BATCH_CAPACITY; decode with tools/ml_chunks/decode_ml_chunks.py)
+#define ML_BATCH_SIZE          0
+#define ML_CHUNK_BUFFER_BYTES  12288
+
+// Deep-Sleep Duty Cycle (battery units)
+// Set to 1 to deep-sleep between samples instead of running the always-on tasks. Each wake
+// reads AHT10, MLX90614 and MPU6050 once into an RTC-memory buffer; every
+// DUTY_CYCLE_UPLOAD_EVERY wakes Wi-Fi comes up, the buffer is uploaded as
+// ML_Training_Chunks documents and wake latency / energy per sample go to <USER>/Duty_Cycle.
+// The SGP30 is skipped (its IAQ algorithm needs a measurement every second) and actions
+// are not polled. Size the schedule with tools/duty_cycle_sim.
+#define ENABLE_DUTY_CYCLE           0
+#define DUTY_CYCLE_PERIOD_MS        60000
+#define DUTY_CYCLE_UPLOAD_EVERY     10
+#define DUTY_CYCLE_RADIO_TIMEOUT_MS 10000  // Per step: Wi-Fi, NTP, Firebase sign-in
+// Average phase currents for the energy estimate - measure your board and adjust
+#define DUTY_SUPPLY_V               3.7f
+#define DUTY_ACTIVE_MA              40.0f  // Boot + sensing, radio off
+#define DUTY_RADIO_MA               120.0f // Wi-Fi up
+#define DUTY_SLEEP_MA               0.8f   // Deep sleep incl. sensors and regulator
+
+// GPRS Fallback Uplink
+// Set to 1 to keep data flowing over the SIM800A's GPRS bearer while Wi-Fi is down. On the
+// fallback the Firebase jobs pause; a sample is buffered every UPLINK_ML_PERIOD_MS and every
+// GPRS_BATCH_PERIOD_MS the buffer goes out as one binary GprsBatch frame over TCP to
+// GPRS_SINK_HOST:GPRS_SINK_PORT (see tools/gprs_sim for the frame format and a test sink).
+#define ENABLE_GPRS_FALLBACK   0
+#define GPRS_APN               "internet"       // Operator APN
+#define GPRS_SINK_HOST         "203.0.113.10"   // Batch receiver (tools/gprs_sim/tcp_sink)
+#define GPRS_SINK_PORT         9000
+#define GPRS_BATCH_PERIOD_MS   60000
+#define GPRS_FAILOVER_MS       30000   // Wi-Fi down this long before switching to GPRS
+#define GPRS_RECOVER_MS        15000   // Wi-Fi back this long before switching back
+
+// Anomaly-Triggered Bursts
+// Every acquisition cycle is scored per field against an EWMA mean/stddev (lib/AnomalyBurst).
+// A z-score of ANOMALY_Z_TENTHS / 10 or more starts a burst: the sensor task runs every
+// BURST_SENSOR_PERIOD_MS and every sample, plus the BURST_PRE_TRIGGER_ROWS cycles before the
+// trigger, goes to <USER>/Anomaly_Bursts/burst_NNN as ML chunk documents until BURST_MS after
+// the last anomaly. Threshold and timings are runtime config defaults. Try settings on a
+// recorded trace with tools/trace_replay --burst.
+#define ENABLE_ANOMALY_BURST      1
+#define ANOMALY_Z_TENTHS          50      // z >= 5.0
+#define ANOMALY_EWMA_ALPHA        0.05f   // ~40 cycles of memory
+#define ANOMALY_WARMUP_SAMPLES    20      // Per field, before it can trigger
+#define BURST_MS                  30000
+#define BURST_MAX_MS              120000  // Extensions stop this long after the trigger
+#define BURST_SENSOR_PERIOD_MS    1000
+#define BURST_PRE_TRIGGER_ROWS    12
+#define BURST_UPLOAD_PERIOD_MS    3000
+#define BURST_CHUNK_ROWS          12      // Samples per Anomaly_Bursts chunk (<= ML_BATCH_CAPACITY)
+#define MAX_ANOMALY_BURSTS        20      // Anomaly_Bursts rotation size
+
+// Static Memory Plan
+// Task stacks, the serial mutex and per-job scratch (JSON documents, chunk text, encode
+// batches) are reserved at build time instead of coming from the heap. Every metrics period
+// <USER>/Heap_Report records free heap, the largest free block (its decline is fragmentation),
+// stack headroom and pool use. tools/memory_soak checks the per-cycle code for heap allocations.
+#define SENSOR_TASK_STACK       8192    // Bytes; several sensor libraries
+#define SENDER_TASK_STACK       12288   // Bytes; TLS and Firebase client
+#define TRACE_DRAIN_TASK_STACK  2048    // Bytes
+#define UPLINK_JSON_POOL        2       // FirebaseJson documents one job holds at once
 
 // LED Pin Configuration
 #define LED_STATUS_PIN   14   // D14 - Status LED (always on)
@@ -60,72 +244,268 @@ FirebaseAuth auth;
 FirebaseConfig config;
 
 // --- Sensor objects ---
-Adafruit_MLX90614 mlx = Adafruit_MLX90614();
+// One driver per sensor (see SensorRegistry.h), in SensorSample order; an unfitted
+// sensor is a NotFitted placeholder and its library is never included
+#if SENSOR_AHT10
+#include <Adafruit_AHTX0.h>
 Adafruit_AHTX0 aht;
+struct Aht10Driver {
+  static const LiveNode NODE = LIVE_AHT10;
+  static const bool FITTED = true;
+  static bool begin();
+  static bool read(SensorSample &s);
+};
+#else
+typedef NotFitted<LIVE_AHT10> Aht10Driver;
+#endif
+
+#if SENSOR_MLX90614
+#include <Adafruit_MLX90614.h>
+Adafruit_MLX90614 mlx = Adafruit_MLX90614();
+struct Mlx90614Driver {
+  static const LiveNode NODE = LIVE_MLX90614;
+  static const bool FITTED = true;
+  static bool begin();
+  static bool read(SensorSample &s);
+};
+#else
+typedef NotFitted<LIVE_MLX90614> Mlx90614Driver;
+#endif
+
+#if SENSOR_MPU6050
+#include <Adafruit_MPU6050.h>
 Adafruit_MPU6050 mpu;
+struct Mpu6050Driver {
+  static const LiveNode NODE = LIVE_MPU6050;
+  static const bool FITTED = true;
+  static bool begin();
+  static bool read(SensorSample &s);
+};
+#else
+typedef NotFitted<LIVE_MPU6050> Mpu6050Driver;
+#endif
+
+#if SENSOR_SGP30
+#include <Adafruit_SGP30.h>
 Adafruit_SGP30 sgp;
+struct Sgp30Driver {
+  static const LiveNode NODE = LIVE_SGP30;
+  static const bool FITTED = true;
+  static bool begin();
+  static bool read(SensorSample &s);
+};
+#else
+typedef NotFitted<LIVE_SGP30> Sgp30Driver;
+#endif
+
+typedef SensorRegistry<Aht10Driver, Mlx90614Driver, Mpu6050Driver, Sgp30Driver> Sensors;
 
 // --- SIM800A objects ---
 HardwareSerial simSerial(2); // Define the serial port for SIM800A, using UART2, RX2=16, TX2=17
+StreamModemPort modemPort(simSerial);
+Sim800 modem(modemPort);     // Only used from setup() and TaskFirebaseSender
 
 // --- Global Variables ---
-float ambient;
-float object;
-float relative_humidity;
-float temperature;
-float accelerationX, accelerationY, accelerationZ;
-float gyroX, gyroY, gyroZ; 
-float temperatureMPU;
-String Action_1, Action_2, Action_3, Action_4, Action_5;
-
-// SGP30 Gas Sensor Variables
-uint16_t TVOC = 0;  // Total Volatile Organic Compounds (ppb)
-uint16_t eCO2 = 0;  // Equivalent CO2 (ppm)
-
-// Sensor Status Variables
-String status_AHT10 = "Initializing";
-String status_MLX90614 = "Initializing";
-String status_MPU6050 = "Initializing";
-String status_SGP30 = "Initializing";
+SensorSample readings = {};    // Latest value of every field (guarded by windowMux)
+uint8_t workingSensors = 0;    // SensorBit mask of the sensors that answered at boot
+
+// Fixed-capacity text instead of String, so the globals never touch the heap
+typedef FixedString<7> ActionText;    // "ON" / "OFF" from Actions/action_n
+ActionText Action_1, Action_2, Action_3, Action_4, Action_5;
+
+// Windowed aggregation - one accumulator per uploaded field (WindowField), reset every ML upload
+WindowStats windowStats[WF_COUNT];
+portMUX_TYPE windowMux = portMUX_INITIALIZER_UNLOCKED; // Sensor task (core 1) writes, sender (core 0) drains
+
+// Latest vibration spectrum (guarded by windowMux)
+VibrationFeatures vibration;
+bool vibrationValid = false;
+
+#if SENSOR_MPU6050
+// MPU6050 data-ready ISR state, and IMU read timing against it
+volatile uint32_t mpuReadyCount = 0;
+volatile int64_t mpuReadyUs = 0;
+portMUX_TYPE mpuReadyMux = portMUX_INITIALIZER_UNLOCKED;
+DataReadyTiming mpuTiming(1000000 / MPU_SAMPLE_RATE_HZ); // Sensor task only
+DataReadyStats mpuStats;                                 // Guarded by windowMux
+uint32_t mpuIrqTimeouts = 0;
+#endif
+
+// Trace recorder staging buffer (sensor task appends, sender task flushes to flash)
+uint8_t traceBuffer[TRACE_BUFFER_BYTES];
+size_t traceBufferUsed = 0;
+uint64_t traceLastUs = 0;
+uint32_t traceDropped = 0;
+bool traceActive = false;
+portMUX_TYPE traceMux = portMUX_INITIALIZER_UNLOCKED;
+SemaphoreHandle_t traceFileMutex;        // Sender flush vs. console dump/erase of the trace files
+StaticSemaphore_t traceFileMutexBuffer;
+
+// Uplink job kinds dispatched by TaskFirebaseSender
+enum UplinkJobKind {
+  JOB_SENSOR_STATUS,
+  JOB_LIVE_DATA,
+  JOB_ML_RECORD,
+  JOB_READ_ACTIONS,
+  JOB_SMS_ALERT,
+  JOB_UPLINK_METRICS,
+  JOB_TIME_SYNC_REPORT,
+  JOB_GPRS_BATCH,
+  JOB_CONFIG_POLL,
+  JOB_BURST_UPLOAD,
+  JOB_HEAP_REPORT,
+  JOB_READ_COMMAND
+};
+UplinkScheduler uplink;
+portMUX_TYPE uplinkMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Monotonic-to-epoch clock fed by background SNTP (guarded by timeMux)
+TimeService timeService;
+portMUX_TYPE timeMux = portMUX_INITIALIZER_UNLOCKED;
+int64_t acquisitionEpochUs = 0; // Stamp of the latest sensor cycle (guarded by windowMux)
+
+// Active runtime configuration. Replaced as a whole by the sender task, which may read it
+// directly; other tasks take a copy with configSnapshot().
+RuntimeConfig runtimeConfig;
+portMUX_TYPE configMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Command protocol state (sender task only)
+uint32_t commandLastSeq = 0;      // Last executed seq, kept in NVS across reboots
+uint32_t commandsExecuted = 0;
+uint32_t commandsRejected = 0;
+WindowStats commandLatencyMs;     // Issue to execution, reset every metrics report
+
+// Serialises raw binary output (trace log frames, trace dumps) on the debug port
+SemaphoreHandle_t serialTxMutex;
+StaticSemaphore_t serialTxMutexBuffer;
+
+// Task stacks and control blocks; the handles feed the stack report
+StackType_t sensorTaskStack[SENSOR_TASK_STACK];
+StackType_t senderTaskStack[SENDER_TASK_STACK];
+StaticTask_t sensorTaskBuffer;
+StaticTask_t senderTaskBuffer;
+TaskHandle_t sensorTaskHandle = NULL;
+TaskHandle_t senderTaskHandle = NULL;
+#if ENABLE_TRACE_LOG
+StackType_t traceDrainTaskStack[TRACE_DRAIN_TASK_STACK];
+StaticTask_t traceDrainTaskBuffer;
+TaskHandle_t traceDrainTaskHandle = NULL;
+#endif
+
+// Per-job scratch, leased by the sender task (and by the duty-cycle upload, which runs
+// before any task exists)
+struct ChunkText {
+  char text[ML_CHUNK_BUFFER_BYTES];
+  void clear() { text[0] = '\0'; }
+};
+StaticPool<FirebaseJson, UPLINK_JSON_POOL> jsonPool;
+StaticPool<ChunkText, 1> chunkPool;
+StaticPool<MlBatch, 1> batchPool;
+typedef PoolLease<FirebaseJson, UPLINK_JSON_POOL> JsonLease;
+typedef PoolLease<ChunkText, 1> ChunkLease;
+typedef PoolLease<MlBatch, 1> BatchLease;
+
+#if ENABLE_DUTY_CYCLE
+// Sample buffer and wake bookkeeping kept in RTC memory across deep sleep
+RTC_DATA_ATTR DutyCycleState dutyState;
+#endif
+
+#if ENABLE_GPRS_FALLBACK
+// Active uplink and the samples waiting for the next GPRS batch (sender task only)
+LinkSelector linkSelector(GPRS_FAILOVER_MS, GPRS_RECOVER_MS);
+GprsBatch gprsBatch;
+#endif
+
+#if ENABLE_ANOMALY_BURST
+// Field scores (sensor task only) and the pre-trigger/burst ring (sensor task writes,
+// sender task uploads; guarded by burstMux)
+AnomalyDetector anomalyDetector(ANOMALY_EWMA_ALPHA, ANOMALY_WARMUP_SAMPLES);
+BurstRecorder burstRecorder;
+portMUX_TYPE burstMux = portMUX_INITIALIZER_UNLOCKED;
+#endif
 
 // ML Training data tracking
-int mlDataCount = 0;
-const int MAX_ML_RECORDS = 100;
+int mlDataCount = 0; // Record number claimed for the next write, 0 if none
 unsigned long firstRecordTime = 0;
 
 // --- Task Prototypes ---
 void TaskSensorReadings(void * parameter);
 void TaskFirebaseSender(void * parameter);
+void TaskTraceLogDrain(void * parameter);
 
 // --- Function Prototypes ---
-void initMLX90614();
-void readMLX90614();
-void initFirebase();
-void initWifi();
-void initAHT10();
-void readAHT10();
-void initMPU6050();
-void readMPU6050();
-void initSGP30();
-void readSGP30();
+bool initFirebase(uint32_t timeoutMs = 0);
+bool initWifi(uint32_t timeoutMs = 0);
+void readVibrationFeatures();
+void IRAM_ATTR onMpuDataReady();
+bool mpuEnableDataReady();
+DataReadyEdge mpuDataReadyEdge();
+void mpuWaitDataReady();
+void mpuRecordRead(const DataReadyEdge &edge);
+void initTraceRecorder();
+void traceRecord(TraceSensor sensor, const float* values);
+void flushTraceToFile();
+void handleSerialConsole();
 void readFirebaseActions();
 void saveFirebaseActions();
 void saveToFirestore();
-void getFormattedDateTime(char* buffer, size_t bufferSize);
 void manageMLDataRotation();
+int advanceMLCounter(const char* countKey, const char* dataNode, int maxEntries);
+void saveToMlBatch();
+void recordReadings(const SensorSample &cycle, uint8_t readMask);
+void takeWindowSnapshot(WindowStats* snapshot);
+void restoreWindowSnapshot(const WindowStats* snapshot);
+SensorSample captureSample();
+uint8_t workingSensorMask();
 void syncTimeWithNTP();
+void onSntpSync(struct timeval* tv);
+int64_t epochMicros();
+void uploadTimeSyncQuality();
 void updateSensorStatusToFirebase();
 void initLEDs();
 void ledDataBlink();
 void sim800a_init();
-void send_sms(String phoneNumber, String message);
-bool checkResponse(String expected, unsigned int timeout);
+bool send_sms(const char* phoneNumber, const char* message);
 void Alert_MSG();
+void sendActionAlert(int actionIndex, uint8_t attempt);
+bool uplinkEnqueue(UplinkJobKind kind, UplinkClass jobClass, uint16_t param, uint32_t deadlineInMs, uint8_t attempt = 0);
+bool periodElapsed(uint32_t &nextMs, uint32_t periodMs, uint32_t nowMs);
+void runUplinkJob(const UplinkJob &job);
+void uploadUplinkMetrics();
+void uploadHeapReport();
+void runDutyCycleWake();
+int64_t rtcMicros();
+int64_t syncDutyCycleClock();
+bool uploadDutyCycleBatch();
+void uploadDutyCycleReport();
+bool updateUplinkLink(uint32_t nowMs);
+void bufferGprsSample();
+void sendGprsBatch();
+void runtimeConfigDefaults(RuntimeConfig &config);
+void loadRuntimeConfig();
+RuntimeConfig configSnapshot();
+void pollRuntimeConfig();
+void reportConfigStatus(uint32_t version, RuntimeConfigResult result, const char* key);
+void loadCommandState();
+void pollCommand();
+CommandResult executeCommand(const CommandEnvelope &cmd);
+bool ackCommand(const CommandAck &ack);
+bool observeAnomalies(const RuntimeConfig &config);
+size_t burstPending();
+void uploadBurstChunk();
 // ------------------------------------------------------------------ //
 
 void setup(){
   Serial.begin(115200);
+  serialTxMutex = xSemaphoreCreateMutexStatic(&serialTxMutexBuffer);
+  traceFileMutex = xSemaphoreCreateMutexStatic(&traceFileMutexBuffer);
   Wire.begin(); // Start I2C communication
+  loadRuntimeConfig(); // Last applied <USER>/Config from NVS, else the built-in defaults
+  loadCommandState(); // Last executed command seq, so a reboot doesn't replay it
+
+#if ENABLE_DUTY_CYCLE
+  runDutyCycleWake(); // Sample, upload when due, deep-sleep - never returns
+#endif
   DEBUG_PRINTLN("\n--- Starting Dual-Core IoT Task Setup ---");
 
   // Initialize LEDs
@@ -137,11 +517,11 @@ void setup(){
   sim800a_init(); // Initialize SIM800A module
   initWifi(); // Initialize WiFi
   initFirebase(); // Initialize Firebase
-  initAHT10(); // Initialize AHT10 Sensor 
-  initMLX90614(); // Call the initialization function
-  initMPU6050(); // Initialize MPU6050 Sensor
-  initSGP30(); // Initialize SGP30 Gas Sensor
-  syncTimeWithNTP(); // Synchronize time with NTP server
+  workingSensors = Sensors::begin(0xFF); // Probe every fitted sensor
+  syncTimeWithNTP(); // Start background NTP synchronisation (non-blocking)
+#if ENABLE_TRACE_RECORDING
+  initTraceRecorder(); // Start recording raw readings to flash
+#endif
 
 
 
@@ -149,13 +529,14 @@ void setup(){
   // 1. Sensor Readings Task (Pinned to Core 1)
   // Handles fast, dedicated sensor acquisition.
   // ----------------------------------------
-  xTaskCreatePinnedToCore(
+  sensorTaskHandle = xTaskCreateStaticPinnedToCore(
     TaskSensorReadings,      // Function to implement the task
     "Sensor_Reader",         // Name of the task
-    8192,                    // Increased Stack size (8KB) for multiple sensor libraries
+    SENSOR_TASK_STACK,       // Stack size in bytes (static)
     NULL,                    // Task input parameter
     2,                       // Priority (Higher priority than the Sender)
-    NULL,                    // Task handle
+    sensorTaskStack,         // Stack buffer
+    &sensorTaskBuffer,       // Task control block
     1                        // Core to pin the task to (1 = Core 1)
   );
   DEBUG_PRINTLN("[SETUP] Sensor Task created on Core 1.");
@@ -165,20 +546,43 @@ void setup(){
   // 2. Firebase Sender Task (Pinned to Core 0)
   // Handles slower, network-blocking I/O (Wi-Fi, Firebase, OTA).
   // ----------------------------------------
-  xTaskCreatePinnedToCore(
+  senderTaskHandle = xTaskCreateStaticPinnedToCore(
     TaskFirebaseSender,      // Function to implement the task
     "Firebase_Sender",       // Name of the task
-    12288,                   // Increased Stack size (12KB - more stack for network ops)
+    SENDER_TASK_STACK,       // Stack size in bytes (static)
     NULL,                    // Task input parameter
     1,                       // Priority
-    NULL,                    // Task handle
+    senderTaskStack,         // Stack buffer
+    &senderTaskBuffer,       // Task control block
     0                        // Core to pin the task to (0 = Core 0)
   );
   DEBUG_PRINTLN("[SETUP] Firebase Task created on Core 0.");
+
+#if ENABLE_TRACE_LOG
+  // ----------------------------------------
+  // 3. Trace Log Drain Task (Pinned to Core 0)
+  // Moves binary log records to the serial port whenever nothing else needs the CPU.
+  // ----------------------------------------
+  traceLogLevel = runtimeConfig.traceLogLevel;
+  traceDrainTaskHandle = xTaskCreateStaticPinnedToCore(
+    TaskTraceLogDrain,       // Function to implement the task
+    "TraceLog_Drain",        // Name of the task
+    TRACE_DRAIN_TASK_STACK,  // Stack size in bytes (static)
+    NULL,                    // Task input parameter
+    tskIDLE_PRIORITY,        // Priority (lowest - never delays sensing or uploads)
+    traceDrainTaskStack,     // Stack buffer
+    &traceDrainTaskBuffer,   // Task control block
+    0                        // Core to pin the task to (0 = Core 0)
+  );
+#endif
 }
 
 
 void loop() {
+#if ENABLE_TRACE_RECORDING || ENABLE_TRACE_LOG
+  handleSerialConsole();
+#endif
+
   // Use the main loop for simple, low-priority status/health checks.
   DEBUG_PRINT("[LOOP] System Status - Free Heap: ");
   DEBUG_PRINT(ESP.getFreeHeap());
@@ -198,27 +602,38 @@ void loop() {
  */
 void TaskSensorReadings(void * parameter) {
   DEBUG_PRINTLN("[CORE 1 - SENSOR] Task started.");
+  TickType_t lastWake = xTaskGetTickCount();
+  SensorSample cycle = {};   // A failed read keeps the sensor's previous values
   
   for (;;) {
-
-    if (status_AHT10 == "Working"){
-    readAHT10(); // Call the AHT10 reading function
-    }
-
-    if (status_MLX90614 == "Working"){
-    readMLX90614(); // Call the reading function
-    }
-
-    if (status_MPU6050 == "Working") {
-      readMPU6050(); // Call the MPU6050 reading function
+    // Stamp this acquisition cycle once; every reading below shares it
+    int64_t cycleEpochUs = epochMicros();
+    portENTER_CRITICAL(&windowMux);
+    acquisitionEpochUs = cycleEpochUs;
+    portEXIT_CRITICAL(&windowMux);
+
+    uint8_t readMask = Sensors::read(workingSensors, cycle);
+    recordReadings(cycle, readMask);
+
+#if SENSOR_MPU6050
+    if (workingSensors & SENSOR_BIT_MPU6050) {
+      delay(500);
+#if ENABLE_VIBRATION_FEATURES
+      readVibrationFeatures(); // Capture one FFT block
+#endif
     }
+#endif
 
-    if (status_SGP30 == "Working") {
-      readSGP30(); // Call the SGP30 reading function
+    RuntimeConfig config = configSnapshot();
+    uint32_t periodMs = config.sensorPeriodMs;
+#if ENABLE_ANOMALY_BURST
+    if (observeAnomalies(config) && config.burstSensorPeriodMs < periodMs) {
+      periodMs = config.burstSensorPeriodMs; // Full rate while a burst runs
     }
+#endif
 
-    delay(100);
-    vTaskDelay(pdMS_TO_TICKS(2000)); 
+    // Fixed cadence from the start of the cycle, so sensor time doesn't stretch the period
+    vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(periodMs));
   }
 }
 
@@ -230,43 +645,301 @@ void TaskFirebaseSender(void * parameter) {
   
   // Reduce buffer size to prevent blocking
   fbdo.setBSSLBufferSize(512, 1024);
-  
-  // Flag to track if status was updated on first run
-  static bool firstRun = true;
+
+  // Upload sensor status once at start-up
+  uplinkEnqueue(JOB_SENSOR_STATUS, UPLINK_BULK, 0, UPLINK_BULK_DEADLINE_MS);
+
+  uint32_t nextLive = millis();
+  uint32_t nextMl = millis();
+  uint32_t nextActions = millis();
+  uint32_t nextMetrics = millis() + runtimeConfig.metricsPeriodMs;
+  uint32_t nextConfig = millis();
+#if ENABLE_ANOMALY_BURST
+  uint32_t nextBurst = millis();
+#endif
+#if ENABLE_GPRS_FALLBACK
+  uint32_t nextGprsBatch = millis() + GPRS_BATCH_PERIOD_MS;
+#endif
 
   for (;;) {
-    // 0. On first run, upload sensor status
-    if (firstRun) {
-      updateSensorStatusToFirebase();
-      firstRun = false;
-      vTaskDelay(pdMS_TO_TICKS(100));
+    uint32_t now = millis();
+    const RuntimeConfig &config = runtimeConfig; // Only this task replaces it
+
+#if ENABLE_GPRS_FALLBACK
+    // 0. Pick the link: Firebase jobs pause while samples go out over GPRS
+    bool onGprs = updateUplinkLink(now);
+#else
+    const bool onGprs = false;
+#endif
+
+    // 1. Queue periodic jobs. A live update still queued when the next one is due is
+    //    merged/dropped, so a slow step can't build a backlog of stale data.
+    if (!onGprs && periodElapsed(nextLive, config.livePeriodMs, now)) {
+      uplinkEnqueue(JOB_LIVE_DATA, UPLINK_LIVE, 0, config.livePeriodMs);
     }
-    
-    // 1. Save sensor data to Firebase
-    saveFirebaseActions();
-    vTaskDelay(pdMS_TO_TICKS(100)); // Yield to watchdog
-    
-    // 2. Save data to ML Training collection with timestamp
-    saveToFirestore();
-    vTaskDelay(pdMS_TO_TICKS(100)); // Yield to watchdog
+    if (periodElapsed(nextMl, config.mlPeriodMs, now)) {
+      if (!onGprs) {
+        uplinkEnqueue(JOB_ML_RECORD, UPLINK_BULK, 0, UPLINK_BULK_DEADLINE_MS);
+      }
+#if ENABLE_GPRS_FALLBACK
+      if (onGprs) {
+        bufferGprsSample(); // Held for the next GPRS batch
+      }
+#endif
+#if ENABLE_TRACE_RECORDING
+      // Move recorded readings from RAM to flash off the sensor core
+      flushTraceToFile();
+#endif
+    }
+    if (!onGprs && periodElapsed(nextActions, config.actionPollMs, now)) {
+      uplinkEnqueue(JOB_READ_COMMAND, UPLINK_COMMAND, 0, config.actionPollMs);
+#if ENABLE_LEGACY_ACTIONS
+      uplinkEnqueue(JOB_READ_ACTIONS, UPLINK_COMMAND, 0, config.actionPollMs);
+#endif
+    }
+    if (!onGprs && periodElapsed(nextConfig, config.configPollMs, now)) {
+      uplinkEnqueue(JOB_CONFIG_POLL, UPLINK_COMMAND, 0, config.configPollMs);
+    }
+    if (!onGprs && periodElapsed(nextMetrics, config.metricsPeriodMs, now)) {
+      uplinkEnqueue(JOB_UPLINK_METRICS, UPLINK_BULK, 0, UPLINK_BULK_DEADLINE_MS);
+      uplinkEnqueue(JOB_TIME_SYNC_REPORT, UPLINK_BULK, 0, UPLINK_BULK_DEADLINE_MS);
+      uplinkEnqueue(JOB_HEAP_REPORT, UPLINK_BULK, 0, UPLINK_BULK_DEADLINE_MS);
+    }
+#if ENABLE_ANOMALY_BURST
+    if (!onGprs && periodElapsed(nextBurst, BURST_UPLOAD_PERIOD_MS, now) && burstPending() > 0) {
+      uplinkEnqueue(JOB_BURST_UPLOAD, UPLINK_LIVE, 0, BURST_UPLOAD_PERIOD_MS);
+    }
+#endif
+#if ENABLE_GPRS_FALLBACK
+    if (onGprs && periodElapsed(nextGprsBatch, GPRS_BATCH_PERIOD_MS, now)) {
+      uplinkEnqueue(JOB_GPRS_BATCH, UPLINK_BULK, 0, UPLINK_BULK_DEADLINE_MS);
+    }
+#endif
+
+    // 2. Run the most urgent job: alerts, then commands, then live data, then bulk
+    UplinkJob job;
+    bool hasJob;
+    portENTER_CRITICAL(&uplinkMux);
+    hasJob = uplink.next(now, job);
+    portEXIT_CRITICAL(&uplinkMux);
+
+    if (!hasJob) {
+      vTaskDelay(pdMS_TO_TICKS(20)); // Idle until the next job is due
+      continue;
+    }
+    if (onGprs && job.kind != JOB_GPRS_BATCH && job.kind != JOB_SMS_ALERT) {
+      // Queued before the switch; Firebase is unreachable, so don't wait out its timeouts
+      portENTER_CRITICAL(&uplinkMux);
+      uplink.drop(job);
+      portEXIT_CRITICAL(&uplinkMux);
+      continue;
+    }
+
+    uint32_t start = millis();
+    runUplinkJob(job);
+    uint32_t end = millis();
+
+    portENTER_CRITICAL(&uplinkMux);
+    uplink.complete(job, start, end);
+    portEXIT_CRITICAL(&uplinkMux);
+
+    vTaskDelay(1); // Yield to watchdog
+  }
+}
+
+/**
+ * @brief Task 3: Runs on Core 0 at idle priority, writes pending trace log frames to Serial.
+ */
+void TaskTraceLogDrain(void * parameter) {
+  static uint8_t frames[512];
+
+  for (;;) {
+    size_t length;
+    xSemaphoreTake(serialTxMutex, portMAX_DELAY);
+    while ((length = traceLogDrain(frames, sizeof(frames))) > 0) {
+      Serial.write(frames, length);
+    }
+    xSemaphoreGive(serialTxMutex);
+    vTaskDelay(pdMS_TO_TICKS(TRACE_LOG_DRAIN_MS));
+  }
+}
+
+/**
+ * @brief Queue an uplink job for TaskFirebaseSender (safe from any task)
+ */
+bool uplinkEnqueue(UplinkJobKind kind, UplinkClass jobClass, uint16_t param, uint32_t deadlineInMs, uint8_t attempt) {
+  uint32_t now = millis();
+  bool queued;
+  portENTER_CRITICAL(&uplinkMux);
+  queued = uplink.enqueue(kind, jobClass, param, now, now + deadlineInMs, attempt);
+  portEXIT_CRITICAL(&uplinkMux);
+
+  if (!queued) {
+    DEBUG_PRINT("[Uplink] Queue full, job dropped - class ");
+    DEBUG_PRINTLN(UPLINK_CLASS_NAMES[jobClass]);
+  }
+  return queued;
+}
+
+/**
+ * @brief True once per period; re-anchors if the sender fell more than a period behind
+ */
+bool periodElapsed(uint32_t &nextMs, uint32_t periodMs, uint32_t nowMs) {
+  if ((int32_t)(nowMs - nextMs) < 0) {
+    return false;
+  }
+  nextMs += periodMs;
+  if ((int32_t)(nowMs - nextMs) >= 0) {
+    nextMs = nowMs + periodMs;
+  }
+  return true;
+}
+
+/**
+ * @brief Execute one dequeued uplink job
+ */
+void runUplinkJob(const UplinkJob &job) {
+  switch (job.kind) {
+    case JOB_SENSOR_STATUS:  updateSensorStatusToFirebase(); break;
+    case JOB_LIVE_DATA:      saveFirebaseActions(); break;
+#if ML_BATCH_SIZE > 0
+    case JOB_ML_RECORD:      saveToMlBatch(); break;
+#else
+    case JOB_ML_RECORD:      saveToFirestore(); break;
+#endif
+    case JOB_READ_ACTIONS:   readFirebaseActions(); Alert_MSG(); break;
+    case JOB_READ_COMMAND:   pollCommand(); break;
+    case JOB_SMS_ALERT:      sendActionAlert(job.param, job.attempt); break;
+    case JOB_UPLINK_METRICS: uploadUplinkMetrics(); break;
+    case JOB_TIME_SYNC_REPORT: uploadTimeSyncQuality(); break;
+    case JOB_HEAP_REPORT:    uploadHeapReport(); break;
+#if ENABLE_GPRS_FALLBACK
+    case JOB_GPRS_BATCH:     sendGprsBatch(); break;
+#endif
+    case JOB_CONFIG_POLL:    pollRuntimeConfig(); break;
+#if ENABLE_ANOMALY_BURST
+    case JOB_BURST_UPLOAD:   uploadBurstChunk(); break;
+#endif
+    default: break;
+  }
+}
+
+/**
+ * @brief Upload per-class queue depth and latency to <USER>/Uplink_Metrics
+ */
+void uploadUplinkMetrics() {
+  UplinkClassMetrics snapshot[UPLINK_CLASS_COUNT];
+  portENTER_CRITICAL(&uplinkMux);
+  for (int c = 0; c < UPLINK_CLASS_COUNT; c++) {
+    snapshot[c] = uplink.metrics((UplinkClass)c);
+  }
+  uplink.resetLatency();
+  portEXIT_CRITICAL(&uplinkMux);
+
+  JsonLease metricsJson(jsonPool);
+  if (!metricsJson) return;
+  char key[48];
+  for (int c = 0; c < UPLINK_CLASS_COUNT; c++) {
+    const UplinkClassMetrics &m = snapshot[c];
+    const char* name = UPLINK_CLASS_NAMES[c];
+    snprintf(key, sizeof(key), "%s/depth", name);           metricsJson->set(key, (int)m.depth);
+    snprintf(key, sizeof(key), "%s/max_depth", name);       metricsJson->set(key, (int)m.maxDepth);
+    snprintf(key, sizeof(key), "%s/enqueued", name);        metricsJson->set(key, (int)m.enqueued);
+    snprintf(key, sizeof(key), "%s/merged", name);          metricsJson->set(key, (int)m.merged);
+    snprintf(key, sizeof(key), "%s/overflowed", name);      metricsJson->set(key, (int)m.overflowed);
+    snprintf(key, sizeof(key), "%s/expired", name);         metricsJson->set(key, (int)m.expired);
+    snprintf(key, sizeof(key), "%s/dropped", name);         metricsJson->set(key, (int)m.dropped);
+    snprintf(key, sizeof(key), "%s/executed", name);        metricsJson->set(key, (int)m.executed);
+    snprintf(key, sizeof(key), "%s/missed_deadline", name); metricsJson->set(key, (int)m.missedDeadline);
+    snprintf(key, sizeof(key), "%s/wait_ms", name);
+    addWindowStats(*metricsJson, key, m.waitMs);
+    snprintf(key, sizeof(key), "%s/run_ms", name);
+    addWindowStats(*metricsJson, key, m.runMs);
+  }
+  metricsJson->set("commands/executed", (int)commandsExecuted);
+  metricsJson->set("commands/rejected", (int)commandsRejected);
+  addWindowStats(*metricsJson, "commands/latency_ms", commandLatencyMs);
+  commandLatencyMs.reset();
+
+#if SENSOR_MPU6050
+  // IMU reads against the data-ready interrupt; jitter comes from vibration blocks only
+  portENTER_CRITICAL(&windowMux);
+  DataReadyStats mpuSnapshot = mpuStats;
+  mpuStats.reset();
+  portEXIT_CRITICAL(&windowMux);
+  // An interrupt build that has never seen an edge (INT not connected) is polling in effect
+  bool mpuInterrupt = ENABLE_MPU_INTERRUPT && mpuDataReadyEdge().count != 0;
+  metricsJson->set("mpu/mode", mpuInterrupt ? "interrupt" : "polled");
+  metricsJson->set("mpu/irqs", (int)mpuDataReadyEdge().count);
+  metricsJson->set("mpu/irq_timeouts", (int)mpuIrqTimeouts);
+  metricsJson->set("mpu/reads", (int)mpuSnapshot.reads);
+  metricsJson->set("mpu/duplicates", (int)mpuSnapshot.duplicates);
+  metricsJson->set("mpu/missed", (int)mpuSnapshot.missed);
+  addWindowStats(*metricsJson, "mpu/latency_us", mpuSnapshot.latencyUs);
+  addWindowStats(*metricsJson, "mpu/jitter_us", mpuSnapshot.jitterUs);
+#endif
+
+  char metricsPath[60];
+  sprintf(metricsPath, "%s/Uplink_Metrics", USER_NAME);
+  if (Firebase.RTDB.setJSON(&fbdo, metricsPath, metricsJson.get())) {
+    TLOG(TL_UPLINK_METRICS);
+  } else {
+    TLOG(TL_UPLINK_METRICS_FAILED, fbdo.httpCode());
+  }
+}
 
-    // 3. Read action commands from Firebase
-    readFirebaseActions();
-    vTaskDelay(pdMS_TO_TICKS(100)); // Yield to watchdog
+/**
+ * @brief Upload heap, stack and scratch pool figures to <USER>/Heap_Report
+ * Free bytes holding steady while the largest free block shrinks is fragmentation.
+ */
+void uploadHeapReport() {
+  static uint32_t largestFirst = 0;
+  static uint32_t largestLow = 0xFFFFFFFF;
+
+  uint32_t freeBytes = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+  uint32_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+  if (largestFirst == 0) largestFirst = largest;
+  if (largest < largestLow) largestLow = largest;
+  float fragmentation = freeBytes ? 100.0f * (1.0f - (float)largest / (float)freeBytes) : 0.0f;
+
+  JsonLease heapJson(jsonPool);
+  if (!heapJson) return;
+  heapJson->set("free_bytes", (int)freeBytes);
+  heapJson->set("min_free_bytes", (int)heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT));
+  heapJson->set("largest_block", (int)largest);
+  heapJson->set("largest_block_first", (int)largestFirst);
+  heapJson->set("largest_block_low", (int)largestLow);
+  heapJson->set("fragmentation_pct", fragmentation);
+  heapJson->set("uptime_s", (int)(millis() / 1000));
+
+  // Unused stack in bytes (high-water mark) - shrink a stack that never comes close
+  heapJson->set("stack_free/sensor", (int)uxTaskGetStackHighWaterMark(sensorTaskHandle));
+  heapJson->set("stack_free/sender", (int)uxTaskGetStackHighWaterMark(senderTaskHandle));
+  size_t stackBytes = sizeof(sensorTaskStack) + sizeof(senderTaskStack);
+#if ENABLE_TRACE_LOG
+  heapJson->set("stack_free/trace_drain", (int)uxTaskGetStackHighWaterMark(traceDrainTaskHandle));
+  stackBytes += sizeof(traceDrainTaskStack);
+#endif
 
-    // 4. Send SMS alerts based on actions
-    Alert_MSG();
-    vTaskDelay(pdMS_TO_TICKS(100)); // Yield to watchdog
+  heapJson->set("static_bytes/stacks", (int)stackBytes);
+  heapJson->set("static_bytes/pools", (int)(jsonPool.bytes() + chunkPool.bytes() + batchPool.bytes()));
+  heapJson->set("pool/json_high_water", (int)jsonPool.highWater());
+  heapJson->set("pool/exhausted", (int)(jsonPool.exhausted() + chunkPool.exhausted() + batchPool.exhausted()));
 
-    // 5. Task Delay - This task runs every ~5 seconds total
-    vTaskDelay(pdMS_TO_TICKS(4600)); 
+  char heapPath[60];
+  sprintf(heapPath, "%s/Heap_Report", USER_NAME);
+  if (Firebase.RTDB.setJSON(&fbdo, heapPath, heapJson.get())) {
+    TLOG(TL_HEAP_REPORT, freeBytes, largest, fragmentation);
+  } else {
+    TLOG(TL_HEAP_REPORT_FAILED, fbdo.httpCode());
   }
 }
 
 /**
  * @brief Initialize Firebase connection
+ * @param timeoutMs give up after this long (0 = wait forever)
  */
-void initFirebase() {
+bool initFirebase(uint32_t timeoutMs) {
 // ---------------- Firebase ----------------
   config.api_key = API_KEY;
   config.database_url = DATABASE_URL;
@@ -277,7 +950,12 @@ void initFirebase() {
   Firebase.reconnectWiFi(true);
 
   DEBUG_PRINT("Signing in");
+  uint32_t start = millis();
   while (!Firebase.ready()) {
+    if (timeoutMs && millis() - start >= timeoutMs) {
+      DEBUG_PRINTLN("\nFirebase sign-in timed out");
+      return false;
+    }
     DEBUG_PRINT(".");
     delay(500);
   }
@@ -289,30 +967,39 @@ void initFirebase() {
   }
   else
     DEBUG_PRINTLN("UID not available yet.");
+  return true;
 }
 
 
 /**
  * @brief Initialize WiFi connection
+ * @param timeoutMs give up after this long (0 = wait forever)
  */
-void initWifi(){
+bool initWifi(uint32_t timeoutMs){
   // ---------------- WiFi ----------------
   WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
   DEBUG_PRINTF("Connecting to Wi-Fi: %s", WIFI_SSID);
+  uint32_t start = millis();
   while (WiFi.status() != WL_CONNECTED) {
+    if (timeoutMs && millis() - start >= timeoutMs) {
+      DEBUG_PRINTLN("\nWi-Fi connect timed out");
+      return false;
+    }
     DEBUG_PRINT(".");
     delay(250);
   }
   DEBUG_PRINTLN("\nWi-Fi connected!");
   DEBUG_PRINT("IP address: ");
   DEBUG_PRINTLN(WiFi.localIP());
+  return true;
 }
 
 
+#if SENSOR_MPU6050
 /**
  * @brief Initialize the MPU6050 sensor
  */
-void initMPU6050() {
+bool Mpu6050Driver::begin() {
   while (!Serial)
     delay(10); // will pause Zero, Leonardo, etc until serial console opens
 
@@ -321,12 +1008,10 @@ void initMPU6050() {
   // Try to initialize!
   if (!mpu.begin()) {
     DEBUG_PRINTLN("Failed to find MPU6050 chip");
-    status_MPU6050 = "Not Working";
-    return; // Return but don't halt - sensor is optional
+    return false; // Return but don't halt - sensor is optional
   }
   
   DEBUG_PRINTLN("MPU6050 Found!");
-  status_MPU6050 = "Working";
 
   mpu.setAccelerometerRange(MPU6050_RANGE_8_G);
   DEBUG_PRINT("Accelerometer range set to: ");
@@ -361,7 +1046,17 @@ void initMPU6050() {
     break;
   }
 
+#if ENABLE_VIBRATION_FEATURES
+  // Vibration blocks need the low-pass filter above the tremor band but below Nyquist
+  mpu.setFilterBandwidth(MPU6050_BAND_44_HZ);
+  if (!vibrationInit()) {
+    DEBUG_PRINTLN("Vibration FFT init failed");
+  }
+  DEBUG_PRINT("Vibration FFT backend: ");
+  DEBUG_PRINTLN(vibrationBackend());
+#else
   mpu.setFilterBandwidth(MPU6050_BAND_5_HZ);
+#endif
   DEBUG_PRINT("Filter bandwidth set to: ");
   switch (mpu.getFilterBandwidth()) {
   case MPU6050_BAND_260_HZ:
@@ -386,241 +1081,544 @@ void initMPU6050() {
     DEBUG_PRINTLN("5 Hz");
     break;
   }
+
+  // Data-ready on INT at MPU_SAMPLE_RATE_HZ (with the DLPF on the base rate is 1 kHz)
+  mpu.setSampleRateDivisor(1000 / MPU_SAMPLE_RATE_HZ - 1);
+#if MPU_INT_WIRED
+  if (!mpuEnableDataReady()) {
+    DEBUG_PRINTLN("MPU6050 data-ready interrupt not enabled");
+  }
+#endif
+
   DEBUG_PRINTLN("");
   delay(100);
+  return true;
 }
 
 
 /** 
- * @brief Read and print MPU6050 data
+ * @brief Read MPU6050 data
  */
-void readMPU6050() {
+bool Mpu6050Driver::read(SensorSample &s) {
   sensors_event_t a, g, temp;
+  mpuTiming.restart(); // One read per cycle: no interval to score
+#if ENABLE_MPU_INTERRUPT
+  mpuTiming.discard(mpuDataReadyEdge());
+  mpuWaitDataReady(); // A sample latched after the cycle started, not one up to a period old
+#endif
+  DataReadyEdge edge = mpuDataReadyEdge();
   mpu.getEvent(&a, &g, &temp);
+  mpuRecordRead(edge);
+
+  s.accelX = a.acceleration.x;
+  s.accelY = a.acceleration.y;
+  s.accelZ = a.acceleration.z;
+  s.gyroX = g.gyro.x;
+  s.gyroY = g.gyro.y;
+  s.gyroZ = g.gyro.z;
+  s.temperatureMPU = temp.temperature;
+
+  /* Log the values (formatted on the host) */
+  TLOG(TL_MPU_ACCEL, s.accelX, s.accelY, s.accelZ);
+  TLOG(TL_MPU_GYRO, s.gyroX, s.gyroY, s.gyroZ);
+  TLOG(TL_MPU_TEMP, s.temperatureMPU);
+  return true;
+}
 
-  /* Print out the values */
-  DEBUG_PRINT("Acceleration X: ");
-  DEBUG_PRINT(a.acceleration.x);
-  accelerationX = a.acceleration.x;
-  DEBUG_PRINT(", Y: ");
-  DEBUG_PRINT(a.acceleration.y);
-  accelerationY = a.acceleration.y;
-  DEBUG_PRINT(", Z: ");
-  DEBUG_PRINT(a.acceleration.z);
-  accelerationZ = a.acceleration.z;
-  DEBUG_PRINTLN(" m/s^2");
-
-  DEBUG_PRINT("Rotation X: ");
-  DEBUG_PRINT(g.gyro.x);
-  gyroX = g.gyro.x;
-  DEBUG_PRINT(", Y: ");
-  DEBUG_PRINT(g.gyro.y);
-  gyroY = g.gyro.y;
-  DEBUG_PRINT(", Z: ");
-  DEBUG_PRINT(g.gyro.z);
-  gyroZ = g.gyro.z;
-  DEBUG_PRINTLN(" rad/s");
-
-  DEBUG_PRINT("Temperature: ");
-  DEBUG_PRINT(temp.temperature);
-  temperatureMPU = temp.temperature;
-  DEBUG_PRINTLN(" degC");
 
-  DEBUG_PRINTLN("");
-  delay(500);
+
+/**
+ * @brief Capture one block of acceleration magnitude and extract its spectrum
+ * Magnitude keeps the features independent of how the unit is mounted.
+ */
+void readVibrationFeatures() {
+  static float block[VIBRATION_FFT_SIZE];
+  sensors_event_t a, g, temp;
+
+#if !ENABLE_MPU_INTERRUPT
+  TickType_t lastWake = xTaskGetTickCount();
+#endif
+  mpuTiming.restart();
+#if ENABLE_MPU_INTERRUPT
+  mpuTiming.discard(mpuDataReadyEdge()); // Start the block on an edge
+#endif
+  for (int i = 0; i < VIBRATION_FFT_SIZE; i++) {
+#if ENABLE_MPU_INTERRUPT
+    mpuWaitDataReady(); // One block sample per sensor sample, on the sensor's clock
+#endif
+    DataReadyEdge edge = mpuDataReadyEdge();
+    mpu.getEvent(&a, &g, &temp);
+    mpuRecordRead(edge);
+    block[i] = sqrtf(a.acceleration.x * a.acceleration.x +
+                     a.acceleration.y * a.acceleration.y +
+                     a.acceleration.z * a.acceleration.z);
+#if !ENABLE_MPU_INTERRUPT
+    vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(1000 / VIBRATION_SAMPLE_RATE_HZ));
+#endif
+  }
+
+  VibrationFeatures features;
+  vibrationCompute(block, VIBRATION_SAMPLE_RATE_HZ, features);
+
+  portENTER_CRITICAL(&windowMux);
+  vibration = features;
+  vibrationValid = true;
+  portEXIT_CRITICAL(&windowMux);
+
+  TLOG(TL_VIBRATION, features.dominantHz, features.spectralEntropy);
+}
+
+
+/**
+ * @brief MPU6050 data-ready ISR: stamp the new sample and wake the sensor task
+ */
+void IRAM_ATTR onMpuDataReady() {
+  int64_t now = esp_timer_get_time();
+  portENTER_CRITICAL_ISR(&mpuReadyMux);
+  mpuReadyCount++;
+  mpuReadyUs = now;
+  portEXIT_CRITICAL_ISR(&mpuReadyMux);
+
+#if ENABLE_MPU_INTERRUPT
+  if (sensorTaskHandle) { // Not yet created during setup(), never in duty-cycle mode
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(sensorTaskHandle, &woken);
+    if (woken) {
+      portYIELD_FROM_ISR();
+    }
+  }
+#endif
+}
+
+
+/**
+ * @brief Route data-ready to the INT pin and attach the ISR
+ * The Adafruit driver only exposes the motion interrupt, so INT_ENABLE is written directly.
+ * INT stays at its reset configuration: active high, 50 us pulse per sample. The pull-down
+ * holds the line low if the sensor is unplugged, so the ISR cannot run on a floating input.
+ */
+bool mpuEnableDataReady() {
+  const uint8_t REG_INT_ENABLE = 0x38;
+  const uint8_t DATA_RDY_EN = 0x01;
+
+  Wire.beginTransmission(MPU6050_I2CADDR_DEFAULT);
+  Wire.write(REG_INT_ENABLE);
+  Wire.write(DATA_RDY_EN);
+  if (Wire.endTransmission() != 0) {
+    return false;
+  }
+  pinMode(MPU_INT_PIN, INPUT_PULLDOWN);
+  attachInterrupt(digitalPinToInterrupt(MPU_INT_PIN), onMpuDataReady, RISING);
+  return true;
+}
+
+
+/**
+ * @brief Count and time of the latest data-ready edge
+ */
+DataReadyEdge mpuDataReadyEdge() {
+  DataReadyEdge edge;
+  portENTER_CRITICAL(&mpuReadyMux);
+  edge.count = mpuReadyCount;
+  edge.us = mpuReadyUs;
+  portEXIT_CRITICAL(&mpuReadyMux);
+  return edge;
+}
+
+
+/**
+ * @brief Block until the MPU6050 has latched a sample the task has not read yet
+ * Gives up after two sample periods without an edge (INT not wired, or a lost
+ * pulse), so a missing interrupt degrades to polling instead of stalling the task.
+ * Returns at once outside the sensor task (setup, duty-cycle wakes): the ISR only
+ * notifies that task, so anyone else would sit out the full timeout on every call.
+ */
+void mpuWaitDataReady() {
+  if (sensorTaskHandle == NULL || xTaskGetCurrentTaskHandle() != sensorTaskHandle) {
+    return;
+  }
+  const TickType_t timeout = pdMS_TO_TICKS(2 * 1000 / MPU_SAMPLE_RATE_HZ) + 1;
+  while (!mpuTiming.fresh(mpuDataReadyEdge())) {
+    if (ulTaskNotifyTake(pdTRUE, timeout) == 0) {
+      if (mpuIrqTimeouts++ == 0) {
+        TLOG(TL_MPU_IRQ_TIMEOUT, 2 * 1000 / MPU_SAMPLE_RATE_HZ);
+      }
+      return;
+    }
+  }
 }
 
 
+/**
+ * @brief Score one IMU read against the edge taken before it started
+ */
+void mpuRecordRead(const DataReadyEdge &edge) {
+  int64_t readUs = esp_timer_get_time();
+  portENTER_CRITICAL(&windowMux);
+  mpuTiming.record(edge, readUs, mpuStats);
+  portEXIT_CRITICAL(&windowMux);
+}
+#endif
 
+
+#if SENSOR_AHT10
 /**
  * @brief Initialize the AHT10 sensor
  */
-void initAHT10() {
+bool Aht10Driver::begin() {
   DEBUG_PRINTLN("\n--- AHT10/AHTX0 Test ---");
   
   if (aht.begin()) {
     DEBUG_PRINTLN("AHT10/AHTX0 Connection Successful!");
-    status_AHT10 = "Working";
-  } else {
-    DEBUG_PRINTLN("AHT10/AHTX0 Connection FAILED. Check wiring/address.");
-    status_AHT10 = "Not Working";
-    // Continue without halting - sensor is optional
+    return true;
   }
+  DEBUG_PRINTLN("AHT10/AHTX0 Connection FAILED. Check wiring/address.");
+  return false; // Continue without halting - sensor is optional
 }
 
 
 /** 
- * @brief Read and print AHT10 data
+ * @brief Read AHT10 data
  */
-void readAHT10() {
+bool Aht10Driver::read(SensorSample &s) {
   sensors_event_t humidity, temp;
   
-  if (aht.getEvent(&humidity, &temp)) {
-    DEBUG_PRINT("Temperature: ");
-    DEBUG_PRINT(temp.temperature);
-    temperature = temp.temperature;
-    DEBUG_PRINT(" *C\tHumidity: ");
-    DEBUG_PRINT(humidity.relative_humidity);
-    relative_humidity = humidity.relative_humidity;
-    DEBUG_PRINTLN(" %");
-  } else {
-    DEBUG_PRINTLN("AHT10/AHTX0 Failed to read data!");
+  if (!aht.getEvent(&humidity, &temp)) {
+    TLOG(TL_AHT10_FAILED);
+    return false;
   }
+  s.temperature = temp.temperature;
+  s.humidity = humidity.relative_humidity;
+  TLOG(TL_AHT10_READING, s.temperature, s.humidity);
+  return true;
 }
+#endif
 
 
 /**
- * @brief Synchronize time with NTP server (Sri Lanka Time: UTC+5:30)
+ * @brief Start background NTP synchronisation (Sri Lanka Time: UTC+5:30)
+ * Does not wait for the first fix: samples taken before it carry epoch 0 and
+ * the TimeService picks up every periodic resync through onSntpSync().
  */
 void syncTimeWithNTP() {
-  DEBUG_PRINTLN("Synchronizing time with NTP server (Sri Lanka Time UTC+5:30)...");
-  
+  DEBUG_PRINTLN("Starting background NTP sync (Sri Lanka Time UTC+5:30)...");
+
+  sntp_set_time_sync_notification_cb(onSntpSync);
+  sntp_set_sync_interval(NTP_RESYNC_INTERVAL_MS);
+
   // Configure time with NTP server
-  // Sri Lanka Timezone: UTC+5:30 (5 hours 30 minutes)
+  // Sri Lanka Timezone: UTC+5:30 (5 hours 30 minutes) - only used for local time display
   // Parameters: (gmtOffset_sec, daylightOffset_sec, ntpServer1, ntpServer2, ntpServer3)
   configTime(5 * 3600 + 30 * 60, 0, "pool.ntp.org", "time.nist.gov", "time.google.com");
-  
-  DEBUG_PRINT("Waiting for NTP time sync: ");
-  
-  time_t now = time(nullptr);
-  int timeout = 30; // 30 seconds timeout
-  
-  while (now < 24 * 3600 && timeout > 0) {
-    delay(500);
-    DEBUG_PRINT(".");
-    now = time(nullptr);
-    timeout--;
-  }
-  
-  DEBUG_PRINTLN();
-  
-  if (now > 24 * 3600) {
-    struct tm* timeinfo = localtime(&now);
-    DEBUG_PRINT("Time synchronized! Sri Lanka Time: ");
-    DEBUG_PRINTLN(asctime(timeinfo));
-  } else {
-    DEBUG_PRINTLN("WARNING: Failed to synchronize time with NTP. Using default time.");
-  }
 }
 
 /**
- * @brief Initialize LED pins
+ * @brief SNTP sync callback (lwIP task) - feeds the observation to the TimeService
  */
-void initLEDs() {
-  DEBUG_PRINTLN("\n--- Initializing LEDs ---");
-  
-  // Configure LED pins as outputs
-  pinMode(LED_STATUS_PIN, OUTPUT);
-  pinMode(LED_DATA_PIN, OUTPUT);
-  
-  // Turn off both LEDs initially
-  digitalWrite(LED_STATUS_PIN, LOW);
-  digitalWrite(LED_DATA_PIN, LOW);
-  
-  delay(500);
-  
-  // Turn on status LED (stays on)
-  digitalWrite(LED_STATUS_PIN, HIGH);
-  DEBUG_PRINT("Status LED (D");
-  DEBUG_PRINT(LED_STATUS_PIN);
-  DEBUG_PRINTLN(") turned ON");
-  
-  DEBUG_PRINT("Data LED (D");
-  DEBUG_PRINT(LED_DATA_PIN);
-  DEBUG_PRINTLN(") ready for data activity");
+void onSntpSync(struct timeval* tv) {
+  int64_t monoUs = esp_timer_get_time();
+  int64_t epochUs = (int64_t)tv->tv_sec * 1000000LL + tv->tv_usec;
+
+  portENTER_CRITICAL(&timeMux);
+  timeService.onSync(monoUs, epochUs);
+  portEXIT_CRITICAL(&timeMux);
+
+  DEBUG_PRINTLN("[Time] SNTP sync received");
 }
 
 /**
- * @brief Blink data LED to indicate Firebase data activity
+ * @brief Current Unix epoch time in microseconds (0 until the first NTP fix)
  */
-void ledDataBlink() {
-  // Quick blink pattern: ON for 100ms, OFF for 100ms
-  digitalWrite(LED_DATA_PIN, HIGH);
-  delay(100);
-  digitalWrite(LED_DATA_PIN, LOW);
-  delay(100);
+int64_t epochMicros() {
+  int64_t monoUs = esp_timer_get_time();
+  portENTER_CRITICAL(&timeMux);
+  int64_t epochUs = timeService.epochUs(monoUs);
+  portEXIT_CRITICAL(&timeMux);
+  return epochUs;
 }
 
 /**
- * @brief Initialize the MLX90614 sensor
+ * @brief Upload clock sync quality to <USER>/Time_Sync
  */
-void initMLX90614() {
-  DEBUG_PRINTLN("\n--- MLX90614 Initialization ---");
-
-  if (mlx.begin()) {
-    DEBUG_PRINTLN("✅ MLX90614 Connection Successful!");
-    DEBUG_PRINTLN("Ambient and Object temperatures will be displayed.\n");
-    status_MLX90614 = "Working";
-  } else {
-    DEBUG_PRINTLN("❌ MLX90614 Connection FAILED. Check wiring/address.");
-    status_MLX90614 = "Not Working";
-    // Continue without halting - sensor is optional
+void uploadTimeSyncQuality() {
+  int64_t monoUs = esp_timer_get_time();
+  portENTER_CRITICAL(&timeMux);
+  TimeSyncQuality quality = timeService.quality(monoUs);
+  portEXIT_CRITICAL(&timeMux);
+
+  JsonLease syncJson(jsonPool);
+  if (!syncJson) return;
+  syncJson->set("synced", quality.synced);
+  syncJson->set("sync_count", (int)quality.syncCount);
+  syncJson->set("step_count", (int)quality.stepCount);
+  syncJson->set("last_offset_us", (double)quality.lastOffsetUs);
+  syncJson->set("drift_ppm", quality.driftPpm);
+  syncJson->set("pending_slew_us", (double)quality.pendingSlewUs);
+  syncJson->set("since_sync_s", quality.synced ? (int)((monoUs - quality.lastSyncMonoUs) / 1000000LL) : -1);
+
+  char syncPath[60];
+  sprintf(syncPath, "%s/Time_Sync", USER_NAME);
+  if (!Firebase.RTDB.setJSON(&fbdo, syncPath, syncJson.get())) {
+    TLOG(TL_TIME_REPORT_FAILED, fbdo.httpCode());
   }
 }
 
-
-/** 
- * @brief Read and print MLX90614 temperature data
+/**
+ * @brief Mount LittleFS and start a fresh trace, keeping the previous boot's one
  */
-void readMLX90614() {
-  ambient = mlx.readAmbientTempC();
-  object = mlx.readObjectTempC();
+void initTraceRecorder() {
+  DEBUG_PRINTLN("\n--- Trace Recorder ---");
+
+  if (!LittleFS.begin(true)) {
+    DEBUG_PRINTLN("LittleFS mount failed - trace recording disabled");
+    return;
+  }
+
+  if (LittleFS.exists("/trace.bin")) {
+    LittleFS.remove("/trace_prev.bin");
+    LittleFS.rename("/trace.bin", "/trace_prev.bin");
+  }
+
+  File file = LittleFS.open("/trace.bin", "w");
+  if (!file) {
+    DEBUG_PRINTLN("Failed to create /trace.bin - trace recording disabled");
+    return;
+  }
+  uint8_t header[TRACE_HEADER_SIZE];
+  file.write(header, traceWriteHeader(header));
+  file.close();
+
+  traceLastUs = esp_timer_get_time();
+  traceActive = true;
+  DEBUG_PRINTLN("Recording raw sensor readings to /trace.bin");
+}
+
+/**
+ * @brief Append one raw reading to the RAM staging buffer (sensor task)
+ */
+void traceRecord(TraceSensor sensor, const float* values) {
+  if (!traceActive) {
+    return;
+  }
+
+  uint64_t now = esp_timer_get_time();
+  portENTER_CRITICAL(&traceMux);
+  size_t written = traceEncode(traceBuffer + traceBufferUsed, sizeof(traceBuffer) - traceBufferUsed,
+                               traceLastUs, sensor, now, values);
+  if (written == 0) {
+    traceDropped++; // Flash writer fell behind - drop rather than block the sensor task
+  }
+  traceBufferUsed += written;
+  portEXIT_CRITICAL(&traceMux);
+}
+
+/**
+ * @brief Write staged trace records to /trace.bin (sender task, and the console before a dump)
+ * Holds traceFileMutex, so two flushes never share the pending buffer and an erase can't
+ * happen between the traceActive check and the append (which would re-create a headerless file).
+ */
+void flushTraceToFile() {
+  static uint8_t pending[TRACE_BUFFER_BYTES];
+  size_t length;
+
+  xSemaphoreTake(traceFileMutex, portMAX_DELAY);
+  portENTER_CRITICAL(&traceMux);
+  length = traceBufferUsed;
+  memcpy(pending, traceBuffer, length);
+  traceBufferUsed = 0;
+  portEXIT_CRITICAL(&traceMux);
+
+  if (length > 0 && traceActive) {
+    File file = LittleFS.open("/trace.bin", "a");
+    if (file) {
+      file.write(pending, length);
+      size_t size = file.size();
+      file.close();
+
+      if (size >= TRACE_MAX_FILE_BYTES) {
+        TLOG(TL_TRACE_FULL);
+        traceActive = false;
+      }
+    }
+  }
+  xSemaphoreGive(traceFileMutex);
+
+  if (traceDropped > 0) {
+    TLOG(TL_TRACE_DROPPED, traceDropped);
+  }
+}
+
+/**
+ * @brief Serial console: trace log level and pulling sensor traces off the device
+ * '0'..'3' set the trace log level.
+ * Trace dump framing: "TRACE BEGIN <bytes>\n" + raw file + "\nTRACE END\n"
+ */
+void handleSerialConsole() {
+  while (Serial.available()) {
+    char command = Serial.read();
+
+    if (command >= '0' && command < '0' + TL_LEVEL_COUNT) {
+      traceLogSetLevel(command - '0');
+      continue;
+    }
+#if ENABLE_TRACE_RECORDING
+    const char* path = NULL;
+    if (command == 'd') {
+      flushTraceToFile();
+      path = "/trace.bin";
+    } else if (command == 'p') {
+      path = "/trace_prev.bin";
+    } else if (command == 'x') {
+      xSemaphoreTake(traceFileMutex, portMAX_DELAY);
+      traceActive = false;
+      LittleFS.remove("/trace.bin");
+      LittleFS.remove("/trace_prev.bin");
+      xSemaphoreGive(traceFileMutex);
+      Serial.println("TRACE ERASED");
+      continue;
+    } else {
+      continue;
+    }
+
+    // Hold the file so the sender doesn't append mid-dump, and the port so no log frames land inside it
+    xSemaphoreTake(traceFileMutex, portMAX_DELAY);
+    xSemaphoreTake(serialTxMutex, portMAX_DELAY);
+    File file = LittleFS.open(path, "r");
+    if (!file) {
+      Serial.println("TRACE BEGIN 0");
+      Serial.println("TRACE END");
+      xSemaphoreGive(serialTxMutex);
+      xSemaphoreGive(traceFileMutex);
+      continue;
+    }
+    Serial.print("TRACE BEGIN ");
+    Serial.println((unsigned long)file.size());
+    uint8_t chunk[256];
+    size_t n;
+    while ((n = file.read(chunk, sizeof(chunk))) > 0) {
+      Serial.write(chunk, n);
+    }
+    file.close();
+    Serial.println();
+    Serial.println("TRACE END");
+    xSemaphoreGive(serialTxMutex);
+    xSemaphoreGive(traceFileMutex);
+#endif
+  }
+}
+
+/**
+ * @brief Initialize LED pins
+ */
+void initLEDs() {
+  DEBUG_PRINTLN("\n--- Initializing LEDs ---");
+  
+  // Configure LED pins as outputs
+  pinMode(LED_STATUS_PIN, OUTPUT);
+  pinMode(LED_DATA_PIN, OUTPUT);
+  
+  // Turn off both LEDs initially
+  digitalWrite(LED_STATUS_PIN, LOW);
+  digitalWrite(LED_DATA_PIN, LOW);
+  
+  delay(500);
+  
+  // Turn on status LED (stays on)
+  digitalWrite(LED_STATUS_PIN, HIGH);
+  DEBUG_PRINT("Status LED (D");
+  DEBUG_PRINT(LED_STATUS_PIN);
+  DEBUG_PRINTLN(") turned ON");
+  
+  DEBUG_PRINT("Data LED (D");
+  DEBUG_PRINT(LED_DATA_PIN);
+  DEBUG_PRINTLN(") ready for data activity");
+}
+
+/**
+ * @brief Blink data LED to indicate Firebase data activity
+ */
+void ledDataBlink() {
+  // Quick blink pattern: ON for 100ms, OFF for 100ms
+  digitalWrite(LED_DATA_PIN, HIGH);
+  delay(100);
+  digitalWrite(LED_DATA_PIN, LOW);
+  delay(100);
+}
+
+#if SENSOR_MLX90614
+/**
+ * @brief Initialize the MLX90614 sensor
+ */
+bool Mlx90614Driver::begin() {
+  DEBUG_PRINTLN("\n--- MLX90614 Initialization ---");
+
+  if (mlx.begin()) {
+    DEBUG_PRINTLN("✅ MLX90614 Connection Successful!");
+    DEBUG_PRINTLN("Ambient and Object temperatures will be displayed.\n");
+    return true;
+  }
+  DEBUG_PRINTLN("❌ MLX90614 Connection FAILED. Check wiring/address.");
+  return false; // Continue without halting - sensor is optional
+}
+
+
+/** 
+ * @brief Read MLX90614 temperature data
+ */
+bool Mlx90614Driver::read(SensorSample &s) {
+  float ambient = mlx.readAmbientTempC();
+  float object = mlx.readObjectTempC();
 
   if (isnan(ambient) || isnan(object)) {
-    DEBUG_PRINTLN("⚠️ Failed to read MLX90614 data!");
-  } else {
-    DEBUG_PRINT("Ambient: ");
-    DEBUG_PRINT(ambient);
-    DEBUG_PRINT(" °C\tObject: ");
-    DEBUG_PRINT(object);
-    DEBUG_PRINTLN(" °C");
+    TLOG(TL_MLX_FAILED);
+    return false;
   }
+  s.ambient = ambient;
+  s.object = object;
+  TLOG(TL_MLX_READING, ambient, object);
+  return true;
 }
+#endif
 
 
+#if SENSOR_SGP30
 /**
  * @brief Initialize the SGP30 Air Quality Sensor
  */
-void initSGP30() {
+bool Sgp30Driver::begin() {
   DEBUG_PRINTLN("\n--- SGP30 Initialization ---");
 
   if (!sgp.begin()) {
     DEBUG_PRINTLN("❌ SGP30 Connection FAILED. Check wiring/address (0x58).");
-    status_SGP30 = "Not Working";
-    // Continue without halting - sensor is optional
-  } else {
-    DEBUG_PRINTLN("✅ SGP30 Connection Successful!");
-    DEBUG_PRINT("Found SGP30 serial #");
-    DEBUG_PRINT(sgp.serialnumber[0], HEX);
-    DEBUG_PRINT(sgp.serialnumber[1], HEX);
-    DEBUG_PRINTLN(sgp.serialnumber[2], HEX);
-    status_SGP30 = "Working";
-    
-    // Set humidity compensation (optional but recommended)
-    // Uses AHT10 humidity data for better accuracy
-    sgp.setIAQBaseline(0x8E68, 0x8F41); // Optional baseline values
+    return false; // Continue without halting - sensor is optional
   }
+  DEBUG_PRINTLN("✅ SGP30 Connection Successful!");
+  DEBUG_PRINT("Found SGP30 serial #");
+  DEBUG_PRINT(sgp.serialnumber[0], HEX);
+  DEBUG_PRINT(sgp.serialnumber[1], HEX);
+  DEBUG_PRINTLN(sgp.serialnumber[2], HEX);
+  
+  // Set humidity compensation (optional but recommended)
+  // Uses AHT10 humidity data for better accuracy
+  sgp.setIAQBaseline(0x8E68, 0x8F41); // Optional baseline values
+  return true;
 }
 
 
 /**
- * @brief Read and display SGP30 Air Quality data
+ * @brief Read SGP30 Air Quality data
  */
-void readSGP30() {
+bool Sgp30Driver::read(SensorSample &s) {
   // SGP30 should be read every 1 second
   if (!sgp.IAQmeasure()) {
-    DEBUG_PRINTLN("⚠️ Failed to read SGP30 data!");
-    return;
+    TLOG(TL_SGP_FAILED);
+    return false;
   }
   
-  TVOC = sgp.TVOC;
-  eCO2 = sgp.eCO2;
+  s.tvoc = sgp.TVOC;
+  s.eco2 = sgp.eCO2;
   
-  DEBUG_PRINT("TVOC: ");
-  DEBUG_PRINT(TVOC);
-  DEBUG_PRINT(" ppb\teCO2: ");
-  DEBUG_PRINT(eCO2);
-  DEBUG_PRINTLN(" ppm");
+  TLOG(TL_SGP_READING, s.tvoc, s.eco2);
   
   // Optional: Get baseline values for calibration
   uint16_t baselineECO2, baselineTVOC;
@@ -628,14 +1626,13 @@ void readSGP30() {
   
   if (millis() - lastBaselineTime > 30000) {
     if (sgp.getIAQBaseline(&baselineECO2, &baselineTVOC)) {
-      DEBUG_PRINT("SGP30 Baseline - eCO2: 0x");
-      DEBUG_PRINT(baselineECO2, HEX);
-      DEBUG_PRINT(" TVOC: 0x");
-      DEBUG_PRINTLN(baselineTVOC, HEX);
+      TLOG(TL_SGP_BASELINE, baselineECO2, baselineTVOC);
     }
     lastBaselineTime = millis();
   }
+  return true;
 }
+#endif
 
 
 
@@ -661,29 +1658,18 @@ void readFirebaseActions() {
   sprintf(actionPaths[3], "%s/Actions/action_4", USER_NAME);
   sprintf(actionPaths[4], "%s/Actions/action_5", USER_NAME);
 
+  ActionText* actions[ACTION_COUNT] = { &Action_1, &Action_2, &Action_3, &Action_4, &Action_5 };
   for (int i = 0; i < 5; i++) {
     if (Firebase.RTDB.getString(&fbdo, actionPaths[i])) {
-      String actionValue = fbdo.stringData();
-      DEBUG_PRINT(actionPaths[i]);
-      DEBUG_PRINT(" = ");
-      DEBUG_PRINTLN(actionValue);
-
-      // Store the action values in corresponding global variables
-      switch (i) {
-        case 0: Action_1 = actionValue; break;
-        case 1: Action_2 = actionValue; break;
-        case 2: Action_3 = actionValue; break;
-        case 3: Action_4 = actionValue; break;
-        case 4: Action_5 = actionValue; break;
-      }
+      // Straight from the response buffer into the global: no heap String per poll
+      const char* actionValue = fbdo.to<const char*>();
+      *actions[i] = actionValue ? actionValue : "";
+      TLOG(TL_ACTION_READ, i + 1, *actions[i] == "ON");
     } else {
-      DEBUG_PRINT("Failed to read ");
-      DEBUG_PRINT(actionPaths[i]);
-      DEBUG_PRINT(" - ");
-      DEBUG_PRINTLN(fbdo.errorReason());
+      TLOG(TL_ACTION_FAILED, i + 1, fbdo.httpCode());
     }
     // Yield to prevent watchdog timeout
-    vTaskDelay(pdMS_TO_TICKS(50));
+    vTaskDelay(1);
   }
 }
 
@@ -692,136 +1678,158 @@ void readFirebaseActions() {
  */
 
 void saveFirebaseActions() {
-  // Example function to save actions back to Firebase if needed
-
-  // ---- Create JSON payload ----
+  SensorSample sample = captureSample();
 
-    FirebaseJson AHT10_json, MLX90614_json, MPU6050_json, SGP30_json;
-
-    AHT10_json.set("Humidity", relative_humidity);
-    AHT10_json.set("Temperature", temperature);
-
-    MLX90614_json.set("Ambient", ambient);
-    MLX90614_json.set("Object", object);
-
-    MPU6050_json.set("Accel_X", accelerationX);
-    MPU6050_json.set("Accel_Y", accelerationY);
-    MPU6050_json.set("Accel_Z", accelerationZ);
-    MPU6050_json.set("Gyro_X", gyroX);
-    MPU6050_json.set("Gyro_Y", gyroY);
-    MPU6050_json.set("Gyro_Z", gyroZ);
-    MPU6050_json.set("Temp_MPU", temperatureMPU);
-
-    SGP30_json.set("TVOC", TVOC);
-    SGP30_json.set("eCO2", eCO2);
-
-    // ---- Upload AHT10 data to Firebase ----
-    char aht10Path[50];
-    sprintf(aht10Path, "%s/Sensor_Data/AHT10", USER_NAME);
-    if (Firebase.RTDB.setJSON(&fbdo, aht10Path, &AHT10_json)) {
-      DEBUG_PRINTLN("Uploaded AHT10 data to Firebase");
-    } else {
-      DEBUG_PRINT("Upload failed: ");
-      DEBUG_PRINTLN(fbdo.errorReason());
+  // ---- Create and upload one JSON payload per sensor ----
+  for (int node = 0; node < LIVE_NODE_COUNT; node++) {
+    if (!(Sensors::fittedMask() & (1 << node))) {
+      continue; // Not in this build - leave its node alone
     }
-    vTaskDelay(pdMS_TO_TICKS(50));
-
-    // ---- Upload MLX90614 data to Firebase ---- 
-    char mlx90614Path[50];
-    sprintf(mlx90614Path, "%s/Sensor_Data/MLX90614", USER_NAME);
-    if (Firebase.RTDB.setJSON(&fbdo, mlx90614Path, &MLX90614_json)) {
-      DEBUG_PRINTLN("Uploaded MLX90614 data to Firebase");
-    } else {
-      DEBUG_PRINT("Upload failed: ");
-      DEBUG_PRINTLN(fbdo.errorReason());
-    }
-    vTaskDelay(pdMS_TO_TICKS(50));
-
-    // ---- Upload MPU6050 data to Firebase ---- 
-    char mpu6050Path[50];
-    sprintf(mpu6050Path, "%s/Sensor_Data/MPU6050", USER_NAME);
-    if (Firebase.RTDB.setJSON(&fbdo, mpu6050Path, &MPU6050_json)) {
-      DEBUG_PRINTLN("Uploaded MPU6050 data to Firebase");
-    } else {
-      DEBUG_PRINT("Upload failed: ");
-      DEBUG_PRINTLN(fbdo.errorReason());
-    }
-    vTaskDelay(pdMS_TO_TICKS(50));
-
-    // ---- Upload SGP30 data to Firebase ---- 
-    char sgp30Path[50];
-    sprintf(sgp30Path, "%s/Sensor_Data/SGP30", USER_NAME);
-    if (Firebase.RTDB.setJSON(&fbdo, sgp30Path, &SGP30_json)) {
-      DEBUG_PRINTLN("Uploaded SGP30 data to Firebase");
+    JsonLease json(jsonPool);
+    if (!json) return;
+    buildLivePayload(*json, (LiveNode)node, sample);
+
+    char path[50];
+    sprintf(path, "%s/Sensor_Data/%s", USER_NAME, LIVE_NODE_NAMES[node]);
+    if (Firebase.RTDB.setJSON(&fbdo, path, json.get())) {
+      TLOG(TL_LIVE_UPLOADED, node);
     } else {
-      DEBUG_PRINT("Upload failed: ");
-      DEBUG_PRINTLN(fbdo.errorReason());
+      TLOG(TL_LIVE_FAILED, node, fbdo.httpCode());
     }
-    vTaskDelay(pdMS_TO_TICKS(50));
-
+    vTaskDelay(1); // Yield
+  }
 }
 
 /**
- * @brief Get formatted date and time string
+ * @brief Manage ML training data rotation - keep only the latest max_ml_records records
+ * Uses a simple counter approach - stores metadata about record count
  */
-void getFormattedDateTime(char* buffer, size_t bufferSize) {
-  time_t now = time(nullptr);
-  struct tm* timeinfo = localtime(&now);
-  
-  strftime(buffer, bufferSize, "%Y-%m-%d %H:%M:%S", timeinfo);
+void manageMLDataRotation() {
+  mlDataCount = advanceMLCounter("record_count", "ML_Training_Data", runtimeConfig.maxMlRecords);
 }
 
 /**
- * @brief Manage ML training data rotation - keep only latest 100 records
- * Uses a simple counter approach - stores metadata about record count
+ * @brief Advance a rotating document counter kept under <USER>/ML_Training_Meta
+ * When the counter passes maxEntries the data node is cleared and numbering restarts at 1.
+ * @return the index to write next
  */
-void manageMLDataRotation() {
-  char metaPath[80];
-  sprintf(metaPath, "%s/ML_Training_Meta/record_count", USER_NAME);
+int advanceMLCounter(const char* countKey, const char* dataNode, int maxEntries) {
+  char countPath[80];
+  sprintf(countPath, "%s/ML_Training_Meta/%s", USER_NAME, countKey);
   
   // Read current count
-  if (Firebase.RTDB.getInt(&fbdo, metaPath)) {
-    mlDataCount = fbdo.intData();
-  } else {
-    mlDataCount = 0;
+  int count = 0;
+  if (Firebase.RTDB.getInt(&fbdo, countPath)) {
+    count = fbdo.intData();
   }
   
   // Increment count
-  mlDataCount++;
+  count++;
   
-  // If we exceed MAX_ML_RECORDS, reset to 1 (will overwrite oldest)
-  if (mlDataCount > MAX_ML_RECORDS) {
-    DEBUG_PRINT("[ML Data] Rotating records - exceeded ");
-    DEBUG_PRINT(MAX_ML_RECORDS);
-    DEBUG_PRINTLN(" records. Starting new cycle.");
-    mlDataCount = 1;
+  // If we exceed maxEntries, reset to 1 (will overwrite oldest)
+  if (count > maxEntries) {
+    TLOG(TL_ML_ROTATED, maxEntries);
+    count = 1;
     
     // Clear old ML data folder to start fresh
     char clearPath[80];
-    sprintf(clearPath, "%s/ML_Training_Data", USER_NAME);
+    sprintf(clearPath, "%s/%s", USER_NAME, dataNode);
     Firebase.RTDB.deleteNode(&fbdo, clearPath);
   }
   
   // Update count in database
-  char countPath[80];
-  sprintf(countPath, "%s/ML_Training_Meta/record_count", USER_NAME);
-  Firebase.RTDB.setInt(&fbdo, countPath, mlDataCount);
+  Firebase.RTDB.setInt(&fbdo, countPath, count);
+  return count;
 }
 
 /**
- * @brief Save sensor data to Firebase with timestamp and readable date/time for ML model training
+ * @brief Publish one acquisition cycle: latest values, window accumulators and trace
+ * @param readMask SensorBit mask of the sensors whose read succeeded this cycle
+ */
+void recordReadings(const SensorSample &cycle, uint8_t readMask) {
+  portENTER_CRITICAL(&windowMux);
+  for (int f = 0; f < WF_COUNT; f++) {
+    if (readMask & sensorFieldBit(f)) {
+      windowStats[f].add(sampleField(cycle, f));
+    }
+  }
+  readings = cycle;
+  portEXIT_CRITICAL(&windowMux);
+
+#if ENABLE_TRACE_RECORDING
+  // A trace payload is the sensor's SENSOR_FIELDS entries, in table order
+  for (int node = 0; node < TRACE_SENSOR_COUNT; node++) {
+    if (!(readMask & (1 << node))) {
+      continue;
+    }
+    float values[TRACE_MAX_VALUES];
+    int first = sensorFirstField(node);
+    for (int i = 0; i < traceValueCount(node) && i < TRACE_MAX_VALUES; i++) {
+      values[i] = sampleField(cycle, first + i);
+    }
+    traceRecord((TraceSensor)node, values);
+  }
+#endif
+}
+
+/**
+ * @brief Copy all window accumulators and start a new window
+ */
+void takeWindowSnapshot(WindowStats* snapshot) {
+  portENTER_CRITICAL(&windowMux);
+  for (int i = 0; i < WF_COUNT; i++) {
+    snapshot[i] = windowStats[i];
+    windowStats[i].reset();
+  }
+  portEXIT_CRITICAL(&windowMux);
+}
+
+/**
+ * @brief Put a snapshot whose upload failed back in front of the open window
+ * The samples taken since the snapshot are kept; the next upload covers both.
+ */
+void restoreWindowSnapshot(const WindowStats* snapshot) {
+  portENTER_CRITICAL(&windowMux);
+  for (int i = 0; i < WF_COUNT; i++) {
+    windowStats[i].merge(snapshot[i]);
+  }
+  portEXIT_CRITICAL(&windowMux);
+}
+
+/**
+ * @brief Copy the latest sensor readings into one sample
+ */
+SensorSample captureSample() {
+  portENTER_CRITICAL(&windowMux);
+  SensorSample sample = readings;
+  sample.epochUs = acquisitionEpochUs;
+  portEXIT_CRITICAL(&windowMux);
+  return sample;
+}
+
+/**
+ * @brief SensorBit mask of the sensors that initialised successfully
+ */
+uint8_t workingSensorMask() {
+  return workingSensors;
+}
+
+/**
+ * @brief Save sensor data to Firebase with acquisition timestamp for ML model training
  */
 void saveToFirestore() {
-  // Manage rotation first
-  manageMLDataRotation();
+  JsonLease firestoreData(jsonPool);
+  if (!firestoreData) return; // Leave the window open for the next record
+
+  // Claim a record number once: a failed write keeps it for the next record,
+  // so the numbering has no gaps and failures don't push it into a rotation
+  if (mlDataCount == 0) {
+    manageMLDataRotation();
+  }
   
-  // Get current timestamp in milliseconds
+  // Device uptime in milliseconds (acquisition epoch time travels in the sample)
   unsigned long timestamp = millis();
   
-  // Create formatted date/time string
-  char dateTimeStr[25];
-  getFormattedDateTime(dateTimeStr, sizeof(dateTimeStr));
-  
   // Create a new document with record number as ID (ensures ordering)
   char docId[20];
   sprintf(docId, "record_%03d", mlDataCount);
@@ -829,115 +1837,437 @@ void saveToFirestore() {
   char rtdbPath[150];
   sprintf(rtdbPath, "%s/ML_Training_Data/%s", USER_NAME, docId);
 
-  // Create JSON payload with all sensor data and timestamp
-  FirebaseJson firestoreData;
-  
-  // Add timestamp (numeric)
-  firestoreData.set("timestamp_ms", (double)timestamp);
-  
-  // Add readable date/time
-  firestoreData.set("datetime", dateTimeStr);
-  
-  if (status_AHT10 == "Working"){
-    // Add AHT10 data
-    FirebaseJson aht10_obj;
-    aht10_obj.set("humidity", relative_humidity);
-    aht10_obj.set("temperature", temperature);
-    firestoreData.set("AHT10", aht10_obj);
-  }  
-
-  
-  if (status_MLX90614 == "Working"){
-    // Add MLX90614 data
-    FirebaseJson mlx90614_obj;
-    mlx90614_obj.set("ambient", ambient);
-    mlx90614_obj.set("object", object);
-    firestoreData.set("MLX90614", mlx90614_obj);
+  // Close the aggregation window covering the samples since the last upload
+  WindowStats window[WF_COUNT];
+  takeWindowSnapshot(window);
+
+  VibrationFeatures vibrationSnapshot;
+  bool hasVibration;
+  portENTER_CRITICAL(&windowMux);
+  vibrationSnapshot = vibration;
+  hasVibration = vibrationValid;
+  vibrationValid = false;
+  portEXIT_CRITICAL(&windowMux);
+
+  // Create JSON payload with all sensor data, window aggregates and timestamp
+  uint8_t workingMask = workingSensorMask();
+  const char* actions[ACTION_COUNT] = {
+    Action_1.c_str(), Action_2.c_str(), Action_3.c_str(), Action_4.c_str(), Action_5.c_str()
+  };
+  buildMlRecord(*firestoreData, captureSample(), workingMask, window, actions, (double)timestamp);
+
+  if (hasVibration && (workingMask & SENSOR_BIT_MPU6050)) {
+    // Add spectral vibration features of the latest block
+    firestoreData->set("Vibration/dominant_hz", vibrationSnapshot.dominantHz);
+    firestoreData->set("Vibration/rms", vibrationSnapshot.rms);
+    firestoreData->set("Vibration/entropy", vibrationSnapshot.spectralEntropy);
+    for (int b = 0; b < VIBRATION_BAND_COUNT; b++) {
+      char bandKey[24];
+      snprintf(bandKey, sizeof(bandKey), "Vibration/band_%d", b);
+      firestoreData->set(bandKey, vibrationSnapshot.bandEnergy[b]);
+    }
   }
-  
-  if (status_MPU6050 == "Working"){
-    // Add MPU6050 data
-    FirebaseJson mpu6050_obj;
-    mpu6050_obj.set("accel_x", accelerationX);
-    mpu6050_obj.set("accel_y", accelerationY);
-    mpu6050_obj.set("accel_z", accelerationZ);
-    mpu6050_obj.set("gyro_x", gyroX);
-    mpu6050_obj.set("gyro_y", gyroY);
-    mpu6050_obj.set("gyro_z", gyroZ);
-    mpu6050_obj.set("temperature", temperatureMPU);
-    firestoreData.set("MPU6050", mpu6050_obj);
-  }
-
-
-  if (status_SGP30 == "Working"){
-    // Add SGP30 Air Quality data
-    FirebaseJson sgp30_obj;
-    sgp30_obj.set("tvoc", TVOC);
-    sgp30_obj.set("eco2", eCO2);
-    firestoreData.set("SGP30", sgp30_obj);
-  }
-
-  // Add action states for context
-  FirebaseJson actions_obj;
-  actions_obj.set("action_1", Action_1);
-  actions_obj.set("action_2", Action_2);
-  actions_obj.set("action_3", Action_3);
-  actions_obj.set("action_4", Action_4);
-  actions_obj.set("action_5", Action_5);
-  firestoreData.set("Actions", actions_obj);
 
   // Save to Realtime Database
-  if (Firebase.RTDB.setJSON(&fbdo, rtdbPath, &firestoreData)) {
-    DEBUG_PRINT("[ML Data] Saved at ");
-    DEBUG_PRINT(dateTimeStr);
-    DEBUG_PRINT(" (Record ");
-    DEBUG_PRINT(mlDataCount);
-    DEBUG_PRINTLN("/100)");
+  if (Firebase.RTDB.setJSON(&fbdo, rtdbPath, firestoreData.get())) {
+    TLOG(TL_ML_SAVED, mlDataCount);
+    mlDataCount = 0;
   } else {
-    DEBUG_PRINT("[ML Data] Failed to save: ");
-    DEBUG_PRINTLN(fbdo.errorReason());
+    TLOG(TL_ML_FAILED, fbdo.httpCode());
+    // Keep the window (and the vibration block, unless a newer one is in) for the next record
+    restoreWindowSnapshot(window);
+    portENTER_CRITICAL(&windowMux);
+    if (hasVibration && !vibrationValid) {
+      vibration = vibrationSnapshot;
+      vibrationValid = true;
+    }
+    portEXIT_CRITICAL(&windowMux);
+  }
+}
+
+#if ML_BATCH_SIZE > 0
+static_assert(ML_BATCH_SIZE <= ML_BATCH_CAPACITY, "ML_BATCH_SIZE exceeds ML_BATCH_CAPACITY");
+
+/**
+ * @brief Add one sample to the columnar batch and upload it as a chunk once full
+ * A failed upload keeps the batch and retries on the next call.
+ */
+void saveToMlBatch() {
+  static MlBatch batch;
+
+  MlBatchRow* row = batch.nextRow();
+  if (row) {
+    const char* actions[ACTION_COUNT] = {
+      Action_1.c_str(), Action_2.c_str(), Action_3.c_str(), Action_4.c_str(), Action_5.c_str()
+    };
+    row->sample = captureSample();
+    row->timeMs = (row->sample.epochUs != 0) ? row->sample.epochUs / 1000.0 : (double)millis();
+    row->actionsOn = actionsOnMask(actions);
+    takeWindowSnapshot(row->window);
+    batch.push();
+  } else {
+    TLOG(TL_ML_BATCH_DROPPED);
+  }
+
+  if (batch.size() < ML_BATCH_SIZE) {
+    return;
+  }
+
+  ChunkLease chunk(chunkPool);
+  JsonLease chunkJson(jsonPool);
+  if (!chunk || !chunkJson) return;
+  size_t length = batch.encode(chunk->text, sizeof(chunk->text), workingSensorMask(), true);
+  if (length == 0) {
+    TLOG(TL_ML_BATCH_OVERSIZE);
+    batch.clear();
+    return;
+  }
+
+  // Claim a slot once per batch: a retry reuses it, so failed writes neither
+  // leave gaps in the numbering nor push the counter into a rotation
+  static int chunkIndex = 0;
+  if (chunkIndex == 0) {
+    int maxChunks = (int)runtimeConfig.maxMlRecords / ML_BATCH_SIZE;
+    chunkIndex = advanceMLCounter("chunk_count", "ML_Training_Chunks", maxChunks > 0 ? maxChunks : 1);
+  }
+  char chunkPath[80];
+  sprintf(chunkPath, "%s/ML_Training_Chunks/chunk_%03d", USER_NAME, chunkIndex);
+
+  chunkJson->setJsonData(chunk->text);
+  if (Firebase.RTDB.setJSON(&fbdo, chunkPath, chunkJson.get())) {
+    TLOG(TL_ML_BATCH_UPLOADED, batch.size(), length);
+    batch.clear();
+    chunkIndex = 0;
+  } else {
+    TLOG(TL_ML_BATCH_FAILED, fbdo.httpCode());
+  }
+}
+#endif
+
+#if ENABLE_DUTY_CYCLE
+/**
+ * @brief Microseconds on the RTC-backed system clock (keeps counting through deep sleep)
+ */
+int64_t rtcMicros() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (int64_t)tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+/**
+ * @brief One duty-cycle wake: sample, upload when due, then deep-sleep until the next slot
+ */
+void runDutyCycleWake() {
+  const DutyCycleConfig dutyConfig = { DUTY_CYCLE_PERIOD_MS, DUTY_CYCLE_UPLOAD_EVERY, 1000 };
+  const DutyEnergyModel energyModel = { DUTY_SUPPLY_V, DUTY_ACTIVE_MA, DUTY_RADIO_MA, DUTY_SLEEP_MA };
+
+  if (!dutyCycleValid(dutyState)) {
+    dutyCycleReset(dutyState); // Power-on, or RTC contents from another firmware layout
+    dutyState.statsStartUs = rtcMicros();
+  }
+  if (esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_TIMER) {
+    dutyState.sleepStartUs = 0; // Reset rather than a timer wake: no planned wake time to measure against
+  }
+  dutyState.wakeCount++;
+
+  // The RTC clock ran through ROM boot and the bootloader, so this covers the full wake path
+  int64_t plannedWakeUs = dutyState.sleepStartUs
+                        ? dutyState.sleepStartUs + dutyState.plannedSleepUs
+                        : rtcMicros() - esp_timer_get_time();
+
+  // Sensors stay powered while the ESP32 sleeps; begin() only reconfigures them.
+  // The SGP30 needs a warm-up longer than one wake, so it is not sampled here.
+  SensorSample cycle = {};
+  workingSensors = Sensors::begin((uint8_t)~SENSOR_BIT_SGP30);
+  recordReadings(cycle, Sensors::read(workingSensors, cycle));
+
+  int64_t sampleUs = rtcMicros();
+  if (dutyState.sleepStartUs) {
+    dutyState.stats.wakeLatency.add((sampleUs - plannedWakeUs) / 1000.0f);
+  }
+  dutyCyclePush(dutyState, captureSample(), workingSensorMask(), sampleUs / 1000);
+  dutyState.stats.samples++;
+
+  float radioMs = 0.0f;
+  if (dutyCycleUploadDue(dutyState, dutyConfig)) {
+    int64_t radioStartUs = esp_timer_get_time();
+    bool uploaded = false;
+    if (initWifi(DUTY_CYCLE_RADIO_TIMEOUT_MS)) {
+      plannedWakeUs += syncDutyCycleClock();
+      if (initFirebase(DUTY_CYCLE_RADIO_TIMEOUT_MS)) {
+        uploaded = uploadDutyCycleBatch();
+      }
+    }
+    if (!uploaded) {
+      dutyState.stats.uploadFailures++; // Samples stay buffered for the next upload wake
+    }
+    WiFi.disconnect(true);
+    WiFi.mode(WIFI_OFF);
+    radioMs = (esp_timer_get_time() - radioStartUs) / 1000.0f;
+    dutyState.stats.upload.add(radioMs);
+  }
+
+  // Sleep out the rest of the period so wakes stay on the grid
+  int64_t sleepStartUs = rtcMicros();
+  uint64_t awakeUs = sleepStartUs > plannedWakeUs ? sleepStartUs - plannedWakeUs : 0;
+  uint64_t sleepUs = dutyCycleSleepUs(dutyConfig, awakeUs);
+  if (radioMs == 0.0f) {
+    dutyState.stats.awake.add(awakeUs / 1000.0f);
+  }
+  dutyState.stats.energyMj += dutyCycleEnergyMj(energyModel, awakeUs / 1000.0f - radioMs, radioMs, sleepUs / 1000.0f);
+  dutyState.sleepStartUs = sleepStartUs;
+  dutyState.plannedSleepUs = (uint32_t)sleepUs;
+
+  Serial.flush();
+  esp_sleep_enable_timer_wakeup(sleepUs);
+  esp_deep_sleep_start();
+}
+
+/**
+ * @brief Correct the RTC clock with NTP (its slow clock drifts by up to a few percent in sleep)
+ * @return the step applied to the clock in microseconds; buffered timestamps are shifted by it
+ */
+int64_t syncDutyCycleClock() {
+  int64_t rtcBeforeUs = rtcMicros();
+  int64_t monoBeforeUs = esp_timer_get_time();
+
+  sntp_set_sync_status(SNTP_SYNC_STATUS_RESET);
+  configTime(5 * 3600 + 30 * 60, 0, "pool.ntp.org", "time.nist.gov", "time.google.com");
+  uint32_t start = millis();
+  while (sntp_get_sync_status() != SNTP_SYNC_STATUS_COMPLETED) {
+    if (millis() - start >= DUTY_CYCLE_RADIO_TIMEOUT_MS) {
+      return 0; // Keep the free-running clock until the next upload wake
+    }
+    delay(50);
+  }
+
+  int64_t stepUs = (rtcMicros() - rtcBeforeUs) - (esp_timer_get_time() - monoBeforeUs);
+  dutyCycleClockStepped(dutyState, stepUs / 1000);
+  dutyState.statsStartUs += stepUs;
+  return stepUs;
+}
+
+/**
+ * @brief Upload the buffered samples as ML_Training_Chunks documents plus the latest live data
+ * Samples are dropped from the RTC buffer only once their chunk is stored.
+ */
+bool uploadDutyCycleBatch() {
+  BatchLease batch(batchPool);
+  ChunkLease chunk(chunkPool);
+  if (!batch || !chunk) return false;
+
+  // Latest reading for the dashboard
+  SensorSample latest;
+  int64_t latestMs;
+  uint8_t latestMask = dutyCycleSample(dutyState, dutyState.count - 1, latest, latestMs);
+  latest.epochUs = latestMs * 1000;
+  for (int node = 0; node < LIVE_NODE_COUNT; node++) {
+    if (!(latestMask & (1 << node))) {
+      continue; // Not fitted, or not read on that wake - leave its node alone
+    }
+    JsonLease json(jsonPool);
+    if (!json) return false;
+    buildLivePayload(*json, (LiveNode)node, latest);
+    char path[50];
+    sprintf(path, "%s/Sensor_Data/%s", USER_NAME, LIVE_NODE_NAMES[node]);
+    if (Firebase.RTDB.setJSON(&fbdo, path, json.get())) {
+      TLOG(TL_LIVE_UPLOADED, node);
+    } else {
+      TLOG(TL_LIVE_FAILED, node, fbdo.httpCode());
+    }
+  }
+
+  while (dutyState.count > 0) {
+    uint8_t rows = dutyState.count < ML_BATCH_CAPACITY ? dutyState.count : ML_BATCH_CAPACITY;
+    uint8_t mask = 0;
+    batch->clear();
+    for (uint8_t i = 0; i < rows; i++) {
+      MlBatchRow* row = batch->nextRow();
+      int64_t timeMs;
+      mask |= dutyCycleSample(dutyState, i, row->sample, timeMs);
+      row->timeMs = (double)timeMs;
+      row->actionsOn = 0;
+      batch->push();
+    }
+
+    size_t length = batch->encode(chunk->text, sizeof(chunk->text), mask, false);
+    if (length == 0) {
+      TLOG(TL_ML_BATCH_OVERSIZE);
+      dutyCycleConsume(dutyState, rows);
+      continue;
+    }
+
+    // The claimed slot lives in RTC memory, so a retry on a later wake reuses it
+    if (dutyState.chunkIndex == 0) {
+      dutyState.chunkIndex = advanceMLCounter("chunk_count", "ML_Training_Chunks",
+                                              (runtimeConfig.maxMlRecords + DUTY_CYCLE_UPLOAD_EVERY - 1) / DUTY_CYCLE_UPLOAD_EVERY);
+    }
+    char chunkPath[80];
+    sprintf(chunkPath, "%s/ML_Training_Chunks/chunk_%03d", USER_NAME, dutyState.chunkIndex);
+    JsonLease chunkJson(jsonPool);
+    if (!chunkJson) return false;
+    chunkJson->setJsonData(chunk->text);
+    if (!Firebase.RTDB.setJSON(&fbdo, chunkPath, chunkJson.get())) {
+      TLOG(TL_ML_BATCH_FAILED, fbdo.httpCode());
+      return false;
+    }
+    TLOG(TL_ML_BATCH_UPLOADED, rows, length);
+    dutyState.chunkIndex = 0;
+    dutyCycleConsume(dutyState, rows);
+  }
+
+  dutyState.stats.uploads++;
+  uploadDutyCycleReport();
+  return true;
+}
+
+/**
+ * @brief Report wake latency, awake/radio time and energy per sample to <USER>/Duty_Cycle
+ * Energy figures are DutyEnergyModel estimates over the measured phase durations.
+ */
+void uploadDutyCycleReport() {
+  const DutyCycleStats &stats = dutyState.stats;
+  float elapsedS = (rtcMicros() - dutyState.statsStartUs) / 1e6f;
+
+  JsonLease reportJson(jsonPool);
+  if (!reportJson) return;
+  reportJson->set("period_ms", DUTY_CYCLE_PERIOD_MS);
+  reportJson->set("upload_every", DUTY_CYCLE_UPLOAD_EVERY);
+  reportJson->set("wake_count", (int)dutyState.wakeCount);
+  reportJson->set("samples", (int)stats.samples);
+  reportJson->set("uploads", (int)stats.uploads);
+  reportJson->set("upload_failures", (int)stats.uploadFailures);
+  reportJson->set("overwritten", (int)stats.overwritten);
+  reportJson->set("wake_latency_ms/mean", stats.wakeLatency.mean());
+  reportJson->set("wake_latency_ms/max", stats.wakeLatency.maxMs);
+  reportJson->set("awake_ms/mean", stats.awake.mean());
+  reportJson->set("awake_ms/max", stats.awake.maxMs);
+  reportJson->set("radio_ms/mean", stats.upload.mean());
+  reportJson->set("radio_ms/max", stats.upload.maxMs);
+  reportJson->set("energy_mj_per_sample", stats.samples ? stats.energyMj / stats.samples : 0.0f);
+  reportJson->set("avg_current_ma", elapsedS > 0 ? stats.energyMj / (DUTY_SUPPLY_V * elapsedS) : 0.0f);
+
+  char reportPath[60];
+  sprintf(reportPath, "%s/Duty_Cycle", USER_NAME);
+  if (Firebase.RTDB.setJSON(&fbdo, reportPath, reportJson.get())) {
+    memset(&dutyState.stats, 0, sizeof(dutyState.stats));
+    dutyState.statsStartUs = rtcMicros();
+  }
+}
+#endif
+
+#if ENABLE_GPRS_FALLBACK
+static_assert(GPRS_BATCH_MAX_BYTES <= SIM800_MAX_SEND_BYTES, "GPRS batch must fit one AT+CIPSEND");
+
+/**
+ * @brief Feed the Wi-Fi state to the link selector and act on a switch
+ * @return true while GPRS is the active uplink
+ */
+bool updateUplinkLink(uint32_t nowMs) {
+  if (linkSelector.update(WiFi.status() == WL_CONNECTED, nowMs)) {
+    UplinkLink link = linkSelector.active();
+    TLOG(TL_LINK_SWITCHED, (unsigned)link, linkSelector.switches());
+    if (link == LINK_WIFI) {
+      // Send what the fallback buffered while the bearer is still up, then release it
+      sendGprsBatch();
+      modem.gprsDetach();
+    }
+  }
+  return linkSelector.active() == LINK_GPRS;
+}
+
+/**
+ * @brief Add the latest reading to the pending GPRS batch (oldest is overwritten when full)
+ */
+void bufferGprsSample() {
+  uint32_t dropped = gprsBatch.dropped();
+  SensorSample sample = captureSample();
+  gprsBatch.push(sample, workingSensorMask(), sample.epochUs / 1000);
+  if (gprsBatch.dropped() != dropped) {
+    TLOG(TL_GPRS_OVERWRITTEN, gprsBatch.dropped());
+  }
+}
+
+/**
+ * @brief Send the pending samples as one GprsBatch frame to the TCP sink
+ * The batch is kept on failure and goes out with the next attempt.
+ */
+void sendGprsBatch() {
+  static uint8_t frame[GPRS_BATCH_MAX_BYTES];
+
+  if (gprsBatch.size() == 0) {
+    return;
+  }
+  if (!modem.gprsAttach(GPRS_APN)) {
+    TLOG(TL_GPRS_ATTACH_FAILED);
+    return;
+  }
+
+  size_t length = gprsBatch.encode(USER_NAME, frame, sizeof(frame));
+  if (modem.tcpSend(GPRS_SINK_HOST, GPRS_SINK_PORT, frame, length)) {
+    TLOG(TL_GPRS_SENT, gprsBatch.size(), length);
+    gprsBatch.clear();
+    ledDataBlink();
+  } else {
+    TLOG(TL_GPRS_FAILED, gprsBatch.size());
   }
 }
+#endif
 
 // ----------------------------------------------------------------
 // FUNCTION: Update Sensor Status to Firebase
 // ----------------------------------------------------------------
 void updateSensorStatusToFirebase() {
   // Create JSON payload with sensor statuses
-  FirebaseJson statusJson;
+  JsonLease statusJson(jsonPool);
+  if (!statusJson) return;
   
-  statusJson.set("AHT10", status_AHT10);
-  statusJson.set("MLX90614", status_MLX90614);
-  statusJson.set("MPU6050", status_MPU6050);
-  statusJson.set("SGP30", status_SGP30);
+  for (int node = 0; node < LIVE_NODE_COUNT; node++) {
+    statusJson->set(LIVE_NODE_NAMES[node], sensorStatusText(Sensors::fittedMask(), workingSensors, node));
+  }
   
   // Get current time for last update
   time_t now = time(nullptr);
   struct tm* timeinfo = localtime(&now);
   char timeStr[25];
   strftime(timeStr, sizeof(timeStr), "%Y-%m-%d %H:%M:%S", timeinfo);
-  statusJson.set("last_update", timeStr);
+  statusJson->set("last_update", timeStr);
 
   // Upload to Firebase
   char statusPath[60];
   sprintf(statusPath, "%s/Sensor_Status", USER_NAME);
   
-  if (Firebase.RTDB.setJSON(&fbdo, statusPath, &statusJson)) {
+  if (Firebase.RTDB.setJSON(&fbdo, statusPath, statusJson.get())) {
     DEBUG_PRINTLN("[Sensor Status] Updated to Firebase");
-    DEBUG_PRINT("  AHT10: ");
-    DEBUG_PRINT(status_AHT10);
-    DEBUG_PRINT(" | MLX90614: ");
-    DEBUG_PRINT(status_MLX90614);
-    DEBUG_PRINT(" | MPU6050: ");
-    DEBUG_PRINT(status_MPU6050);
-    DEBUG_PRINT(" | SGP30: ");
-    DEBUG_PRINTLN(status_SGP30);
+    for (int node = 0; node < LIVE_NODE_COUNT; node++) {
+      DEBUG_PRINTF("  %s: %s\n", LIVE_NODE_NAMES[node], sensorStatusText(Sensors::fittedMask(), workingSensors, node));
+    }
   } else {
     DEBUG_PRINT("[Sensor Status] Failed to update: ");
     DEBUG_PRINTLN(fbdo.errorReason());
   }
   
-  vTaskDelay(pdMS_TO_TICKS(50)); // Yield
+  vTaskDelay(1); // Yield
+
+  // Unit and resolution of every field this build uploads, so consumers don't hard-code them
+  JsonLease schemaJson(jsonPool);
+  if (!schemaJson) return;
+  char key[48];
+  for (int f = 0; f < WF_COUNT; f++) {
+    if (!(Sensors::fittedMask() & sensorFieldBit(f))) {
+      continue;
+    }
+    snprintf(key, sizeof(key), "%s/%s/unit", LIVE_NODE_NAMES[SENSOR_FIELDS[f].node], SENSOR_FIELDS[f].name);
+    schemaJson->set(key, SENSOR_FIELDS[f].unit);
+    snprintf(key, sizeof(key), "%s/%s/decimals", LIVE_NODE_NAMES[SENSOR_FIELDS[f].node], SENSOR_FIELDS[f].name);
+    schemaJson->set(key, (int)SENSOR_FIELDS[f].decimals);
+  }
+  char schemaPath[60];
+  sprintf(schemaPath, "%s/Sensor_Schema", USER_NAME);
+  if (!Firebase.RTDB.setJSON(&fbdo, schemaPath, schemaJson.get())) {
+    DEBUG_PRINT("[Sensor Schema] Failed to update: ");
+    DEBUG_PRINTLN(fbdo.errorReason());
+  }
 }
 
 // ----------------------------------------------------------------
@@ -949,105 +2279,502 @@ void sim800a_init() {
   // Give the module time to boot
   delay(3000); 
 
-  // Send "AT" command to check connection and sync baud rate
-  simSerial.println("AT");
-  if (!checkResponse("OK", 2000)) {
-    DEBUG_PRINTLN("Error: No response from SIM800A. Check wiring and power.");
-    // You might want to halt here or retry
-    //while(1);
-  }
-  DEBUG_PRINTLN("Module is responding.");
-
-  // Set SMS mode to Text Mode
-  simSerial.println("AT+CMGF=1");
-  if (!checkResponse("OK", 2000)) {
-    DEBUG_PRINTLN("Error: Failed to set SMS to text mode.");
-  } else {
+  // AT (also syncs the baud rate), echo off, SMS text mode
+  if (modem.begin()) {
     DEBUG_PRINTLN("SIM800A initialized successfully in text mode.");
+  } else {
+    DEBUG_PRINT("Error: SIM800A not ready. Check wiring and power. Module Response: ");
+    DEBUG_PRINTLN(modem.lastResponse());
   }
-
-  // Optional: Set character set to GSM (default)
-  // simSerial.println("AT+CSCS=\"GSM\"");
-  // checkResponse("OK", 1000);
 }
 
 // ----------------------------------------------------------------
 // FUNCTION: Send an SMS
 // ----------------------------------------------------------------
-void send_sms(String phoneNumber, String message) {
+bool send_sms(const char* phoneNumber, const char* message) {
   DEBUG_PRINT("Attempting to send SMS to: ");
   DEBUG_PRINTLN(phoneNumber);
 
-  // 1. Set the destination phone number
-  simSerial.print("AT+CMGS=\"");
-  simSerial.print(phoneNumber);
-  simSerial.println("\"");
+  // AT+CMGS="number" -> '>' -> text + Ctrl+Z -> +CMGS: (up to 10 seconds)
+  bool sent = modem.sendSms(phoneNumber, message);
+  if (!sent) {
+    DEBUG_PRINT("Error: Failed to send SMS. Module Response: ");
+    DEBUG_PRINTLN(modem.lastResponse());
+  }
+  return sent;
+}
 
-  // 2. Wait for the ">" prompt from the module
-  if (checkResponse(">", 2000)) {
-    DEBUG_PRINTLN("Module is ready to accept message text.");
-    
-    // 3. Send the message text
-    simSerial.print(message);
-    
-    // 4. Send the "Ctrl+Z" character (ASCII 26) to send the message
-    simSerial.write(26);
 
-    // 5. Wait for the "+CMGS:" confirmation
-    // This can take a while (up to 10 seconds)
-    if (checkResponse("+CMGS:", 10000)) {
-      DEBUG_PRINTLN("SMS sent successfully!");
-    } else {
-      DEBUG_PRINTLN("Error: Failed to send SMS. No +CMGS confirmation.");
+/**
+ * @brief Queue an SMS alert for every action that is ON
+ * Identical alerts still waiting in the queue are merged, not repeated.
+ */
+void Alert_MSG() {
+  const ActionText* actions[ACTION_COUNT] = { &Action_1, &Action_2, &Action_3, &Action_4, &Action_5 };
+  for (int i = 0; i < ACTION_COUNT; i++) {
+    if (*actions[i] == "ON") {
+      uplinkEnqueue(JOB_SMS_ALERT, UPLINK_ALERT, i + 1, UPLINK_ALERT_DEADLINE_MS);
     }
-  } else {
-    DEBUG_PRINTLN("Error: Did not receive '>' prompt. Module not ready.");
   }
 }
 
-// ----------------------------------------------------------------
-// HELPER FUNCTION: Check module response
-// Waits for a specific string in the module's serial reply.
-// ----------------------------------------------------------------
-bool checkResponse(String expected, unsigned int timeout) {
-  String response = "";
-  long int startTime = millis();
-
-  while ((millis() - startTime) < timeout) {
-    while (simSerial.available()) {
-      char c = simSerial.read();
-      response += c;
+/**
+ * @brief Send the SMS alert for one action
+ * @param actionIndex 1-based action index (the job parameter)
+ * @param attempt     retries so far; kept out of the job parameter so a retry
+ *                    merges with a fresh alert for the same action
+ */
+void sendActionAlert(int actionIndex, uint8_t attempt) {
+  char message[40];
+  snprintf(message, sizeof(message), "Alert: Action %d Triggered!", actionIndex);
+  if (send_sms(runtimeConfig.targetPhone, message)) {
+    TLOG(TL_SMS_SENT, actionIndex);
+    return;
+  }
+  TLOG(TL_SMS_FAILED, actionIndex);
+  // A +CMS ERROR or a lost confirmation is usually transient (network busy, URC noise)
+  if (attempt < (int)runtimeConfig.smsRetries) {
+    uplinkEnqueue(JOB_SMS_ALERT, UPLINK_ALERT, actionIndex, UPLINK_ALERT_DEADLINE_MS, attempt + 1);
+  }
+}
+
+/**
+ * @brief Built-in configuration: the #define defaults at the top of this file
+ */
+void runtimeConfigDefaults(RuntimeConfig &config) {
+  memset(&config, 0, sizeof(config)); // version 0 = built-in defaults
+  config.sensorPeriodMs = SENSOR_PERIOD_MS;
+  config.livePeriodMs = UPLINK_LIVE_PERIOD_MS;
+  config.mlPeriodMs = UPLINK_ML_PERIOD_MS;
+  config.actionPollMs = UPLINK_ACTION_POLL_MS;
+  config.metricsPeriodMs = UPLINK_METRICS_PERIOD_MS;
+  config.configPollMs = CONFIG_POLL_MS;
+  config.maxMlRecords = MAX_ML_RECORDS;
+  config.smsRetries = SMS_ALERT_RETRIES;
+  config.traceLogLevel = TRACE_LOG_LEVEL;
+  config.anomalyZTenths = ANOMALY_Z_TENTHS;
+  config.burstMs = BURST_MS;
+  config.burstSensorPeriodMs = BURST_SENSOR_PERIOD_MS;
+  strncpy(config.targetPhone, TARGET_PHONE_NUMBER, RUNTIME_CONFIG_PHONE_MAX);
+}
+
+/**
+ * @brief Start from the config cached in NVS, or the defaults if there is none
+ * Runs in setup() before any task exists, so the network is never waited for.
+ */
+void loadRuntimeConfig() {
+  runtimeConfigDefaults(runtimeConfig);
+
+  Preferences prefs;
+  if (prefs.begin(CONFIG_NVS_NAMESPACE, true)) {
+    RuntimeConfig cached;
+    // A blob from another schema, or one that no longer validates, is ignored
+    if (prefs.getUShort("cfg_schema", 0) == RUNTIME_CONFIG_SCHEMA &&
+        prefs.getBytesLength("cfg") == sizeof(cached) &&
+        prefs.getBytes("cfg", &cached, sizeof(cached)) == sizeof(cached) &&
+        runtimeConfigValidate(cached) == CONFIG_OK) {
+      runtimeConfig = cached;
     }
-    // Check if the expected string is in the response
-    if (response.indexOf(expected) != -1) {
-      DEBUG_PRINT("Module Response: ");
-      DEBUG_PRINTLN(response); // Print the full response for debugging
-      return true;
+    prefs.end();
+  }
+  TLOG(TL_CONFIG_LOADED, runtimeConfig.version);
+}
+
+/**
+ * @brief Consistent copy of the active config (safe from any task)
+ */
+RuntimeConfig configSnapshot() {
+  RuntimeConfig config;
+  portENTER_CRITICAL(&configMux);
+  config = runtimeConfig;
+  portEXIT_CRITICAL(&configMux);
+  return config;
+}
+
+/**
+ * @brief Fetch <USER>/Config when its version moved past the active one and apply it
+ * The document is parsed into a candidate built from the defaults; nothing changes unless
+ * every key and the candidate as a whole validate. Readers pick the new values up on their
+ * next cycle - no restart.
+ */
+void pollRuntimeConfig() {
+  static uint32_t rejectedVersion = 0; // Don't re-download a document already refused
+
+  char configPath[60];
+  sprintf(configPath, "%s/Config/version", USER_NAME);
+  if (!Firebase.RTDB.getInt(&fbdo, configPath)) {
+    return; // No document yet, or offline: keep the active config
+  }
+  int version = fbdo.intData();
+  if (version <= 0 || (uint32_t)version <= runtimeConfig.version || (uint32_t)version == rejectedVersion) {
+    return;
+  }
+
+  sprintf(configPath, "%s/Config", USER_NAME);
+  if (!Firebase.RTDB.getJSON(&fbdo, configPath)) {
+    return;
+  }
+
+  RuntimeConfig candidate;
+  runtimeConfigDefaults(candidate);
+  RuntimeConfigResult result = CONFIG_OK;
+  FixedString<32> failedKey;
+
+  FirebaseJson &json = fbdo.jsonObject();
+  size_t count = json.iteratorBegin();
+  for (size_t i = 0; i < count && result == CONFIG_OK; i++) {
+    FirebaseJson::IteratorValue item = json.valueAt(i);
+    if (item.depth != 0) {
+      continue; // Members of a nested object; the object itself already fails as a bad value
+    }
+    result = runtimeConfigSet(candidate, item.key.c_str(), item.value.c_str());
+    if (result != CONFIG_OK) {
+      failedKey = item.key.c_str();
     }
   }
-  
-  // If we timed out
-  DEBUG_PRINT("Timeout/Error. Module Response: ");
-  DEBUG_PRINTLN(response); // Print whatever we got
-  return false;
+  json.iteratorEnd();
+
+  if (result == CONFIG_OK) {
+    result = runtimeConfigValidate(candidate);
+  }
+  if (result == CONFIG_OK && candidate.version <= runtimeConfig.version) {
+    return; // Version went backwards between the two reads; wait for the next poll
+  }
+  if (result != CONFIG_OK) {
+    rejectedVersion = version;
+    TLOG(TL_CONFIG_REJECTED, version, result);
+    reportConfigStatus(version, result, failedKey.c_str());
+    return;
+  }
+
+  // Swap in one step so no task sees half of the old and half of the new config
+  portENTER_CRITICAL(&configMux);
+  runtimeConfig = candidate;
+  portEXIT_CRITICAL(&configMux);
+#if ENABLE_TRACE_LOG
+  traceLogSetLevel(candidate.traceLogLevel);
+#endif
+
+  Preferences prefs;
+  if (prefs.begin(CONFIG_NVS_NAMESPACE, false)) {
+    prefs.putUShort("cfg_schema", RUNTIME_CONFIG_SCHEMA);
+    prefs.putBytes("cfg", &candidate, sizeof(candidate));
+    prefs.end();
+  }
+
+  TLOG(TL_CONFIG_APPLIED, candidate.version);
+  reportConfigStatus(candidate.version, CONFIG_OK, "");
 }
 
+/**
+ * @brief Acknowledge a config document under <USER>/Config_Status
+ */
+void reportConfigStatus(uint32_t version, RuntimeConfigResult result, const char* key) {
+  JsonLease statusJson(jsonPool);
+  if (!statusJson) return;
+  statusJson->set("version", (int)version);
+  statusJson->set("active_version", (int)runtimeConfig.version);
+  statusJson->set("result", RUNTIME_CONFIG_RESULT_NAMES[result]);
+  if (key[0] != '\0') {
+    statusJson->set("key", key);
+  }
+  statusJson->set("time_ms", (double)(epochMicros() / 1000));
 
-void Alert_MSG() {
-  if (Action_1 == "ON") {
-    send_sms(TARGET_PHONE_NUMBER, "Alert: Action 1 Triggered!");
+  char statusPath[60];
+  sprintf(statusPath, "%s/Config_Status", USER_NAME);
+  Firebase.RTDB.setJSON(&fbdo, statusPath, statusJson.get());
+}
+
+/**
+ * @brief Restore the last executed command seq from NVS
+ */
+void loadCommandState() {
+  Preferences prefs;
+  if (prefs.begin(CONFIG_NVS_NAMESPACE, true)) {
+    commandLastSeq = prefs.getUInt("cmd_seq", 0);
+    prefs.end();
   }
-  if (Action_2 == "ON") {
-    send_sms(TARGET_PHONE_NUMBER, "Alert: Action 2 Triggered!");
+}
+
+/**
+ * @brief Read <USER>/Command and run it if it is new
+ * An unchanged envelope is skipped by its fingerprint, so an idle poll is one small read.
+ * The seq is stored before the command runs: a reset part-way through loses the command
+ * rather than running it twice. An ack that failed to upload is retried on the next poll.
+ */
+void pollCommand() {
+  static uint32_t handledHash = 0;
+  static CommandAck owedAck;
+  static bool ackOwed = false;
+
+  if (ackOwed) {
+    ackOwed = !ackCommand(owedAck);
   }
-  if (Action_3 == "ON") {
-    send_sms(TARGET_PHONE_NUMBER, "Alert: Action 3 Triggered!");
+
+  char commandPath[60];
+  sprintf(commandPath, "%s/Command", USER_NAME);
+  if (!Firebase.RTDB.getString(&fbdo, commandPath)) {
+    return; // No command yet, or offline
   }
-  if (Action_4 == "ON") {
-    send_sms(TARGET_PHONE_NUMBER, "Alert: Action 4 Triggered!");
+  // Copied out of the response buffer without a heap String; one spare character lets
+  // commandParse() see that an over-long envelope is over COMMAND_TEXT_MAX and reject it
+  const char* raw = fbdo.to<const char*>();
+  FixedString<COMMAND_TEXT_MAX + 1> text(raw ? raw : "");
+  uint32_t hash = commandTextHash(raw ? raw : "");
+  if (hash == handledHash) {
+    return;
   }
-  if (Action_5 == "ON") {
-    send_sms(TARGET_PHONE_NUMBER, "Alert: Action 5 Triggered!");
+  handledHash = hash;
+
+  CommandAck ack;
+  memset(&ack, 0, sizeof(ack));
+  ack.receivedMs = epochMicros() / 1000;
+
+  CommandEnvelope cmd;
+  CommandResult result = commandParse(text.c_str(), cmd);
+  if (result == CMD_OK) {
+    result = commandCheck(cmd, commandLastSeq, ack.receivedMs);
+  }
+  if (result == CMD_DUPLICATE) {
+    return; // Executed and acknowledged already (typically before a reboot)
+  }
+  if (result == CMD_OK) {
+    commandLastSeq = cmd.seq;
+    Preferences prefs;
+    if (prefs.begin(CONFIG_NVS_NAMESPACE, false)) {
+      prefs.putUInt("cmd_seq", commandLastSeq);
+      prefs.end();
+    }
+    result = executeCommand(cmd);
+  }
+
+  ack.seq = cmd.seq;
+  ack.type = cmd.type;
+  ack.result = result;
+  ack.issuedMs = cmd.issuedMs;
+  ack.executedMs = epochMicros() / 1000;
+  if (result == CMD_OK) {
+    commandsExecuted++;
+    if (ack.latencyMs() >= 0) {
+      commandLatencyMs.add((float)ack.latencyMs());
+    }
+    TLOG(TL_COMMAND_EXECUTED, ack.seq, ack.type, (int32_t)ack.latencyMs());
+  } else {
+    commandsRejected++;
+    TLOG(TL_COMMAND_REJECTED, ack.seq, result);
   }
 
-}
\ No newline at end of file
+  if (!ackCommand(ack)) {
+    owedAck = ack;
+    ackOwed = true;
+  }
+}
+
+/**
+ * @brief Carry out a command that passed commandCheck()
+ */
+CommandResult executeCommand(const CommandEnvelope &cmd) {
+  switch (cmd.type) {
+    case CMD_PING:
+      return CMD_OK;
+
+    case CMD_ACTION: {
+      uint8_t index;
+      bool on;
+      commandActionParams(cmd.params, index, on);
+      // Write through first, or the legacy poll would read the old value back
+      char actionPath[50];
+      sprintf(actionPath, "%s/Actions/action_%u", USER_NAME, index);
+      if (!Firebase.RTDB.setString(&fbdo, actionPath, on ? "ON" : "OFF")) {
+        return CMD_FAILED;
+      }
+      ActionText* actions[ACTION_COUNT] = { &Action_1, &Action_2, &Action_3, &Action_4, &Action_5 };
+      *actions[index - 1] = on ? "ON" : "OFF";
+      if (on) {
+        uplinkEnqueue(JOB_SMS_ALERT, UPLINK_ALERT, index, UPLINK_ALERT_DEADLINE_MS);
+      }
+      return CMD_OK;
+    }
+
+    case CMD_TRACE_LEVEL:
+#if ENABLE_TRACE_LOG
+      traceLogSetLevel(cmd.params[0] - '0');
+#endif
+      return CMD_OK;
+
+    case CMD_CONFIG_POLL:
+      pollRuntimeConfig(); // Its outcome goes to Config_Status as usual
+      return CMD_OK;
+
+    default:
+      return CMD_UNKNOWN_TYPE;
+  }
+}
+
+/**
+ * @brief Write an acknowledgement to <USER>/Command_Ack
+ */
+bool ackCommand(const CommandAck &ack) {
+  JsonLease ackJson(jsonPool);
+  if (!ackJson) return false;
+  ackJson->set("protocol", COMMAND_PROTOCOL_VERSION);
+  ackJson->set("seq", (double)ack.seq);
+  ackJson->set("type", ack.type < CMD_TYPE_COUNT ? COMMAND_TYPE_NAMES[ack.type] : "unknown");
+  ackJson->set("result", COMMAND_RESULT_NAMES[ack.result]);
+  ackJson->set("received_ms", (double)ack.receivedMs);
+  ackJson->set("executed_ms", (double)ack.executedMs);
+  if (ack.latencyMs() >= 0) {
+    ackJson->set("latency_ms", (double)ack.latencyMs());
+  }
+
+  char ackPath[60];
+  sprintf(ackPath, "%s/Command_Ack", USER_NAME);
+  if (!Firebase.RTDB.setJSON(&fbdo, ackPath, ackJson.get())) {
+    TLOG(TL_COMMAND_ACK_FAILED, ack.seq, fbdo.httpCode());
+    return false;
+  }
+  return true;
+}
+
+#if ENABLE_ANOMALY_BURST
+static_assert(BURST_CHUNK_ROWS <= ML_BATCH_CAPACITY, "a burst chunk must fit one MlBatch");
+
+/**
+ * @brief Score the cycle that just finished and feed it to the burst ring (sensor task)
+ * @return true while a burst is running
+ */
+bool observeAnomalies(const RuntimeConfig &config) {
+  static uint32_t reportedDrops = 0;
+
+  SensorSample sample = captureSample();
+  uint8_t mask = workingSensorMask();
+  AnomalyScore score = anomalyDetector.update(sample, mask);
+  bool anomalous = score.z * 10.0f >= (float)config.anomalyZTenths;
+  int64_t timeMs = sample.epochUs != 0 ? sample.epochUs / 1000 : (int64_t)millis();
+
+  BurstEvent event;
+  bool active;
+  uint16_t burst;
+  uint32_t dropped;
+  portENTER_CRITICAL(&burstMux);
+  burstRecorder.configure(BURST_PRE_TRIGGER_ROWS, config.burstMs, BURST_MAX_MS);
+  event = burstRecorder.observe(sample, mask, timeMs, score, anomalous, millis());
+  active = burstRecorder.active();
+  burst = burstRecorder.lastTrigger().burst;
+  dropped = burstRecorder.dropped();
+  portEXIT_CRITICAL(&burstMux);
+  (void)burst; // Only traced
+
+  if (event == BURST_STARTED) {
+    TLOG(TL_BURST_STARTED, burst, score.field, score.z, score.value);
+  } else if (event == BURST_ENDED) {
+    TLOG(TL_BURST_ENDED, burst);
+  }
+  if (dropped != reportedDrops) {
+    reportedDrops = dropped;
+    TLOG(TL_BURST_DROPPED, dropped);
+  }
+  return active;
+}
+
+/**
+ * @brief Burst samples waiting for upload (safe from any task)
+ */
+size_t burstPending() {
+  size_t pending;
+  portENTER_CRITICAL(&burstMux);
+  pending = burstRecorder.pending();
+  portEXIT_CRITICAL(&burstMux);
+  return pending;
+}
+
+/**
+ * @brief Upload the next BURST_CHUNK_ROWS burst samples as one chunk document
+ * The first chunk of a burst claims a rotating <USER>/Anomaly_Bursts/burst_NNN slot and
+ * writes what triggered it; chunks use the ML chunk format (tools/ml_chunks decodes them).
+ * Rows stay in the ring until their upload succeeded.
+ */
+void uploadBurstChunk() {
+  static BurstRow rows[BURST_CHUNK_ROWS];
+  static uint16_t currentBurst = 0;   // Burst whose trigger document is written
+  static uint16_t claimedBurst = 0;   // Burst that owns the burst_NNN slot in burstIndex
+  static int burstIndex = 0;
+  static int chunkIndex = 0;
+
+  size_t count;
+  BurstTrigger trigger;
+  portENTER_CRITICAL(&burstMux);
+  count = burstRecorder.peek(rows, BURST_CHUNK_ROWS);
+  trigger = burstRecorder.lastTrigger();
+  portEXIT_CRITICAL(&burstMux);
+  if (count == 0) {
+    return;
+  }
+
+  char path[80];
+  if (rows[0].burst != currentBurst) {
+    // The trigger is owed until it is written: a missing lease or a failed
+    // write retries it on the next call, in the slot already claimed
+    JsonLease triggerJson(jsonPool);
+    if (!triggerJson) return;
+    if (rows[0].burst != claimedBurst) {
+      claimedBurst = rows[0].burst;
+      burstIndex = advanceMLCounter("burst_count", "Anomaly_Bursts", MAX_ANOMALY_BURSTS);
+      chunkIndex = 0;
+    }
+
+    triggerJson->set("burst", (int)claimedBurst);
+    if (trigger.burst == claimedBurst) {  // Else a newer burst already replaced the record
+      char field[32];
+      snprintf(field, sizeof(field), "%s/%s", LIVE_NODE_NAMES[SENSOR_FIELDS[trigger.score.field].node],
+               SENSOR_FIELDS[trigger.score.field].name);
+      triggerJson->set("field", field);
+      triggerJson->set("z", trigger.score.z);
+      triggerJson->set("value", trigger.score.value);
+      triggerJson->set("time_ms", (double)trigger.timeMs);
+      triggerJson->set("pre_trigger_rows", (int)trigger.preTriggerRows);
+    }
+    sprintf(path, "%s/Anomaly_Bursts/burst_%03d/trigger", USER_NAME, burstIndex);
+    if (!Firebase.RTDB.setJSON(&fbdo, path, triggerJson.get())) {
+      TLOG(TL_BURST_TRIGGER_FAILED, claimedBurst, fbdo.httpCode());
+      return;
+    }
+    currentBurst = claimedBurst;
+  }
+
+  BatchLease batch(batchPool);
+  ChunkLease chunk(chunkPool);
+  JsonLease chunkJson(jsonPool);
+  if (!batch || !chunk || !chunkJson) return;
+  uint8_t mask = 0;
+  for (size_t i = 0; i < count; i++) {
+    MlBatchRow* row = batch->nextRow();
+    row->sample = rows[i].sample;
+    row->timeMs = (double)rows[i].timeMs;
+    row->actionsOn = 0;
+    mask |= rows[i].mask;
+    batch->push();
+  }
+
+  size_t length = batch->encode(chunk->text, sizeof(chunk->text), mask, false);
+  if (length == 0) {
+    TLOG(TL_ML_BATCH_OVERSIZE);
+    portENTER_CRITICAL(&burstMux);
+    burstRecorder.commit(); // Would never fit; don't retry it forever
+    portEXIT_CRITICAL(&burstMux);
+    return;
+  }
+
+  sprintf(path, "%s/Anomaly_Bursts/burst_%03d/chunk_%02d", USER_NAME, burstIndex, chunkIndex);
+  chunkJson->setJsonData(chunk->text);
+  if (Firebase.RTDB.setJSON(&fbdo, path, chunkJson.get())) {
+    portENTER_CRITICAL(&burstMux);
+    burstRecorder.commit();
+    portEXIT_CRITICAL(&burstMux);
+    chunkIndex++;
+    TLOG(TL_BURST_UPLOADED, currentBurst, count, length);
+  } else {
+    TLOG(TL_BURST_FAILED, fbdo.httpCode());
+  }
+}
+#endif
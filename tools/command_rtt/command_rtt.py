@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+"""Send commands to a device through the Realtime Database and time the acknowledgements.
+
+Usage: command_rtt.py <database url> [--user User1] [--auth TOKEN] [--count 20]
+                      [--interval 2] [--type ping] [--params P] [--ttl-ms 30000] [--timeout 60]
+
+Each command is written to <user>/Command as a protocol v1 envelope
+(lib/CommandProtocol) with the next seq, then <user>/Command_Ack is polled
+until the device acknowledges that seq. Per command it prints the round trip
+on this machine's clock and the device's own figures. The summary gives
+min/median/p95/max of the round trip. A device polls the envelope with the
+actions (UPLINK_ACTION_POLL_MS / action_poll_ms), so expect the round trip
+to spread over about one poll period.
+
+--auth is a database secret or ID token, appended as ?auth=. Without it the
+rules must allow unauthenticated access to the two nodes.
+"""
+import argparse
+import json
+import sys
+import time
+import urllib.request
+
+PROTOCOL_VERSION = 1
+
+
+def rtdb_url(base, path, auth):
+    url = "%s/%s.json" % (base.rstrip("/"), path)
+    return url + ("?auth=" + auth if auth else "")
+
+
+def rtdb_get(base, path, auth):
+    with urllib.request.urlopen(rtdb_url(base, path, auth), timeout=10) as response:
+        return json.loads(response.read().decode())
+
+
+def rtdb_put(base, path, auth, value):
+    request = urllib.request.Request(rtdb_url(base, path, auth), method="PUT",
+                                     data=json.dumps(value).encode(),
+                                     headers={"Content-Type": "application/json"})
+    with urllib.request.urlopen(request, timeout=10) as response:
+        response.read()
+
+
+def last_seq(base, user, auth):
+    """Highest seq already used, from the current envelope and the last ack."""
+    seq = 0
+    envelope = rtdb_get(base, user + "/Command", auth)
+    if isinstance(envelope, str):
+        fields = envelope.split(";")
+        if len(fields) > 1 and fields[1].isdigit():
+            seq = int(fields[1])
+    ack = rtdb_get(base, user + "/Command_Ack", auth)
+    if isinstance(ack, dict) and isinstance(ack.get("seq"), (int, float)):
+        seq = max(seq, int(ack["seq"]))
+    return seq
+
+
+def percentile(values, fraction):
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(round(fraction * (len(ordered) - 1))))]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("database")
+    parser.add_argument("--user", default="User1")
+    parser.add_argument("--auth")
+    parser.add_argument("--count", type=int, default=20)
+    parser.add_argument("--interval", type=float, default=2.0, help="seconds between an ack and the next command")
+    parser.add_argument("--type", default="ping")
+    parser.add_argument("--params", default="")
+    parser.add_argument("--ttl-ms", type=int, default=30000, help="expiry after issue, 0 = never")
+    parser.add_argument("--timeout", type=float, default=60.0, help="seconds to wait for each ack")
+    args = parser.parse_args()
+
+    seq = last_seq(args.database, args.user, args.auth)
+    rtts = []
+    lost = 0
+    print("seq      rtt_ms  result        device_latency_ms  receive_to_exec_ms")
+    for _ in range(args.count):
+        seq += 1
+        issued_ms = int(time.time() * 1000)
+        expires_ms = issued_ms + args.ttl_ms if args.ttl_ms else 0
+        envelope = "%d;%d;%s;%d;%d;%s" % (PROTOCOL_VERSION, seq, args.type, issued_ms, expires_ms, args.params)
+
+        start = time.monotonic()
+        rtdb_put(args.database, args.user + "/Command", args.auth, envelope)
+        ack = None
+        while time.monotonic() - start < args.timeout:
+            candidate = rtdb_get(args.database, args.user + "/Command_Ack", args.auth)
+            if isinstance(candidate, dict) and candidate.get("seq") == seq:
+                ack = candidate
+                break
+            time.sleep(0.1)
+        rtt_ms = (time.monotonic() - start) * 1000.0
+
+        if ack is None:
+            lost += 1
+            print("%-8d  timeout" % seq)
+        else:
+            rtts.append(rtt_ms)
+            exec_ms = ack.get("executed_ms", 0) - ack.get("received_ms", 0)
+            print("%-8d %7.0f  %-12s  %17s  %18d" % (seq, rtt_ms, ack.get("result"),
+                                                     ack.get("latency_ms", "-"), exec_ms))
+        time.sleep(args.interval)
+
+    if rtts:
+        print("\nround trip over %d acks: min %.0f ms, median %.0f ms, p95 %.0f ms, max %.0f ms"
+              % (len(rtts), min(rtts), percentile(rtts, 0.5), percentile(rtts, 0.95), max(rtts)))
+    if lost:
+        print("%d command(s) not acknowledged within %.0f s" % (lost, args.timeout))
+    return 0 if rtts and not lost else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,111 @@
+#pragma once
+
+/**
+ * Minimal stand-in for FirebaseJson used by the Linux host tools.
+ *
+ * Supports the subset the Telemetry payload builders rely on:
+ * set(path, value) where '/' in the path creates nested objects, and
+ * serialisation to compact JSON with keys in insertion order.
+ */
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+class HostJson {
+public:
+  void clear() { root_.children.clear(); }
+
+  void set(const char* path, float value) { setRaw(path, formatNumber(value)); }
+  void set(const char* path, double value) { setRaw(path, formatNumber(value)); }
+  void set(const char* path, int value) { setRaw(path, std::to_string(value)); }
+  void set(const char* path, bool value) { setRaw(path, value ? "true" : "false"); }
+  void set(const char* path, const char* value) { setRaw(path, quote(value)); }
+  void set(const char* path, const std::string &value) { setRaw(path, quote(value.c_str())); }
+  void set(const char* path, const HostJson &value) { node(path).children = value.root_.children; }
+
+  /**
+   * @brief Set a pre-serialised JSON value (array, number, ...) at path
+   */
+  void setRaw(const char* path, const std::string &json) {
+    Node &n = node(path);
+    n.children.clear();
+    n.scalar = json;
+  }
+
+  std::string toString() const {
+    std::string out;
+    serialise(root_, out);
+    return out;
+  }
+
+private:
+  struct Node {
+    std::string key;
+    std::string scalar;          // Serialised value when this is a leaf
+    std::vector<Node> children;  // Members when this is an object
+  };
+
+  Node root_;
+
+  Node &node(const char* path) {
+    Node* current = &root_;
+    std::string remaining(path);
+    while (!remaining.empty()) {
+      size_t slash = remaining.find('/');
+      std::string key = remaining.substr(0, slash);
+      remaining = (slash == std::string::npos) ? "" : remaining.substr(slash + 1);
+
+      Node* next = nullptr;
+      for (Node &child : current->children) {
+        if (child.key == key) {
+          next = &child;
+          break;
+        }
+      }
+      if (!next) {
+        current->scalar.clear();
+        current->children.push_back(Node());
+        next = &current->children.back();
+        next->key = key;
+      }
+      current = next;
+    }
+    return *current;
+  }
+
+  static std::string formatNumber(double value) {
+    if (value != value) {
+      return "null";
+    }
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.7g", value);
+    return buf;
+  }
+
+  static std::string quote(const char* value) {
+    std::string out = "\"";
+    for (const char* c = value; *c; c++) {
+      if (*c == '"' || *c == '\\') {
+        out += '\\';
+      }
+      out += *c;
+    }
+    out += '"';
+    return out;
+  }
+
+  static void serialise(const Node &n, std::string &out) {
+    if (n.children.empty() && !n.scalar.empty()) {
+      out += n.scalar;
+      return;
+    }
+    out += '{';
+    for (size_t i = 0; i < n.children.size(); i++) {
+      if (i) out += ',';
+      out += quote(n.children[i].key.c_str());
+      out += ':';
+      serialise(n.children[i], out);
+    }
+    out += '}';
+  }
+};
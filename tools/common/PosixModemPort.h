@@ -0,0 +1,97 @@
+#pragma once
+
+/**
+ * ModemPort over a POSIX file descriptor, for running the Sim800 driver on
+ * a Linux host against tools/gprs_sim/modem_sim (a pseudo-terminal) or a
+ * USB-serial adapter wired to a real module.
+ */
+#include <ModemPort.h>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+class PosixModemPort : public ModemPort {
+public:
+  PosixModemPort() : fd_(-1), peeked_(-1) {}
+  ~PosixModemPort() { close(); }
+
+  /**
+   * @brief Open a tty in raw 9600 8N1 mode
+   */
+  bool open(const char* path) {
+    fd_ = ::open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd_ < 0) {
+      perror(path);
+      return false;
+    }
+    struct termios tio;
+    if (tcgetattr(fd_, &tio) == 0) {
+      cfmakeraw(&tio);
+      cfsetispeed(&tio, B9600);
+      cfsetospeed(&tio, B9600);
+      tcsetattr(fd_, TCSANOW, &tio);
+    }
+    return true;
+  }
+
+  void close() {
+    if (fd_ >= 0) {
+      ::close(fd_);
+      fd_ = -1;
+    }
+  }
+
+  int available() override {
+    if (peeked_ < 0) {
+      uint8_t c;
+      if (::read(fd_, &c, 1) == 1) {
+        peeked_ = c;
+      }
+    }
+    return peeked_ >= 0 ? 1 : 0;
+  }
+
+  int read() override {
+    if (!available()) {
+      return -1;
+    }
+    int c = peeked_;
+    peeked_ = -1;
+    return c;
+  }
+
+  size_t write(const uint8_t* data, size_t length) override {
+    size_t done = 0;
+    while (done < length) {
+      ssize_t n = ::write(fd_, data + done, length - done);
+      if (n > 0) {
+        done += n;
+      } else {
+        struct pollfd p = { fd_, POLLOUT, 0 };
+        if (poll(&p, 1, 1000) <= 0) {
+          break;
+        }
+      }
+    }
+    return done;
+  }
+
+  uint32_t millis() override {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000ULL + ts.tv_nsec / 1000000);
+  }
+
+  void idle() override {
+    struct pollfd p = { fd_, POLLIN, 0 };
+    poll(&p, 1, 1);   // Wake as soon as the modem answers
+  }
+
+private:
+  int fd_;
+  int peeked_;
+};
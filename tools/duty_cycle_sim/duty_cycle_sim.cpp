@@ -0,0 +1,220 @@
+/**
+ * Host simulation of the deep-sleep duty cycle (ENABLE_DUTY_CYCLE).
+ *
+ * Runs the firmware's wake schedule - the same DutyCycleState buffer, upload
+ * decision, sleep computation and energy model from lib/DutyCycle - over a
+ * simulated period with randomised boot, sensing and Wi-Fi times, and
+ * reports energy per sample, average current, battery life, how stale data
+ * is by the time it reaches the database, and the chunk bytes per sample
+ * (encoded with the real MlBatch).
+ *
+ * Build from the project root:
+ *   g++ -O2 -std=c++17 -Ilib/DutyCycle -Ilib/Telemetry -Ilib/WindowStats \
+ *       tools/duty_cycle_sim/duty_cycle_sim.cpp lib/DutyCycle/DutyCycle.cpp lib/Telemetry/MlBatch.cpp \
+ *       -o duty_cycle_sim
+ *
+ * Usage:
+ *   duty_cycle_sim [--period-s 60] [--upload-every 10] [--hours 24] [--sweep]
+ *                  [--boot-ms 180] [--sense-ms 130] [--radio-ms 2500] [--radio-jitter-ms 800]
+ *                  [--radio-fail 0.05] [--battery-mah 2000]
+ *                  [--supply-v 3.7] [--active-ma 40] [--radio-ma 120] [--sleep-ma 0.8]
+ *
+ * --sweep repeats the run for a range of --upload-every values. Defaults
+ * mirror the firmware's DUTY_* settings; replace the currents with values
+ * measured on your board.
+ */
+#include <DutyCycle.h>
+#include <MlBatch.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <random>
+
+struct SimParams {
+  double periodS = 60;
+  int uploadEvery = 10;
+  double hours = 24;
+  double bootMs = 180;        // ROM boot + bootloader + app start
+  double senseMs = 130;       // Sensor begin() + one read of each
+  double radioMs = 2500;      // Wi-Fi connect + NTP + sign-in + upload
+  double radioJitterMs = 800;
+  double radioFail = 0.05;    // Probability an upload wake fails
+  double batteryMah = 2000;
+  DutyEnergyModel model = { 3.7f, 40.0f, 120.0f, 0.8f };
+};
+
+struct SimResult {
+  uint64_t wakes = 0;
+  uint64_t samples = 0;
+  uint64_t uploadWakes = 0;
+  uint64_t failures = 0;
+  uint64_t overwritten = 0;
+  uint64_t delivered = 0;
+  double energyMj = 0;
+  double simulatedS = 0;
+  double freshnessSumS = 0;   // Sample taken -> stored in the database
+  double freshnessMaxS = 0;
+  double chunkBytes = 0;
+  DutyTiming awake = {};
+};
+
+static SimResult simulate(const SimParams &p, uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::normal_distribution<double> jitter(0.0, 1.0);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+  DutyCycleConfig config = { (uint32_t)(p.periodS * 1000), (uint16_t)p.uploadEvery, 1000 };
+  static DutyCycleState state;   // Large; as in RTC memory, one per device
+  dutyCycleReset(state);
+  static MlBatch batch;
+  static char chunk[16384];
+
+  SimResult r;
+  double nowMs = 0;
+  const double endMs = p.hours * 3600e3;
+
+  while (nowMs < endMs) {
+    state.wakeCount++;
+    r.wakes++;
+
+    double awakeMs = std::max(20.0, p.bootMs + p.senseMs + 10.0 * jitter(rng));
+    double sampleMs = nowMs + awakeMs;
+
+    SensorSample sample = {};
+    sample.humidity = 60.0f + (float)jitter(rng);
+    sample.temperature = 29.0f + 0.1f * (float)jitter(rng);
+    sample.ambient = 28.5f;
+    sample.object = 33.0f + 0.3f * (float)jitter(rng);
+    sample.accelZ = 9.81f;
+    sample.temperatureMPU = 31.0f;
+    uint32_t overwrittenBefore = state.stats.overwritten;
+    dutyCyclePush(state, sample, SENSOR_BIT_AHT10 | SENSOR_BIT_MLX90614 | SENSOR_BIT_MPU6050, (int64_t)sampleMs);
+    r.overwritten += state.stats.overwritten - overwrittenBefore;
+    r.samples++;
+
+    double radioMs = 0;
+    if (dutyCycleUploadDue(state, config)) {
+      r.uploadWakes++;
+      radioMs = std::max(300.0, p.radioMs + p.radioJitterMs * jitter(rng));
+      if (uniform(rng) < p.radioFail) {
+        r.failures++;
+      } else {
+        double storedMs = sampleMs + radioMs;
+        while (state.count > 0) {
+          uint8_t rows = std::min<int>(state.count, ML_BATCH_CAPACITY);
+          batch.clear();
+          for (uint8_t i = 0; i < rows; i++) {
+            MlBatchRow* row = batch.nextRow();
+            int64_t timeMs;
+            dutyCycleSample(state, i, row->sample, timeMs);
+            row->timeMs = (double)timeMs;
+            row->actionsOn = 0;
+            batch.push();
+            double ageS = (storedMs - timeMs) / 1000.0;
+            r.freshnessSumS += ageS;
+            r.freshnessMaxS = std::max(r.freshnessMaxS, ageS);
+          }
+          r.chunkBytes += batch.encode(chunk, sizeof(chunk), SENSOR_BIT_AHT10 | SENSOR_BIT_MLX90614 | SENSOR_BIT_MPU6050, false);
+          r.delivered += rows;
+          dutyCycleConsume(state, rows);
+        }
+      }
+    } else {
+      r.awake.add((float)awakeMs);
+    }
+
+    double totalAwakeMs = awakeMs + radioMs;
+    double sleepMs = dutyCycleSleepUs(config, (uint64_t)(totalAwakeMs * 1000)) / 1000.0;
+    r.energyMj += dutyCycleEnergyMj(p.model, (float)awakeMs, (float)radioMs, (float)sleepMs);
+    nowMs += totalAwakeMs + sleepMs;
+  }
+  r.simulatedS = nowMs / 1000.0;
+  return r;
+}
+
+static void printHeader() {
+  printf("%7s %9s %10s %9s %9s %10s %10s %8s %7s\n", "upload", "mJ/smpl", "avg mA", "life d",
+         "fresh s", "fresh max", "B/sample", "lost", "fails");
+}
+
+static void printRow(const SimParams &p, const SimResult &r) {
+  double avgMa = r.energyMj / (p.model.supplyV * r.simulatedS);
+  printf("%7d %9.1f %10.3f %9.1f %9.0f %10.0f %10.1f %8llu %7llu\n", p.uploadEvery,
+         r.energyMj / r.samples, avgMa, p.batteryMah / avgMa / 24.0,
+         r.delivered ? r.freshnessSumS / r.delivered : 0.0, r.freshnessMaxS,
+         r.delivered ? r.chunkBytes / r.delivered : 0.0,
+         (unsigned long long)r.overwritten, (unsigned long long)r.failures);
+}
+
+int main(int argc, char** argv) {
+  SimParams p;
+  bool sweep = false;
+
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (!strcmp(arg, "--sweep")) {
+      sweep = true;
+    } else if (hasValue && !strcmp(arg, "--period-s")) {
+      p.periodS = atof(argv[++i]);
+    } else if (hasValue && !strcmp(arg, "--upload-every")) {
+      p.uploadEvery = atoi(argv[++i]);
+    } else if (hasValue && !strcmp(arg, "--hours")) {
+      p.hours = atof(argv[++i]);
+    } else if (hasValue && !strcmp(arg, "--boot-ms")) {
+      p.bootMs = atof(argv[++i]);
+    } else if (hasValue && !strcmp(arg, "--sense-ms")) {
+      p.senseMs = atof(argv[++i]);
+    } else if (hasValue && !strcmp(arg, "--radio-ms")) {
+      p.radioMs = atof(argv[++i]);
+    } else if (hasValue && !strcmp(arg, "--radio-jitter-ms")) {
+      p.radioJitterMs = atof(argv[++i]);
+    } else if (hasValue && !strcmp(arg, "--radio-fail")) {
+      p.radioFail = atof(argv[++i]);
+    } else if (hasValue && !strcmp(arg, "--battery-mah")) {
+      p.batteryMah = atof(argv[++i]);
+    } else if (hasValue && !strcmp(arg, "--supply-v")) {
+      p.model.supplyV = (float)atof(argv[++i]);
+    } else if (hasValue && !strcmp(arg, "--active-ma")) {
+      p.model.activeMa = (float)atof(argv[++i]);
+    } else if (hasValue && !strcmp(arg, "--radio-ma")) {
+      p.model.radioMa = (float)atof(argv[++i]);
+    } else if (hasValue && !strcmp(arg, "--sleep-ma")) {
+      p.model.sleepMa = (float)atof(argv[++i]);
+    } else {
+      fprintf(stderr, "unknown or incomplete option: %s (see the header of %s)\n", arg, __FILE__);
+      return 2;
+    }
+  }
+  if (p.uploadEvery < 1 || p.periodS <= 0 || p.hours <= 0) {
+    fprintf(stderr, "--upload-every, --period-s and --hours must be positive\n");
+    return 2;
+  }
+
+  printf("Period %.0f s over %.0f h, RTC buffer %d samples, %.1f V / %.0f mA active / %.0f mA radio / %.2f mA sleep\n",
+         p.periodS, p.hours, DUTY_CYCLE_CAPACITY, p.model.supplyV, p.model.activeMa, p.model.radioMa, p.model.sleepMa);
+
+  // Always-on reference: Wi-Fi associated and both cores running the whole period
+  double alwaysOnMj = p.model.supplyV * p.model.radioMa * p.periodS;
+  printf("Always-on reference: %.0f mJ/sample, %.1f mA, %.1f days on %.0f mAh\n\n",
+         alwaysOnMj, (double)p.model.radioMa, p.batteryMah / p.model.radioMa / 24.0, p.batteryMah);
+
+  printHeader();
+  if (sweep) {
+    const int everyValues[] = { 1, 2, 5, 10, 20, 30, DUTY_CYCLE_CAPACITY, DUTY_CYCLE_CAPACITY + 12 };
+    for (int every : everyValues) {
+      p.uploadEvery = every;
+      printRow(p, simulate(p, 42));
+    }
+  } else {
+    SimResult r = simulate(p, 42);
+    printRow(p, r);
+    printf("\n%llu wakes, %llu upload wakes, sampling-only wake %.0f ms mean / %.0f ms max\n",
+           (unsigned long long)r.wakes, (unsigned long long)r.uploadWakes, r.awake.mean(), r.awake.maxMs);
+  }
+  return 0;
+}
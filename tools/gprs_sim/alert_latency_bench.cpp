@@ -0,0 +1,260 @@
+/**
+ * SMS alert latency benchmark against scripted modem behaviours.
+ *
+ * For each --profile (a tools/gprs_sim/modem_sim script), starts a
+ * modem_sim on a fresh pty and runs the sender task's alert path on the
+ * host. The firmware's Sim800 driver and UplinkScheduler are used as-is:
+ * alerts enter the ALERT class, a failed SMS is re-queued up to --retries
+ * times (SMS_ALERT_RETRIES), and live jobs compete for the same task every
+ * --live-period-ms with --live-work-ms of simulated Firebase time.
+ *
+ * Reported per profile:
+ *   init     Sim800::begin() time (sim800a_init without its 3 s boot delay)
+ *   alert    enqueue -> +CMGS confirmed, including retries: p50 / p95 / max
+ *   lost     alerts that failed every attempt
+ *   blocked  time the uplink task spent inside sendSms(): mean / max
+ *   live     live updates run out of those due (the rest were merged or went
+ *            stale behind alerts), and their queue wait p95 / max counted from
+ *            when the update was first queued
+ *
+ * Build from the project root:
+ *   g++ -O2 -std=c++17 -Ilib/Sim800 -Ilib/UplinkScheduler -Ilib/WindowStats -Itools/common \
+ *       tools/gprs_sim/alert_latency_bench.cpp lib/Sim800/Sim800.cpp \
+ *       lib/UplinkScheduler/UplinkScheduler.cpp -o alert_latency_bench
+ *
+ * Usage:
+ *   alert_latency_bench [--modem-sim ./modem_sim] [--profile tools/gprs_sim/profiles/slow_network.txt]...
+ *                       [--alerts 10] [--gap-ms 800] [--live-period-ms 500] [--live-work-ms 40]
+ *                       [--retries 2]
+ *
+ * Without --profile a single run with an ideal modem (no rules) is made.
+ * Alerts arrive every --gap-ms +-50% and cycle through the five actions.
+ */
+#include <PosixModemPort.h>
+#include <Sim800.h>
+#include <UplinkScheduler.h>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#define ACTION_COUNT 5
+
+enum BenchJob { BENCH_LIVE, BENCH_SMS_ALERT };
+
+struct BenchOptions {
+  const char* modemSim = "./modem_sim";
+  std::vector<const char*> profiles;
+  int alerts = 10;
+  uint32_t gapMs = 800;
+  uint32_t livePeriodMs = 500;
+  uint32_t liveWorkMs = 40;
+  int retries = 2;
+};
+
+struct BenchResult {
+  double initMs = 0;
+  int sent = 0;
+  int lost = 0;
+  int attempts = 0;
+  std::vector<double> alertMs;
+  std::vector<double> blockedMs;
+  std::vector<double> liveWaitMs;
+  uint32_t liveDue = 0;
+  uint32_t liveRun = 0;
+};
+
+static double percentile(std::vector<double> values, double p) {
+  if (values.empty()) return 0.0;
+  std::sort(values.begin(), values.end());
+  return values[(size_t)(p * (values.size() - 1))];
+}
+
+static double mean(const std::vector<double> &values) {
+  double sum = 0;
+  for (double v : values) sum += v;
+  return values.empty() ? 0.0 : sum / values.size();
+}
+
+/**
+ * @brief Start modem_sim on a pty linked at linkPath
+ */
+static pid_t startModemSim(const char* binary, const char* profile, const char* linkPath) {
+  unlink(linkPath);
+  pid_t pid = fork();
+  if (pid == 0) {
+    int devNull = open("/dev/null", O_WRONLY);
+    dup2(devNull, STDOUT_FILENO);
+    dup2(devNull, STDERR_FILENO);
+    if (profile) {
+      execl(binary, binary, "--link", linkPath, "--script", profile, (char*)NULL);
+    } else {
+      execl(binary, binary, "--link", linkPath, (char*)NULL);
+    }
+    _exit(127);
+  }
+  struct stat st;
+  for (int i = 0; i < 100 && lstat(linkPath, &st) != 0; i++) {
+    usleep(20000);
+  }
+  return pid;
+}
+
+static void stopModemSim(pid_t pid) {
+  kill(pid, SIGINT);
+  waitpid(pid, NULL, 0);
+}
+
+static bool runProfile(const BenchOptions &options, const char* profile, BenchResult &result) {
+  char linkPath[64];
+  snprintf(linkPath, sizeof(linkPath), "/tmp/alert_bench_%d", (int)getpid());
+  pid_t sim = startModemSim(options.modemSim, profile, linkPath);
+  if (sim < 0) {
+    return false;
+  }
+
+  PosixModemPort port;
+  if (!port.open(linkPath)) {
+    stopModemSim(sim);
+    return false;
+  }
+  Sim800 modem(port);
+  uint32_t start = port.millis();
+  if (!modem.begin()) {
+    fprintf(stderr, "modem did not answer: %s\n", modem.lastResponse());
+    stopModemSim(sim);
+    return false;
+  }
+  result.initMs = port.millis() - start;
+
+  UplinkScheduler scheduler;
+  std::mt19937 rng(7);
+  std::uniform_int_distribution<uint32_t> gap(options.gapMs / 2, options.gapMs * 3 / 2);
+
+  uint32_t firstQueuedMs[ACTION_COUNT + 1] = {};
+  bool pending[ACTION_COUNT + 1] = {};
+  int injected = 0;
+  int resolved = 0;
+  uint32_t now = port.millis();
+  uint32_t nextLive = now;
+  uint32_t nextAlert = now + gap(rng);
+
+  while (resolved < injected || injected < options.alerts) {
+    now = port.millis();
+
+    if ((int32_t)(now - nextLive) >= 0) {
+      nextLive = now + options.livePeriodMs;
+      result.liveDue++;
+      scheduler.enqueue(BENCH_LIVE, UPLINK_LIVE, 0, now, now + options.livePeriodMs);
+    }
+    if (injected < options.alerts && (int32_t)(now - nextAlert) >= 0) {
+      nextAlert = now + gap(rng);
+      int action = injected % ACTION_COUNT + 1;
+      injected++;
+      if (pending[action]) {
+        resolved++;   // Merged into the alert already queued for this action
+      } else {
+        pending[action] = true;
+        firstQueuedMs[action] = now;
+        scheduler.enqueue(BENCH_SMS_ALERT, UPLINK_ALERT, action, now, now + 30000);
+      }
+    }
+
+    UplinkJob job;
+    if (!scheduler.next(now, job)) {
+      port.idle();
+      continue;
+    }
+
+    uint32_t jobStart = port.millis();
+    if (job.kind == BENCH_LIVE) {
+      result.liveWaitMs.push_back(jobStart - job.enqueuedMs);
+      usleep(options.liveWorkMs * 1000);
+    } else {
+      int action = job.param;
+      int attempt = job.attempt;
+      char message[40];
+      snprintf(message, sizeof(message), "Alert: Action %d Triggered!", action);
+      result.attempts++;
+      bool sent = modem.sendSms("+15550100", message);
+      uint32_t end = port.millis();
+      result.blockedMs.push_back(end - jobStart);
+      if (sent) {
+        result.sent++;
+        result.alertMs.push_back(end - firstQueuedMs[action]);
+      } else if (attempt < options.retries) {
+        scheduler.enqueue(BENCH_SMS_ALERT, UPLINK_ALERT, action, end, end + 30000, attempt + 1);
+      } else {
+        result.lost++;
+      }
+      if (sent || attempt >= options.retries) {
+        pending[action] = false;
+        resolved++;
+      }
+    }
+    scheduler.complete(job, jobStart, port.millis());
+  }
+
+  result.liveRun = scheduler.metrics(UPLINK_LIVE).executed;
+  port.close();
+  stopModemSim(sim);
+  return true;
+}
+
+int main(int argc, char** argv) {
+  BenchOptions options;
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    const char* value = i + 1 < argc ? argv[++i] : NULL;
+    if (!value) {
+      fprintf(stderr, "missing value for %s\n", arg);
+      return 2;
+    }
+    if (!strcmp(arg, "--modem-sim")) options.modemSim = value;
+    else if (!strcmp(arg, "--profile")) options.profiles.push_back(value);
+    else if (!strcmp(arg, "--alerts")) options.alerts = atoi(value);
+    else if (!strcmp(arg, "--gap-ms")) options.gapMs = atoi(value);
+    else if (!strcmp(arg, "--live-period-ms")) options.livePeriodMs = atoi(value);
+    else if (!strcmp(arg, "--live-work-ms")) options.liveWorkMs = atoi(value);
+    else if (!strcmp(arg, "--retries")) options.retries = atoi(value);
+    else {
+      fprintf(stderr, "unknown option %s\n", arg);
+      return 2;
+    }
+  }
+  if (options.profiles.empty()) {
+    options.profiles.push_back(NULL);
+  }
+
+  printf("%-20s %7s %5s %5s %6s %7s %7s %7s %9s %8s %6s %6s %9s %9s\n",
+         "profile", "init ms", "sent", "lost", "tries", "p50 ms", "p95 ms", "max ms",
+         "blk mean", "blk max", "live", "due", "wait p95", "wait max");
+  int failures = 0;
+  for (const char* profile : options.profiles) {
+    BenchResult result;
+    const char* name = profile ? strrchr(profile, '/') ? strrchr(profile, '/') + 1 : profile : "(ideal)";
+    if (!runProfile(options, profile, result)) {
+      printf("%-20s failed to start\n", name);
+      failures++;
+      continue;
+    }
+    printf("%-20s %7.0f %5d %5d %6d %7.0f %7.0f %7.0f %9.0f %8.0f %6u %6u %9.0f %9.0f\n",
+           name, result.initMs, result.sent, result.lost, result.attempts,
+           percentile(result.alertMs, 0.50), percentile(result.alertMs, 0.95), percentile(result.alertMs, 1.0),
+           mean(result.blockedMs), percentile(result.blockedMs, 1.0),
+           result.liveRun, result.liveDue,
+           percentile(result.liveWaitMs, 0.95), percentile(result.liveWaitMs, 1.0));
+    fflush(stdout);
+  }
+  return failures == 0 ? 0 : 1;
+}
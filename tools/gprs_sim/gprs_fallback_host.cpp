@@ -0,0 +1,261 @@
+/**
+ * Host run of the GPRS fallback uplink (ENABLE_GPRS_FALLBACK).
+ *
+ * Drives the firmware's Sim800 driver, LinkSelector and GprsBatch through
+ * a scripted Wi-Fi outage, the way TaskFirebaseSender does: while Wi-Fi is
+ * up samples count as going to Firebase; once it has been down for
+ * --failover-ms they are buffered and sent as GprsBatch frames every
+ * --batch-ms; once Wi-Fi has been back for --recover-ms the buffer is
+ * flushed and the bearer released. The modem is tools/gprs_sim/modem_sim
+ * and the frames land in tools/gprs_sim/tcp_sink.
+ *
+ * Build from the project root:
+ *   g++ -O2 -std=c++17 -Ilib/Sim800 -Ilib/GprsUplink -Ilib/DutyCycle -Ilib/Telemetry -Ilib/WindowStats \
+ *       -Itools/common tools/gprs_sim/gprs_fallback_host.cpp lib/Sim800/Sim800.cpp \
+ *       lib/GprsUplink/GprsBatch.cpp lib/GprsUplink/LinkSelector.cpp lib/DutyCycle/DutyCycle.cpp \
+ *       -o gprs_fallback_host
+ *
+ * Run (three terminals, or background the first two):
+ *   tcp_sink --port 9000 --out samples.jsonl
+ *   modem_sim --link /tmp/sim800
+ *   gprs_fallback_host --modem /tmp/sim800 [--host 127.0.0.1] [--port 9000]
+ *                      [--timeline up:2,down:12,up:4] [--sample-ms 250] [--batch-ms 3000]
+ *                      [--failover-ms 1000] [--recover-ms 1000] [--sms +15550100]
+ *
+ * --timeline lists Wi-Fi states with their durations in seconds. Times are
+ * scaled down from the firmware defaults so a run takes seconds. The exit
+ * status is non-zero if any buffered sample was neither sent, overwritten
+ * nor still held in the batch (as it is after a run with modem_sim --no-gprs).
+ */
+#include <GprsBatch.h>
+#include <LinkSelector.h>
+#include <PosixModemPort.h>
+#include <Sim800.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <string>
+#include <vector>
+
+struct HostOptions {
+  const char* modem = NULL;
+  const char* host = "127.0.0.1";
+  uint16_t port = 9000;
+  const char* timeline = "up:2,down:12,up:4";
+  uint32_t sampleMs = 250;
+  uint32_t batchMs = 3000;
+  uint32_t failoverMs = 1000;
+  uint32_t recoverMs = 1000;
+  const char* sms = NULL;
+};
+
+struct Phase {
+  bool wifiUp;
+  uint32_t untilMs;   // End of the phase, from the start of the run
+};
+
+struct HostStats {
+  unsigned samplesWifi = 0;
+  unsigned samplesBuffered = 0;
+  unsigned samplesSent = 0;
+  unsigned frames = 0;
+  unsigned sendFailures = 0;
+  unsigned long frameBytes = 0;
+};
+
+static bool parseTimeline(const char* text, std::vector<Phase> &phases) {
+  uint32_t endMs = 0;
+  std::string spec(text);
+  size_t pos = 0;
+  while (pos < spec.size()) {
+    size_t comma = spec.find(',', pos);
+    std::string item = spec.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+    size_t colon = item.find(':');
+    if (colon == std::string::npos) {
+      return false;
+    }
+    std::string state = item.substr(0, colon);
+    if (state != "up" && state != "down") {
+      return false;
+    }
+    endMs += (uint32_t)(atof(item.c_str() + colon + 1) * 1000);
+    phases.push_back({ state == "up", endMs });
+    pos = comma == std::string::npos ? spec.size() : comma + 1;
+  }
+  return !phases.empty();
+}
+
+/**
+ * @brief Same re-anchoring period check as the sender task
+ */
+static bool periodElapsed(uint32_t &nextMs, uint32_t periodMs, uint32_t nowMs) {
+  if ((int32_t)(nowMs - nextMs) < 0) {
+    return false;
+  }
+  nextMs += periodMs;
+  if ((int32_t)(nowMs - nextMs) >= 0) {
+    nextMs = nowMs + periodMs;
+  }
+  return true;
+}
+
+static int64_t epochMs() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+static SensorSample syntheticSample(unsigned index) {
+  SensorSample s = {};
+  s.humidity = 55.0f + 5.0f * sinf(index * 0.1f);
+  s.temperature = 28.0f + 0.5f * sinf(index * 0.05f);
+  s.ambient = 29.5f;
+  s.object = 31.0f + 0.2f * cosf(index * 0.07f);
+  s.accelX = 0.12f;
+  s.accelY = -0.05f;
+  s.accelZ = 9.81f;
+  s.gyroX = 0.01f;
+  s.gyroY = -0.02f;
+  s.gyroZ = 0.003f;
+  s.temperatureMPU = 33.2f;
+  s.tvoc = (uint16_t)(40 + index % 10);
+  s.eco2 = 420;
+  s.epochUs = epochMs() * 1000;
+  return s;
+}
+
+static void sendBatch(Sim800 &modem, GprsBatch &batch, const HostOptions &options, HostStats &stats) {
+  static uint8_t frame[GPRS_BATCH_MAX_BYTES];
+  if (batch.size() == 0) {
+    return;
+  }
+  if (!modem.gprsAttach("internet")) {
+    fprintf(stderr, "[host] GPRS attach failed: %s\n", modem.lastResponse());
+    stats.sendFailures++;
+    return;
+  }
+  size_t length = batch.encode("host-sim", frame, sizeof(frame));
+  if (modem.tcpSend(options.host, options.port, frame, length)) {
+    fprintf(stderr, "[host] batch sent: %u samples in %zu bytes\n", batch.size(), length);
+    stats.samplesSent += batch.size();
+    stats.frames++;
+    stats.frameBytes += length;
+    batch.clear();
+  } else {
+    fprintf(stderr, "[host] batch send failed, %u samples kept: %s\n", batch.size(), modem.lastResponse());
+    stats.sendFailures++;
+  }
+}
+
+int main(int argc, char** argv) {
+  HostOptions options;
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+    if (!value) {
+      options.modem = NULL;
+      break;
+    }
+    if (!strcmp(arg, "--modem")) options.modem = value;
+    else if (!strcmp(arg, "--host")) options.host = value;
+    else if (!strcmp(arg, "--port")) options.port = (uint16_t)atoi(value);
+    else if (!strcmp(arg, "--timeline")) options.timeline = value;
+    else if (!strcmp(arg, "--sample-ms")) options.sampleMs = atoi(value);
+    else if (!strcmp(arg, "--batch-ms")) options.batchMs = atoi(value);
+    else if (!strcmp(arg, "--failover-ms")) options.failoverMs = atoi(value);
+    else if (!strcmp(arg, "--recover-ms")) options.recoverMs = atoi(value);
+    else if (!strcmp(arg, "--sms")) options.sms = value;
+    else {
+      options.modem = NULL;
+      break;
+    }
+    i++;
+  }
+
+  std::vector<Phase> phases;
+  if (!options.modem || !parseTimeline(options.timeline, phases)) {
+    fprintf(stderr, "usage: %s --modem PATH [--host H] [--port P] [--timeline up:S,down:S,...]\n"
+                    "          [--sample-ms MS] [--batch-ms MS] [--failover-ms MS] [--recover-ms MS] [--sms NUMBER]\n",
+            argv[0]);
+    return 2;
+  }
+
+  PosixModemPort port;
+  if (!port.open(options.modem)) {
+    return 1;
+  }
+  Sim800 modem(port);
+  if (!modem.begin()) {
+    fprintf(stderr, "[host] modem not responding: %s\n", modem.lastResponse());
+    return 1;
+  }
+  if (options.sms && !modem.sendSms(options.sms, "Alert: Action 1 Triggered!")) {
+    fprintf(stderr, "[host] SMS failed: %s\n", modem.lastResponse());
+  }
+
+  LinkSelector selector(options.failoverMs, options.recoverMs);
+  GprsBatch batch;
+  HostStats stats;
+
+  uint32_t startMs = port.millis();
+  uint32_t nextSample = startMs;
+  uint32_t nextBatch = startMs + options.batchMs;
+  size_t phase = 0;
+  unsigned sampleIndex = 0;
+
+  for (;;) {
+    uint32_t now = port.millis();
+    uint32_t elapsed = now - startMs;
+    while (phase < phases.size() && elapsed >= phases[phase].untilMs) {
+      phase++;
+    }
+    if (phase == phases.size()) {
+      break;
+    }
+
+    if (selector.update(phases[phase].wifiUp, now)) {
+      fprintf(stderr, "[host] %6.2f s: uplink -> %s\n", elapsed / 1000.0, UPLINK_LINK_NAMES[selector.active()]);
+      if (selector.active() == LINK_WIFI) {
+        sendBatch(modem, batch, options, stats);
+        modem.gprsDetach();
+      }
+    }
+    bool onGprs = selector.active() == LINK_GPRS;
+
+    if (periodElapsed(nextSample, options.sampleMs, now)) {
+      if (onGprs) {
+        uint8_t mask = SENSOR_BIT_AHT10 | SENSOR_BIT_MLX90614 | SENSOR_BIT_MPU6050 | SENSOR_BIT_SGP30;
+        batch.push(syntheticSample(sampleIndex), mask, epochMs());
+        stats.samplesBuffered++;
+      } else {
+        stats.samplesWifi++;
+      }
+      sampleIndex++;
+    }
+    if (onGprs && periodElapsed(nextBatch, options.batchMs, now)) {
+      sendBatch(modem, batch, options, stats);
+    }
+
+    port.idle();
+  }
+
+  // Whatever is still buffered at the end of the timeline goes out now
+  if (batch.size() > 0) {
+    sendBatch(modem, batch, options, stats);
+  }
+  if (modem.gprsUp()) {
+    modem.gprsDetach();
+  }
+
+  unsigned lost = stats.samplesBuffered - stats.samplesSent - batch.dropped() - batch.size();
+  printf("samples: %u over Wi-Fi, %u buffered for GPRS, %u sent, %u overwritten, %u still buffered, %u unaccounted\n",
+         stats.samplesWifi, stats.samplesBuffered, stats.samplesSent, batch.dropped(), batch.size(), lost);
+  printf("frames: %u sent (%u failures), %.1f bytes/sample; link switches: %u\n",
+         stats.frames, stats.sendFailures,
+         stats.samplesSent ? (double)stats.frameBytes / stats.samplesSent : 0.0, selector.switches());
+  return lost == 0 ? 0 : 1;
+}
@@ -0,0 +1,670 @@
+/**
+ * SIM800 modem simulator on a Linux pseudo-terminal.
+ *
+ * Opens a pty pair and answers the AT command subset the firmware's Sim800
+ * driver uses, so the driver (and anything built on it) can run on a host
+ * through tools/common/PosixModemPort:
+ *
+ *   AT, ATE0/ATE1, AT+CMGF, AT+CMGS (SMS text is logged, not sent)
+ *   AT+CIPSHUT, AT+CGATT?, AT+CIPMUX, AT+CSTT, AT+CIICR, AT+CIFSR
+ *   AT+CIPSTART="TCP",host,port   opens a real TCP connection
+ *   AT+CIPSEND=n                  forwards the next n bytes to it
+ *   AT+CIPCLOSE
+ *
+ * Bytes the server sends back are written to the pty as the SIM800 does in
+ * non-transparent mode, and a remote close produces the CLOSED URC.
+ *
+ * Misbehaviour is scripted with rules, one per line of a --script file (see
+ * tools/gprs_sim/profiles) or per --rule argument; '#' starts a comment:
+ *
+ *   delay <reply-prefix> <ms> [jitter-ms]   hold replies starting with the prefix
+ *                                           ("> " is the prompt, "*" matches any)
+ *   sms-fail <probability>                  answer Ctrl-Z with +CMS ERROR: 500
+ *   sms-timeout <probability>               swallow the SMS without any reply
+ *   close-fail <probability>                answer AT+CIPCLOSE with ERROR and leave the
+ *                                           connection open, so the next AT+CIPSTART gets
+ *                                           ERROR + ALREADY CONNECT (a leftover socket)
+ *   urc <period-ms> <text>                  unsolicited line, e.g. RING or +CMTI: "SM",1
+ *   garbage <probability> <max-bytes>       random line noise before a reply or URC
+ *   seed <n>                                random seed (default 1)
+ *
+ * Delayed replies keep their order; URCs and noise can land in the middle of
+ * a pending exchange, as they do on the real UART.
+ *
+ * Build from the project root:
+ *   g++ -O2 -std=c++17 tools/gprs_sim/modem_sim.cpp -o modem_sim
+ *
+ * Usage:
+ *   modem_sim [--link /tmp/sim800] [--no-gprs] [--script profile.txt] [--rule "delay +CMGS: 3000"]...
+ *             [--verbose]
+ *
+ * The slave path is printed on startup; --link also symlinks it to a fixed
+ * name. --no-gprs reports the SIM as not attached (AT+CGATT: 0), as with no
+ * coverage or no data plan. Ctrl-C prints a summary.
+ */
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <time.h>
+
+#include <deque>
+#include <random>
+#include <string>
+#include <vector>
+
+struct DelayRule {
+  std::string prefix;
+  uint32_t ms;
+  uint32_t jitterMs;
+};
+
+struct UrcRule {
+  uint32_t periodMs;
+  std::string text;
+  uint64_t nextMs;
+};
+
+struct SimOptions {
+  const char* link = NULL;
+  bool gprs = true;
+  bool verbose = false;
+  std::vector<DelayRule> delays;
+  std::vector<UrcRule> urcs;
+  double smsFail = 0.0;
+  double smsTimeout = 0.0;
+  double closeFail = 0.0;
+  double garbage = 0.0;
+  uint32_t garbageMaxBytes = 8;
+  uint32_t seed = 1;
+};
+
+struct SimStats {
+  unsigned commands = 0;
+  unsigned errors = 0;
+  unsigned sms = 0;
+  unsigned smsFailed = 0;
+  unsigned smsDropped = 0;
+  unsigned connects = 0;
+  unsigned connectFailures = 0;
+  unsigned alreadyConnected = 0;
+  unsigned closeFailures = 0;
+  unsigned urcs = 0;
+  unsigned long garbageBytes = 0;
+  unsigned long bytesSent = 0;
+};
+
+static uint64_t nowMs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000ULL + ts.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Parse one script rule into options
+ */
+static bool parseRule(const std::string &rule, SimOptions &options) {
+  char keyword[32];
+  char rest[256] = "";
+  if (sscanf(rule.c_str(), " %31s %255[^\n]", keyword, rest) < 1 || keyword[0] == '#') {
+    return true;   // Blank line or comment
+  }
+
+  if (!strcmp(keyword, "delay")) {
+    // The prefix may itself contain a space ("> "), so the numbers are taken from the end
+    std::string args(rest);
+    size_t end = args.find('#');
+    args = args.substr(0, end);
+    while (!args.empty() && isspace((unsigned char)args.back())) args.pop_back();
+    std::vector<uint32_t> numbers;
+    while (numbers.size() < 2) {
+      size_t space = args.find_last_of(' ');
+      if (space == std::string::npos || !isdigit((unsigned char)args[space + 1])) {
+        break;
+      }
+      numbers.insert(numbers.begin(), (uint32_t)strtoul(args.c_str() + space + 1, NULL, 10));
+      args.resize(space);
+    }
+    if (numbers.empty() || args.empty()) {
+      return false;
+    }
+    if (args == ">") {
+      args = "> ";
+    }
+    options.delays.push_back({ args, numbers[0], numbers.size() > 1 ? numbers[1] : 0 });
+  } else if (!strcmp(keyword, "sms-fail")) {
+    options.smsFail = atof(rest);
+  } else if (!strcmp(keyword, "sms-timeout")) {
+    options.smsTimeout = atof(rest);
+  } else if (!strcmp(keyword, "close-fail")) {
+    options.closeFail = atof(rest);
+  } else if (!strcmp(keyword, "urc")) {
+    char* text;
+    uint32_t period = strtoul(rest, &text, 10);
+    while (*text == ' ') text++;
+    if (period == 0 || !*text) {
+      return false;
+    }
+    options.urcs.push_back({ period, text, 0 });
+  } else if (!strcmp(keyword, "garbage")) {
+    if (sscanf(rest, "%lf %u", &options.garbage, &options.garbageMaxBytes) < 1) {
+      return false;
+    }
+  } else if (!strcmp(keyword, "seed")) {
+    options.seed = strtoul(rest, NULL, 10);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+static bool loadScript(const char* path, SimOptions &options) {
+  FILE* f = fopen(path, "r");
+  if (!f) {
+    perror(path);
+    return false;
+  }
+  char line[300];
+  int number = 0;
+  bool ok = true;
+  while (fgets(line, sizeof(line), f)) {
+    number++;
+    if (!parseRule(line, options)) {
+      fprintf(stderr, "%s:%d: bad rule: %s", path, number, line);
+      ok = false;
+    }
+  }
+  fclose(f);
+  return ok;
+}
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void onSignal(int) {
+  stopRequested = 1;
+}
+
+class ModemSim {
+public:
+  ModemSim(int fd, const SimOptions &options) : fd_(fd), options_(options), rng_(options.seed) {
+    for (UrcRule &urc : options_.urcs) {
+      urc.nextMs = nowMs() + urc.periodMs;
+    }
+  }
+  ~ModemSim() { closeSocket(); }
+
+  int socketFd() const { return socket_; }
+  const SimStats &stats() const { return stats_; }
+
+  /**
+   * @brief One byte from the DTE (the firmware side)
+   */
+  void onByte(uint8_t c) {
+    bool afterCr = lastWasCr_;
+    lastWasCr_ = c == '\r';
+    if (c == '\n' && afterCr && mode_ != MODE_COMMAND && payload_.empty()) {
+      return;   // LF of the CR LF that ended AT+CMGS / AT+CIPSEND, not part of the payload
+    }
+    switch (mode_) {
+      case MODE_COMMAND:
+        if (echo_) {
+          emit(&c, 1);
+        }
+        if (c == '\r' || c == '\n') {
+          if (!line_.empty()) {
+            std::string line = line_;
+            line_.clear();
+            handleLine(line);
+          }
+        } else if (line_.size() < 512) {
+          line_ += (char)c;
+        }
+        break;
+
+      case MODE_SMS_TEXT:
+        if (c == 0x1A) {          // Ctrl-Z: send
+          mode_ = MODE_COMMAND;
+          if (chance(options_.smsTimeout)) {
+            stats_.smsDropped++;
+            log("SMS to %s swallowed (sms-timeout)", smsNumber_.c_str());
+          } else if (chance(options_.smsFail)) {
+            stats_.smsFailed++;
+            log("SMS to %s failed (sms-fail)", smsNumber_.c_str());
+            respond("+CMS ERROR: 500");
+          } else {
+            stats_.sms++;
+            log("SMS to %s: \"%s\"", smsNumber_.c_str(), payload_.c_str());
+            char reply[32];
+            snprintf(reply, sizeof(reply), "+CMGS: %u", stats_.sms);
+            respond(reply);
+            respond("OK");
+          }
+        } else if (c == 0x1B) {   // ESC: cancel
+          mode_ = MODE_COMMAND;
+          respond("OK");
+        } else {
+          payload_ += (char)c;
+        }
+        break;
+
+      case MODE_TCP_DATA:
+        payload_ += (char)c;
+        if (payload_.size() == sendLength_) {
+          mode_ = MODE_COMMAND;
+          finishSend();
+        }
+        break;
+    }
+  }
+
+  /**
+   * @brief Data or a close from the TCP peer
+   */
+  void onSocketReadable() {
+    uint8_t buffer[512];
+    ssize_t n = recv(socket_, buffer, sizeof(buffer), 0);
+    if (n > 0) {
+      emit(buffer, n);
+    } else {
+      closeSocket();
+      respond("CLOSED");
+    }
+  }
+
+  /**
+   * @brief Write replies whose delay has passed and fire due URCs
+   * @return ms until the next scheduled output (capped at 200)
+   */
+  int service() {
+    uint64_t now = nowMs();
+    while (!pending_.empty() && pending_.front().dueMs <= now) {
+      emit(pending_.front().bytes.data(), pending_.front().bytes.size());
+      pending_.pop_front();
+    }
+    for (UrcRule &urc : options_.urcs) {
+      if (urc.nextMs <= now) {
+        urc.nextMs = now + urc.periodMs;
+        stats_.urcs++;
+        std::string bytes = noise() + "\r\n" + urc.text + "\r\n";
+        emit(bytes.data(), bytes.size());
+      }
+    }
+
+    uint64_t next = now + 200;
+    if (!pending_.empty() && pending_.front().dueMs < next) {
+      next = pending_.front().dueMs;
+    }
+    for (const UrcRule &urc : options_.urcs) {
+      if (urc.nextMs < next) {
+        next = urc.nextMs;
+      }
+    }
+    return (int)(next - now);
+  }
+
+private:
+  enum Mode { MODE_COMMAND, MODE_SMS_TEXT, MODE_TCP_DATA };
+
+  struct Pending {
+    uint64_t dueMs;
+    std::string bytes;
+  };
+
+  int fd_;
+  SimOptions options_;
+  SimStats stats_;
+  Mode mode_ = MODE_COMMAND;
+  bool echo_ = true;
+  bool bearerUp_ = false;
+  bool lastWasCr_ = false;
+  int socket_ = -1;
+  std::string line_;
+  std::string payload_;
+  std::string smsNumber_;
+  size_t sendLength_ = 0;
+  std::mt19937 rng_;
+  std::deque<Pending> pending_;
+  uint64_t lastDueMs_ = 0;
+
+  bool chance(double probability) {
+    return probability > 0 && std::uniform_real_distribution<double>(0.0, 1.0)(rng_) < probability;
+  }
+
+  /**
+   * @brief Random bytes to prepend to an output line, or "" (garbage rule)
+   */
+  std::string noise() {
+    std::string bytes;
+    if (chance(options_.garbage)) {
+      uint32_t count = 1 + rng_() % options_.garbageMaxBytes;
+      for (uint32_t i = 0; i < count; i++) {
+        bytes += (char)(rng_() & 0xFF);
+      }
+      stats_.garbageBytes += count;
+    }
+    return bytes;
+  }
+
+  /**
+   * @brief Queue output behind earlier replies, after the delay of the first matching rule
+   */
+  void schedule(const std::string &text, const std::string &bytes) {
+    uint32_t delayMs = 0;
+    for (const DelayRule &rule : options_.delays) {
+      if (rule.prefix == "*" || text.compare(0, rule.prefix.size(), rule.prefix) == 0) {
+        delayMs = rule.ms + (rule.jitterMs ? rng_() % (rule.jitterMs + 1) : 0);
+        break;
+      }
+    }
+    uint64_t due = nowMs() + delayMs;
+    if (due < lastDueMs_) {
+      due = lastDueMs_;
+    }
+    lastDueMs_ = due;
+    pending_.push_back({ due, noise() + bytes });
+  }
+
+  void prompt() {
+    schedule("> ", "\r\n> ");
+  }
+
+  void log(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+    va_list args;
+    va_start(args, format);
+    fprintf(stderr, "[modem] ");
+    vfprintf(stderr, format, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+  }
+
+  void emit(const void* data, size_t length) {
+    const uint8_t* p = (const uint8_t*)data;
+    while (length > 0) {
+      ssize_t n = write(fd_, p, length);
+      if (n > 0) {
+        p += n;
+        length -= n;
+      } else if (errno == EAGAIN) {
+        struct pollfd pfd = { fd_, POLLOUT, 0 };
+        poll(&pfd, 1, 100);
+      } else {
+        return;
+      }
+    }
+  }
+
+  /**
+   * @brief Write one result or URC line framed as the SIM800 does: \r\n<text>\r\n
+   */
+  void respond(const char* text) {
+    if (options_.verbose) {
+      log("<- %s", text);
+    }
+    schedule(text, std::string("\r\n") + text + "\r\n");
+  }
+
+  void error() {
+    stats_.errors++;
+    respond("ERROR");
+  }
+
+  static bool startsWith(const std::string &line, const char* prefix) {
+    return strncasecmp(line.c_str(), prefix, strlen(prefix)) == 0;
+  }
+
+  /**
+   * @brief The n-th double-quoted field of an argument list
+   */
+  static std::string quoted(const std::string &line, int index) {
+    size_t pos = 0;
+    for (int i = 0; i <= index; i++) {
+      size_t open = line.find('"', pos);
+      if (open == std::string::npos) {
+        return "";
+      }
+      size_t close = line.find('"', open + 1);
+      if (close == std::string::npos) {
+        return "";
+      }
+      if (i == index) {
+        return line.substr(open + 1, close - open - 1);
+      }
+      pos = close + 1;
+    }
+    return "";
+  }
+
+  void handleLine(const std::string &line) {
+    stats_.commands++;
+    if (options_.verbose) {
+      log("-> %s", line.c_str());
+    }
+
+    if (strcasecmp(line.c_str(), "AT") == 0 || startsWith(line, "AT+CMGF=") ||
+        startsWith(line, "AT+CIPMUX=0") || startsWith(line, "AT+CSCS=")) {
+      respond("OK");
+    } else if (startsWith(line, "ATE")) {
+      echo_ = line.size() > 3 && line[3] == '1';
+      respond("OK");
+    } else if (startsWith(line, "AT+CMGS=")) {
+      smsNumber_ = quoted(line, 0);
+      payload_.clear();
+      mode_ = MODE_SMS_TEXT;
+      prompt();
+    } else if (startsWith(line, "AT+CIPSHUT")) {
+      closeSocket();
+      bearerUp_ = false;
+      respond("SHUT OK");
+    } else if (startsWith(line, "AT+CGATT?")) {
+      respond(options_.gprs ? "+CGATT: 1" : "+CGATT: 0");
+      respond("OK");
+    } else if (startsWith(line, "AT+CSTT=")) {
+      options_.gprs ? respond("OK") : error();
+    } else if (startsWith(line, "AT+CIICR")) {
+      if (!options_.gprs) {
+        error();
+        return;
+      }
+      bearerUp_ = true;
+      respond("OK");
+    } else if (startsWith(line, "AT+CIFSR")) {
+      bearerUp_ ? respond("10.64.0.2") : error();
+    } else if (startsWith(line, "AT+CIPSTART=")) {
+      startConnection(line);
+    } else if (startsWith(line, "AT+CIPSEND=")) {
+      sendLength_ = strtoul(line.c_str() + 11, NULL, 10);
+      if (socket_ < 0 || sendLength_ == 0 || sendLength_ > 1460) {
+        error();
+        return;
+      }
+      payload_.clear();
+      mode_ = MODE_TCP_DATA;
+      prompt();
+    } else if (startsWith(line, "AT+CIPCLOSE")) {
+      if (socket_ < 0) {
+        error();
+        return;
+      }
+      if (chance(options_.closeFail)) {
+        stats_.closeFailures++;
+        log("AT+CIPCLOSE failed, connection left open (close-fail)");
+        error();
+        return;
+      }
+      closeSocket();
+      respond("CLOSE OK");
+    } else {
+      log("unsupported command: %s", line.c_str());
+      error();
+    }
+  }
+
+  void startConnection(const std::string &line) {
+    if (!bearerUp_) {
+      error();
+      return;
+    }
+    if (socket_ >= 0) {
+      stats_.alreadyConnected++;
+      error();
+      respond("ALREADY CONNECT");
+      return;
+    }
+    std::string host = quoted(line, 1);
+    size_t comma = line.rfind(',');
+    std::string port = comma == std::string::npos ? "" : line.substr(comma + 1);
+    if (!port.empty() && port[0] == '"') {
+      port = port.substr(1, port.size() - 2);
+    }
+    respond("OK");
+
+    struct addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* result = NULL;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &result) == 0) {
+      for (struct addrinfo* ai = result; ai && socket_ < 0; ai = ai->ai_next) {
+        int s = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (s >= 0 && connect(s, ai->ai_addr, ai->ai_addrlen) == 0) {
+          socket_ = s;
+        } else if (s >= 0) {
+          close(s);
+        }
+      }
+      freeaddrinfo(result);
+    }
+
+    if (socket_ >= 0) {
+      stats_.connects++;
+      log("TCP connected to %s:%s", host.c_str(), port.c_str());
+      respond("CONNECT OK");
+    } else {
+      stats_.connectFailures++;
+      log("TCP connect to %s:%s failed", host.c_str(), port.c_str());
+      respond("CONNECT FAIL");
+    }
+  }
+
+  void finishSend() {
+    size_t sent = 0;
+    while (socket_ >= 0 && sent < payload_.size()) {
+      ssize_t n = send(socket_, payload_.data() + sent, payload_.size() - sent, MSG_NOSIGNAL);
+      if (n <= 0) {
+        break;
+      }
+      sent += n;
+    }
+    if (sent == payload_.size()) {
+      stats_.bytesSent += sent;
+      respond("SEND OK");
+    } else {
+      respond("SEND FAIL");
+    }
+  }
+
+  void closeSocket() {
+    if (socket_ >= 0) {
+      close(socket_);
+      socket_ = -1;
+    }
+  }
+};
+
+int main(int argc, char** argv) {
+  SimOptions options;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--link") && i + 1 < argc) {
+      options.link = argv[++i];
+    } else if (!strcmp(argv[i], "--no-gprs")) {
+      options.gprs = false;
+    } else if (!strcmp(argv[i], "--verbose")) {
+      options.verbose = true;
+    } else if (!strcmp(argv[i], "--script") && i + 1 < argc) {
+      if (!loadScript(argv[++i], options)) {
+        return 2;
+      }
+    } else if (!strcmp(argv[i], "--rule") && i + 1 < argc) {
+      if (!parseRule(argv[++i], options)) {
+        fprintf(stderr, "bad rule: %s\n", argv[i]);
+        return 2;
+      }
+    } else {
+      fprintf(stderr, "usage: %s [--link PATH] [--no-gprs] [--script FILE] [--rule RULE]... [--verbose]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  int master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+    perror("posix_openpt");
+    return 1;
+  }
+  const char* slavePath = ptsname(master);
+
+  // Hold the slave open: raw mode sticks, and the master never sees EOF between clients
+  int slave = open(slavePath, O_RDWR | O_NOCTTY);
+  struct termios tio;
+  if (slave < 0 || tcgetattr(slave, &tio) != 0) {
+    perror(slavePath);
+    return 1;
+  }
+  cfmakeraw(&tio);
+  tcsetattr(slave, TCSANOW, &tio);
+  fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+
+  if (options.link) {
+    unlink(options.link);
+    if (symlink(slavePath, options.link) != 0) {
+      perror(options.link);
+      return 1;
+    }
+  }
+  printf("modem_sim: %s%s%s\n", slavePath, options.link ? " -> " : "", options.link ? options.link : "");
+  fflush(stdout);
+
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+
+  ModemSim modem(master, options);
+  while (!stopRequested) {
+    struct pollfd fds[2] = { { master, POLLIN, 0 }, { modem.socketFd(), POLLIN, 0 } };
+    int count = modem.socketFd() >= 0 ? 2 : 1;
+    if (poll(fds, count, modem.service()) <= 0) {
+      continue;
+    }
+    if (fds[0].revents & POLLIN) {
+      uint8_t buffer[256];
+      ssize_t n = read(master, buffer, sizeof(buffer));
+      for (ssize_t i = 0; i < n; i++) {
+        modem.onByte(buffer[i]);
+      }
+    }
+    if (count == 2 && (fds[1].revents & (POLLIN | POLLHUP | POLLERR))) {
+      modem.onSocketReadable();
+    }
+  }
+
+  const SimStats &stats = modem.stats();
+  fprintf(stderr, "modem_sim: %u commands (%u ERROR), %u SMS (%u failed, %u swallowed), "
+                  "%u TCP connects (%u failed, %u already connected, %u closes failed), %lu bytes sent, "
+                  "%u URCs, %lu garbage bytes\n",
+          stats.commands, stats.errors, stats.sms, stats.smsFailed, stats.smsDropped,
+          stats.connects, stats.connectFailures, stats.alreadyConnected, stats.closeFailures,
+          stats.bytesSent, stats.urcs, stats.garbageBytes);
+  if (options.link) {
+    unlink(options.link);
+  }
+  close(slave);
+  close(master);
+  return 0;
+}
@@ -0,0 +1,186 @@
+/**
+ * Local TCP receiver for GPRS fallback batches (ENABLE_GPRS_FALLBACK).
+ *
+ * Accepts connections on a port, parses GprsBatch frames from the stream
+ * (CRC checked) and writes one JSON line per sample, built with the same
+ * Telemetry live-payload builder the firmware uses for Sensor_Data:
+ *
+ *   {"device":"user1","time_ms":1718000000000,"AHT10":{"Humidity":..},...}
+ *
+ * Only the sensors in the sample's mask are present. Ctrl-C (or --frames)
+ * ends the run with a summary of frames, samples and bytes per sample.
+ *
+ * Build from the project root:
+ *   g++ -O2 -std=c++17 -Ilib/GprsUplink -Ilib/DutyCycle -Ilib/Telemetry -Ilib/WindowStats -Itools/common \
+ *       tools/gprs_sim/tcp_sink.cpp lib/GprsUplink/GprsBatch.cpp lib/DutyCycle/DutyCycle.cpp -o tcp_sink
+ *
+ * Usage:
+ *   tcp_sink [--port 9000] [--frames N] [--out samples.jsonl]
+ */
+#include <GprsBatch.h>
+#include <HostJson.h>
+
+#include <netinet/in.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+struct SinkStats {
+  unsigned connections = 0;
+  unsigned frames = 0;
+  unsigned badFrames = 0;
+  unsigned long samples = 0;
+  unsigned long bytes = 0;
+  unsigned long frameBytes = 0;
+};
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void onSignal(int) {
+  stopRequested = 1;
+}
+
+static void writeFrame(FILE* out, const GprsBatchFrame &frame) {
+  for (uint8_t i = 0; i < frame.count; i++) {
+    SensorSample sample;
+    uint8_t mask = dutySampleUnpack(frame.samples[i], sample);
+
+    HostJson json;
+    json.set("device", frame.deviceId);
+    json.setRaw("time_ms", std::to_string(frame.baseMs + frame.samples[i].offsetMs));
+    for (int node = 0; node < LIVE_NODE_COUNT; node++) {
+      if (mask & (1 << node)) {
+        HostJson nodeJson;
+        buildLivePayload(nodeJson, (LiveNode)node, sample);
+        json.set(LIVE_NODE_NAMES[node], nodeJson);
+      }
+    }
+    fprintf(out, "%s\n", json.toString().c_str());
+  }
+  fflush(out);
+}
+
+/**
+ * @brief Decode every complete frame in buffer and drop the consumed bytes
+ */
+static void drainFrames(std::vector<uint8_t> &buffer, FILE* out, SinkStats &stats) {
+  static GprsBatchFrame frame;
+  size_t offset = 0;
+  while (offset < buffer.size()) {
+    int length = gprsBatchParse(buffer.data() + offset, buffer.size() - offset, frame);
+    if (length == 0) {
+      break;
+    }
+    if (length < 0) {
+      // Resynchronise on the next magic
+      stats.badFrames++;
+      size_t next = offset + 1;
+      while (next + 3 <= buffer.size() && memcmp(buffer.data() + next, "VSB", 3) != 0) {
+        next++;
+      }
+      offset = next + 3 <= buffer.size() ? next : buffer.size();
+      continue;
+    }
+    stats.frames++;
+    stats.samples += frame.count;
+    stats.frameBytes += length;
+    fprintf(stderr, "[sink] frame from %s: %u samples in %d bytes\n", frame.deviceId, frame.count, length);
+    writeFrame(out, frame);
+    offset += length;
+  }
+  buffer.erase(buffer.begin(), buffer.begin() + offset);
+}
+
+int main(int argc, char** argv) {
+  int port = 9000;
+  unsigned maxFrames = 0;
+  const char* outPath = NULL;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--port") && i + 1 < argc) {
+      port = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--frames") && i + 1 < argc) {
+      maxFrames = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--out") && i + 1 < argc) {
+      outPath = argv[++i];
+    } else {
+      fprintf(stderr, "usage: %s [--port 9000] [--frames N] [--out samples.jsonl]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  FILE* out = outPath ? fopen(outPath, "w") : stdout;
+  if (!out) {
+    perror(outPath);
+    return 1;
+  }
+
+  int listener = socket(AF_INET, SOCK_STREAM, 0);
+  int yes = 1;
+  setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+  struct sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  address.sin_port = htons(port);
+  if (bind(listener, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 4) != 0) {
+    perror("tcp_sink");
+    return 1;
+  }
+  fprintf(stderr, "tcp_sink: listening on port %d\n", port);
+
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+
+  SinkStats stats;
+  int client = -1;
+  std::vector<uint8_t> buffer;
+  while (!stopRequested && (maxFrames == 0 || stats.frames < maxFrames)) {
+    struct pollfd fd = { client >= 0 ? client : listener, POLLIN, 0 };
+    if (poll(&fd, 1, 200) <= 0) {
+      continue;
+    }
+    if (client < 0) {
+      client = accept(listener, NULL, NULL);
+      if (client >= 0) {
+        stats.connections++;
+        buffer.clear();
+      }
+      continue;
+    }
+
+    uint8_t chunk[1024];
+    ssize_t n = recv(client, chunk, sizeof(chunk), 0);
+    if (n <= 0) {
+      if (!buffer.empty()) {
+        stats.badFrames++;   // Connection closed mid-frame
+      }
+      close(client);
+      client = -1;
+      continue;
+    }
+    stats.bytes += n;
+    buffer.insert(buffer.end(), chunk, chunk + n);
+    drainFrames(buffer, out, stats);
+  }
+
+  fprintf(stderr, "tcp_sink: %u connections, %u frames (%u bad), %lu samples, %lu bytes",
+          stats.connections, stats.frames, stats.badFrames, stats.samples, stats.bytes);
+  if (stats.samples > 0) {
+    fprintf(stderr, ", %.1f bytes/sample", (double)stats.frameBytes / stats.samples);
+  }
+  fprintf(stderr, "\n");
+  if (client >= 0) {
+    close(client);
+  }
+  close(listener);
+  if (outPath) {
+    fclose(out);
+  }
+  return stats.badFrames == 0 ? 0 : 1;
+}
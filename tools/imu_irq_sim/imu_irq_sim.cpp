@@ -0,0 +1,280 @@
+/**
+ * Polled vs. interrupt-driven IMU acquisition on the host.
+ *
+ * A mock MPU6050 thread latches a sample every 1/--rate-hz seconds on its
+ * own clock, which runs --drift-ppm off the reader's (the MPU6050's internal
+ * oscillator is only good to about a percent), with --edge-jitter-us of
+ * random jitter per edge. Each edge fires a synthetic data-ready interrupt
+ * that runs the firmware's ISR body: bump the edge count, stamp the edge and
+ * give the reader's task notification. --lost-irq-pct of the pulses latch a
+ * sample without reaching the reader, as with a glitch on the INT line.
+ *
+ * The reader takes --samples reads the way the sensor task fills a
+ * vibration block:
+ *   polled     read, then sleep until the next tick of its own 1/rate timer
+ *   interrupt  mpuWaitDataReady(): take the notification until a sample it
+ *              has not read is latched, falling back to reading after two
+ *              silent periods
+ * Each read spins for --read-us (the I2C transfer) and is scored with the
+ * firmware's DataReadyTiming (lib/DataReady).
+ *
+ * Reported per mode, in microseconds:
+ *   latency    age of the sample when read: mean / stddev / max
+ *   jitter     |read interval - sensor period|: mean / max
+ *   dup        reads that returned the sample already read
+ *   missed     samples overwritten before they were read
+ *   timeouts   interrupt waits that gave up (lost pulses)
+ *
+ * Build from the project root:
+ *   g++ -O2 -std=c++17 -pthread -Ilib/WindowStats -Ilib/DataReady \
+ *       tools/imu_irq_sim/imu_irq_sim.cpp lib/DataReady/DataReadyTiming.cpp -o imu_irq_sim
+ *
+ * Usage:
+ *   imu_irq_sim [--mode both|polled|interrupt] [--rate-hz 100] [--samples 1000]
+ *               [--drift-ppm 5000] [--edge-jitter-us 0] [--read-us 400] [--lost-irq-pct 0]
+ *
+ * Exits non-zero if the interrupt-driven reader ever reads a sample twice.
+ */
+#include <DataReadyTiming.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <random>
+#include <thread>
+
+using Clock = std::chrono::steady_clock;
+
+struct SimOptions {
+  const char* mode = "both";
+  uint32_t rateHz = 100;
+  int samples = 1000;
+  int driftPpm = 5000;
+  uint32_t edgeJitterUs = 0;
+  uint32_t readUs = 400;
+  uint32_t lostIrqPct = 0;
+};
+
+static const Clock::time_point simStart = Clock::now();
+
+static int64_t nowUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - simStart).count();
+}
+
+/**
+ * @brief FreeRTOS task notification used as a counting semaphore
+ * giveFromIsr() is vTaskNotifyGiveFromISR(), take() is ulTaskNotifyTake().
+ */
+class TaskNotification {
+public:
+  void giveFromIsr() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    value_++;
+    cv_.notify_one();
+  }
+
+  uint32_t take(bool clearOnExit, uint32_t timeoutUs) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!cv_.wait_for(lock, std::chrono::microseconds(timeoutUs), [this]() { return value_ > 0; })) {
+      return 0;
+    }
+    uint32_t value = value_;
+    value_ = clearOnExit ? 0 : value_ - 1;
+    return value;
+  }
+
+private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  uint32_t value_ = 0;
+};
+
+/**
+ * @brief MPU6050 with INT wired: latches samples on its own clock and pulses data-ready
+ */
+class MockImu {
+public:
+  MockImu(const SimOptions &options, TaskNotification* notify)
+      : periodUs_(1e6 / options.rateHz * (1.0 + options.driftPpm / 1e6)),
+        jitterUs_(options.edgeJitterUs), lostPct_(options.lostIrqPct), notify_(notify) {}
+
+  void start() {
+    running_ = true;
+    thread_ = std::thread([this]() { run(); });
+  }
+
+  void stop() {
+    running_ = false;
+    thread_.join();
+  }
+
+  /**
+   * @brief mpuDataReadyEdge()
+   */
+  DataReadyEdge edge() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return edge_;
+  }
+
+private:
+  void run() {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> jitter(-(int)jitterUs_, (int)jitterUs_);
+    std::uniform_int_distribution<uint32_t> percent(0, 99);
+    Clock::time_point base = Clock::now();
+    for (uint64_t n = 1; running_; n++) {
+      auto due = base + std::chrono::microseconds((int64_t)(n * periodUs_) + jitter(rng));
+      std::this_thread::sleep_until(due);
+      bool delivered = percent(rng) >= lostPct_;
+      onDataReady(delivered);
+    }
+  }
+
+  /**
+   * @brief Body of the firmware's onMpuDataReady()
+   */
+  void onDataReady(bool delivered) {
+    int64_t now = nowUs();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      edge_.count++;
+      edge_.us = now;
+    }
+    if (delivered && notify_) {
+      notify_->giveFromIsr();
+    }
+  }
+
+  double periodUs_;
+  uint32_t jitterUs_;
+  uint32_t lostPct_;
+  TaskNotification* notify_;
+  std::mutex mutex_;
+  DataReadyEdge edge_ = { 0, 0 };
+  std::atomic<bool> running_{false};
+  std::thread thread_;
+};
+
+struct SimResult {
+  DataReadyTiming timing;
+  DataReadyStats stats;
+  uint32_t irqs;
+  uint32_t timeouts;
+
+  explicit SimResult(uint32_t periodUs) : timing(periodUs), irqs(0), timeouts(0) {}
+};
+
+/**
+ * @brief The I2C transfer: spin rather than sleep so the host scheduler doesn't add to it
+ */
+static void readSample(uint32_t readUs) {
+  int64_t until = nowUs() + readUs;
+  while (nowUs() < until) {
+  }
+}
+
+static void runMode(const SimOptions &options, bool interrupt, SimResult &result) {
+  const uint32_t periodUs = 1000000 / options.rateHz;
+  TaskNotification notify;
+  MockImu imu(options, interrupt ? &notify : NULL);
+  imu.start();
+
+  // Let the sensor settle so both modes start mid-stream
+  std::this_thread::sleep_for(std::chrono::microseconds(5 * periodUs));
+
+  DataReadyTiming &timing = result.timing;
+  timing.restart();
+  if (interrupt) {
+    timing.discard(imu.edge());
+  }
+  Clock::time_point nextWake = Clock::now();
+  for (int i = 0; i < options.samples; i++) {
+    if (interrupt) {
+      // mpuWaitDataReady()
+      while (!timing.fresh(imu.edge())) {
+        if (notify.take(true, 2 * periodUs + 1000) == 0) {
+          result.timeouts++;
+          break;
+        }
+      }
+    }
+    DataReadyEdge edge = imu.edge();
+    readSample(options.readUs);
+    timing.record(edge, nowUs(), result.stats);
+
+    if (!interrupt) {
+      // vTaskDelayUntil(&lastWake, period)
+      nextWake += std::chrono::microseconds(periodUs);
+      std::this_thread::sleep_until(nextWake);
+    }
+  }
+
+  imu.stop();
+  result.irqs = imu.edge().count;
+}
+
+static void printResult(const char* mode, const SimResult &result) {
+  const DataReadyStats &t = result.stats;
+  printf("%-10s %6u %6u %8.0f %8.0f %8.0f %8.0f %8.0f %5u %6u %8u\n",
+         mode, t.reads, result.irqs,
+         t.latencyUs.mean, t.latencyUs.stddev(), t.latencyUs.maxValue,
+         t.jitterUs.mean, t.jitterUs.maxValue,
+         t.duplicates, t.missed, result.timeouts);
+}
+
+int main(int argc, char** argv) {
+  SimOptions options;
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    const char* value = i + 1 < argc ? argv[++i] : NULL;
+    if (!value) {
+      fprintf(stderr, "missing value for %s\n", arg);
+      return 2;
+    }
+    if (!strcmp(arg, "--mode")) options.mode = value;
+    else if (!strcmp(arg, "--rate-hz")) options.rateHz = atoi(value);
+    else if (!strcmp(arg, "--samples")) options.samples = atoi(value);
+    else if (!strcmp(arg, "--drift-ppm")) options.driftPpm = atoi(value);
+    else if (!strcmp(arg, "--edge-jitter-us")) options.edgeJitterUs = atoi(value);
+    else if (!strcmp(arg, "--read-us")) options.readUs = atoi(value);
+    else if (!strcmp(arg, "--lost-irq-pct")) options.lostIrqPct = atoi(value);
+    else {
+      fprintf(stderr, "unknown option %s\n", arg);
+      return 2;
+    }
+  }
+  bool polled = !strcmp(options.mode, "both") || !strcmp(options.mode, "polled");
+  bool interrupt = !strcmp(options.mode, "both") || !strcmp(options.mode, "interrupt");
+  if ((!polled && !interrupt) || options.rateHz == 0 || options.rateHz > 1000 || options.samples <= 0) {
+    fprintf(stderr, "bad --mode, --rate-hz or --samples\n");
+    return 2;
+  }
+
+  const uint32_t periodUs = 1000000 / options.rateHz;
+  printf("%u Hz (period %u us), sensor clock %+d ppm, edge jitter +-%u us, read %u us, %u%% pulses lost\n\n",
+         options.rateHz, periodUs, options.driftPpm, options.edgeJitterUs, options.readUs, options.lostIrqPct);
+  printf("%-10s %6s %6s %8s %8s %8s %8s %8s %5s %6s %8s\n",
+         "mode", "reads", "irqs", "lat mean", "lat sd", "lat max", "jit mean", "jit max", "dup", "missed", "timeouts");
+
+  int failures = 0;
+  if (polled) {
+    SimResult result(periodUs);
+    runMode(options, false, result);
+    printResult("polled", result);
+  }
+  if (interrupt) {
+    SimResult result(periodUs);
+    runMode(options, true, result);
+    printResult("interrupt", result);
+    if (result.stats.duplicates != 0) {
+      printf("FAIL interrupt: %u samples read twice\n", result.stats.duplicates);
+      failures++;
+    }
+  }
+  return failures == 0 ? 0 : 1;
+}
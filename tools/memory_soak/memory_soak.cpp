@@ -0,0 +1,323 @@
+/**
+ * Host soak test for the static memory plan.
+ *
+ * Runs the platform-independent part of the firmware's per-cycle work
+ * (window statistics, anomaly scoring and burst capture, ML chunk and GPRS
+ * batch encoding, duty-cycle buffering, trace logging, uplink scheduling,
+ * command envelope parsing, runtime config reporting, scratch leases from
+ * StaticPool) for many cycles with malloc/free and operator new/delete
+ * counted. After a warm-up, a steady-state cycle must not allocate at all:
+ * the tool exits 1 if any allocation is seen.
+ *
+ * Not covered: FirebaseJson and the Firebase client still allocate per
+ * request on the device (the pool only keeps the documents alive between
+ * jobs). The firmware's <USER>/Heap_Report tracks that side: free bytes,
+ * largest free block and the fragmentation figure derived from them.
+ *
+ * Build from the project root:
+ *   g++ -O2 -std=c++17 -Ilib/StaticMemory -Ilib/WindowStats -Ilib/Telemetry -Ilib/AnomalyBurst \
+ *       -Ilib/GprsUplink -Ilib/DutyCycle -Ilib/TraceLog -Ilib/UplinkScheduler -Ilib/RuntimeConfig \
+ *       -Ilib/CommandProtocol tools/memory_soak/memory_soak.cpp lib/CommandProtocol/CommandProtocol.cpp \
+ *       lib/Telemetry/MlBatch.cpp lib/AnomalyBurst/AnomalyDetector.cpp lib/AnomalyBurst/BurstRecorder.cpp \
+ *       lib/GprsUplink/GprsBatch.cpp lib/DutyCycle/DutyCycle.cpp \
+ *       lib/TraceLog/TraceLog.cpp lib/UplinkScheduler/UplinkScheduler.cpp lib/RuntimeConfig/RuntimeConfig.cpp \
+ *       -o memory_soak
+ *
+ * Usage:
+ *   memory_soak [--cycles N] [--warmup N]
+ */
+#include <AnomalyDetector.h>
+#include <BurstRecorder.h>
+#include <CommandProtocol.h>
+#include <DutyCycle.h>
+#include <FixedString.h>
+#include <GprsBatch.h>
+#include <MlBatch.h>
+#include <RuntimeConfig.h>
+#include <StaticPool.h>
+#include <TraceLog.h>
+#include <UplinkScheduler.h>
+#include <WindowStats.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <new>
+
+// Match src/main.cpp
+#define ML_CHUNK_BUFFER_BYTES  12288
+#define BURST_CHUNK_ROWS       12
+#define BURST_PRE_TRIGGER_ROWS 12
+
+// ---------------------------------------------------------------------------
+// Allocation counting. glibc's __libc_* entry points do the real work, so the
+// counters see every allocation made through malloc or new.
+// ---------------------------------------------------------------------------
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void __libc_free(void* ptr);
+}
+
+static size_t allocations = 0;
+static size_t allocatedBytes = 0;
+
+extern "C" void* malloc(size_t size) {
+  allocations++;
+  allocatedBytes += size;
+  return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size) {
+  allocations++;
+  allocatedBytes += count * size;
+  return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* ptr, size_t size) {
+  allocations++;
+  allocatedBytes += size;
+  return __libc_realloc(ptr, size);
+}
+
+extern "C" void free(void* ptr) { __libc_free(ptr); }
+
+void* operator new(size_t size) {
+  void* ptr = malloc(size);
+  if (!ptr) throw std::bad_alloc();
+  return ptr;
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* ptr) noexcept { free(ptr); }
+void operator delete[](void* ptr) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { free(ptr); }
+
+// ---------------------------------------------------------------------------
+// Firmware-side state, laid out the way src/main.cpp reserves it
+// ---------------------------------------------------------------------------
+struct ChunkText {
+  char text[ML_CHUNK_BUFFER_BYTES];
+  void clear() { text[0] = '\0'; }
+};
+
+static StaticPool<ChunkText, 1> chunkPool;
+static StaticPool<MlBatch, 1> batchPool;
+static AnomalyDetector anomalyDetector(0.05f, 20);
+static BurstRecorder burstRecorder;
+static WindowStats windowStats[WF_COUNT];
+static GprsBatch gprsBatch;
+static uint8_t gprsFrame[GPRS_BATCH_MAX_BYTES];
+static DutyCycleState dutyState;
+static UplinkScheduler scheduler;
+static RuntimeConfig runtimeConfig;
+static char configJson[512];
+static uint8_t traceBuffer[256];
+static BurstRow burstRows[BURST_CHUNK_ROWS];
+static FixedString<15> status;
+static char commandText[COMMAND_TEXT_MAX + 1];
+
+static uint32_t rngState = 12345;
+
+static float noise(float scale) {
+  rngState = rngState * 1664525u + 1013904223u;
+  return scale * ((float)(rngState >> 8) / 16777216.0f - 0.5f);
+}
+
+static SensorSample synthSample(uint32_t cycle) {
+  SensorSample s;
+  memset(&s, 0, sizeof(s));
+  s.humidity = 45.0f + noise(0.5f);
+  s.temperature = 24.0f + noise(0.1f);
+  s.ambient = 25.0f + noise(0.1f);
+  s.object = 30.0f + noise(0.2f);
+  s.accelX = noise(0.05f);
+  s.accelY = noise(0.05f);
+  s.accelZ = 9.81f + noise(0.05f);
+  s.gyroX = noise(0.01f);
+  s.gyroY = noise(0.01f);
+  s.gyroZ = noise(0.01f);
+  s.temperatureMPU = 28.0f + noise(0.1f);
+  s.tvoc = (uint16_t)(10 + (cycle % 5));
+  s.eco2 = (uint16_t)(400 + (cycle % 7));
+  s.epochUs = 1700000000000000LL + (int64_t)cycle * 2600000LL;
+  // A disturbance every 500 cycles, so bursts start, extend and end
+  if (cycle % 500 >= 480) {
+    s.object += 15.0f;
+    s.accelX += 4.0f;
+  }
+  return s;
+}
+
+/**
+ * @brief One acquisition + upload cycle
+ * @return bytes produced, so the work cannot be optimised away
+ */
+static size_t runCycle(uint32_t cycle) {
+  const uint8_t mask = SENSOR_BIT_AHT10 | SENSOR_BIT_MLX90614 | SENSOR_BIT_MPU6050 | SENSOR_BIT_SGP30;
+  const uint32_t nowMs = cycle * 2600;
+  size_t produced = 0;
+
+  SensorSample sample = synthSample(cycle);
+  for (int f = 0; f < WF_COUNT; f++) {
+    windowStats[f].add(sampleField(sample, f));
+  }
+  TLOG(TL_MLX_READING, sample.ambient, sample.object);
+
+  AnomalyScore score = anomalyDetector.update(sample, mask);
+  bool anomalous = score.z >= 5.0f;
+  burstRecorder.configure(BURST_PRE_TRIGGER_ROWS, 30000, 120000);
+  burstRecorder.observe(sample, mask, sample.epochUs / 1000, score, anomalous, nowMs);
+
+  // Burst chunk: rows straight from the ring into leased scratch
+  if (cycle % 4 == 0) {
+    size_t rows = burstRecorder.peek(burstRows, BURST_CHUNK_ROWS);
+    if (rows > 0) {
+      PoolLease<MlBatch, 1> batch(batchPool);
+      PoolLease<ChunkText, 1> chunk(chunkPool);
+      if (!batch || !chunk) return 0;
+      for (size_t i = 0; i < rows; i++) {
+        MlBatchRow* row = batch->nextRow();
+        row->timeMs = (double)burstRows[i].timeMs;
+        row->sample = burstRows[i].sample;
+        row->actionsOn = 0;
+        batch->push();
+      }
+      produced += batch->encode(chunk->text, sizeof(chunk->text), mask, false);
+      burstRecorder.commit();
+    }
+  }
+
+  // ML window closes every 12 cycles; the chunk is encoded once the batch is full
+  static MlBatch mlBatch;
+  if (cycle % 12 == 11) {
+    MlBatchRow* row = mlBatch.nextRow();
+    if (row) {
+      row->timeMs = (double)(sample.epochUs / 1000);
+      row->sample = sample;
+      row->actionsOn = (uint8_t)(cycle & 0x1F);
+      for (int f = 0; f < WF_COUNT; f++) {
+        row->window[f] = windowStats[f];
+        windowStats[f].reset();
+      }
+      mlBatch.push();
+    }
+    if (mlBatch.full()) {
+      PoolLease<ChunkText, 1> chunk(chunkPool);
+      if (!chunk) return 0;
+      produced += mlBatch.encode(chunk->text, sizeof(chunk->text), mask, true);
+      mlBatch.clear();
+    }
+  }
+
+  // GPRS fallback batch and deep-sleep sample buffer
+  gprsBatch.push(sample, mask, sample.epochUs / 1000);
+  if (gprsBatch.size() >= GPRS_BATCH_CAPACITY) {
+    produced += gprsBatch.encode("soak-device", gprsFrame, sizeof(gprsFrame));
+    gprsBatch.clear();
+  }
+  dutyCyclePush(dutyState, sample, mask, sample.epochUs / 1000);
+  if (dutyState.count >= DUTY_CYCLE_CAPACITY) {
+    dutyCycleConsume(dutyState, dutyState.count);
+  }
+
+  // Uplink jobs and their bookkeeping
+  scheduler.enqueue(0, UPLINK_LIVE, 0, nowMs, 5000);
+  if (cycle % 10 == 0) {
+    scheduler.enqueue(1, UPLINK_COMMAND, 0, nowMs, 2000);
+    scheduler.enqueue(2, UPLINK_BULK, (uint16_t)cycle, nowMs, 60000);
+  }
+  UplinkJob job;
+  while (scheduler.next(nowMs, job)) {
+    scheduler.complete(job, nowMs, nowMs + 40);
+  }
+
+  // Command poll: a new envelope every 20 polls, the same one in between
+  if (cycle % 2 == 0) {
+    CommandEnvelope cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.version = COMMAND_PROTOCOL_VERSION;
+    cmd.seq = cycle / 40 + 1;
+    cmd.type = CMD_ACTION;
+    cmd.issuedMs = sample.epochUs / 1000;
+    cmd.expiresMs = cmd.issuedMs + 30000;
+    snprintf(cmd.params, sizeof(cmd.params), "%u=%s", (unsigned)(cycle % 5) + 1, (cycle & 4) ? "ON" : "OFF");
+    static uint32_t handledHash = 0;
+    static uint32_t lastSeq = 0;
+    if (cycle % 40 == 0) {
+      produced += commandFormat(cmd, commandText, sizeof(commandText));
+    }
+    uint32_t hash = commandTextHash(commandText);
+    if (hash != handledHash) {
+      handledHash = hash;
+      if (commandParse(commandText, cmd) == CMD_OK && commandCheck(cmd, lastSeq, cmd.issuedMs) == CMD_OK) {
+        lastSeq = cmd.seq;
+      }
+    }
+  }
+
+  if (cycle % 25 == 0) {
+    produced += runtimeConfigToJson(runtimeConfig, configJson, sizeof(configJson));
+    status = (cycle % 50 == 0) ? "Working" : "Not Working";
+    produced += status.length();
+  }
+
+  produced += traceLogDrain(traceBuffer, sizeof(traceBuffer));
+  return produced;
+}
+
+int main(int argc, char** argv) {
+  unsigned long cycles = 100000;
+  unsigned long warmup = 1000;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--cycles") == 0 && i + 1 < argc) {
+      cycles = strtoul(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+      warmup = strtoul(argv[++i], NULL, 10);
+    } else {
+      fprintf(stderr, "usage: %s [--cycles N] [--warmup N]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  memset(&runtimeConfig, 0, sizeof(runtimeConfig));
+  runtimeConfig.sensorPeriodMs = 2600;
+  strcpy(runtimeConfig.targetPhone, "+10000000000");
+  dutyCycleReset(dutyState);
+  traceLogSetLevel(TL_DEBUG);
+
+  size_t produced = 0;
+  uint32_t cycle = 0;
+  for (; cycle < warmup; cycle++) {
+    produced += runCycle(cycle);
+  }
+  size_t warmupAllocations = allocations;
+
+  allocations = 0;
+  allocatedBytes = 0;
+  for (; cycle < warmup + cycles; cycle++) {
+    produced += runCycle(cycle);
+  }
+  size_t steadyAllocations = allocations;
+  size_t steadyBytes = allocatedBytes;
+
+  printf("warm-up:      %lu cycles, %zu allocations\n", warmup, warmupAllocations);
+  printf("steady state: %lu cycles, %zu allocations (%.4f per cycle), %zu bytes\n",
+         cycles, steadyAllocations, cycles ? (double)steadyAllocations / cycles : 0.0, steadyBytes);
+  printf("bursts: %u, burst rows dropped: %u, payload bytes: %zu\n",
+         burstRecorder.bursts(), burstRecorder.dropped(), produced);
+  printf("pools: chunk high water %zu/%zu, batch high water %zu/%zu, exhausted %u\n",
+         chunkPool.highWater(), chunkPool.capacity(), batchPool.highWater(), batchPool.capacity(),
+         chunkPool.exhausted() + batchPool.exhausted());
+  printf("static scratch: %zu bytes\n", chunkPool.bytes() + batchPool.bytes());
+
+  if (steadyAllocations != 0) {
+    printf("FAIL: steady-state cycles allocate\n");
+    return 1;
+  }
+  printf("OK: no steady-state allocations\n");
+  return 0;
+}
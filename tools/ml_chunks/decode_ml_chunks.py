@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+"""Decode columnar ML training chunks back into per-sample records.
+
+Devices built with ML_BATCH_SIZE > 0 upload <USER>/ML_Training_Chunks/chunk_NNN
+documents (see lib/Telemetry/MlBatch.h). This turns them back into records
+shaped like the legacy <USER>/ML_Training_Data/record_NNN documents, so
+training scripts can consume either source unchanged.
+
+Usage:
+  decode_ml_chunks.py export.json            # RTDB JSON export (whole DB or any subtree)
+  decode_ml_chunks.py --url 'https://<db>.firebaseio.com/User1/ML_Training_Chunks.json?auth=<token>'
+
+Prints one JSON record per line, ordered by timestamp.
+
+Actions are lossy: chunks keep one "is ON" bit per action, so every other
+value the device saw ("AUTO", "", ...) comes back as "OFF". Train on
+ML_Training_Data records instead if a model needs the raw action strings.
+
+As a library:
+  from decode_ml_chunks import decode_chunk
+  records = decode_chunk(chunk_dict)
+"""
+import json
+import sys
+import urllib.request
+
+SUPPORTED_VERSIONS = (1,)
+STAT_NAMES = ("min", "max", "mean", "std", "n")
+
+# Devices use epoch ms for t0 once NTP has synced, uptime ms before that
+EPOCH_MS_THRESHOLD = 1e12
+
+
+def decode_chunk(chunk):
+    """Expand one chunk document into a list of per-sample record dicts."""
+    version = chunk.get("v")
+    if version not in SUPPORTED_VERSIONS:
+        raise ValueError("unsupported chunk version: %r" % (version,))
+
+    count = chunk["n"]
+    deltas = chunk["dt"]
+    actions_on = chunk.get("actions_on", [0] * count)
+
+    # Rebuild absolute timestamps from the base + deltas
+    timestamps = []
+    t = chunk["t0"]
+    for delta in deltas:
+        t += delta
+        timestamps.append(t)
+
+    records = []
+    for row in range(count):
+        record = {"timestamp_ms": timestamps[row]}
+        if timestamps[row] > EPOCH_MS_THRESHOLD:
+            record["epoch_us"] = timestamps[row] * 1000
+        for sensor, columns in chunk.items():
+            if sensor in ("v", "n", "mask", "t0", "dt", "actions_on", "Window"):
+                continue
+            record[sensor] = {name: values[row] for name, values in columns.items()}
+
+        window = {}
+        for sensor, fields in chunk.get("Window", {}).items():
+            for name, stats in fields.items():
+                if stats["n"][row] == 0:
+                    continue  # Field had no samples in that window
+                window.setdefault(sensor, {})[name] = {s: stats[s][row] for s in STAT_NAMES}
+        if window:
+            record["Window"] = window
+
+        # Only "ON" survives the bitmask; any other original value reads as "OFF"
+        mask = actions_on[row]
+        record["Actions"] = {
+            "action_%d" % (i + 1): ("ON" if mask & (1 << i) else "OFF") for i in range(5)
+        }
+        records.append(record)
+    return records
+
+
+def find_chunks(node):
+    """Yield every chunk document found anywhere in an RTDB JSON tree."""
+    if isinstance(node, dict):
+        if "v" in node and "dt" in node and "t0" in node:
+            yield node
+            return
+        for child in node.values():
+            yield from find_chunks(child)
+    elif isinstance(node, list):
+        for child in node:
+            yield from find_chunks(child)
+
+
+def main(argv):
+    if len(argv) == 3 and argv[1] == "--url":
+        with urllib.request.urlopen(argv[2]) as response:
+            tree = json.load(response)
+    elif len(argv) == 2:
+        with open(argv[1]) as f:
+            tree = json.load(f)
+    else:
+        print(__doc__)
+        return 2
+
+    records = []
+    for chunk in find_chunks(tree):
+        records.extend(decode_chunk(chunk))
+    records.sort(key=lambda r: r["timestamp_ms"])
+
+    for record in records:
+        print(json.dumps(record, separators=(",", ":")))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,459 @@
+/**
+ * Multi-device load generator against a local Realtime Database stand-in.
+ *
+ * Starts an in-process HTTP server that emulates the RTDB REST API
+ * (PUT/PATCH/GET/DELETE on /<path>.json, keep-alive) and N simulated devices.
+ * Each device runs the same request sequence as TaskFirebaseSender, with
+ * payloads built by the shared Telemetry builders used on the ESP32:
+ *   - saveFirebaseActions(): 4x PUT <user>/Sensor_Data/<sensor>
+ *   - saveToFirestore():     GET + PUT ML_Training_Meta/record_count,
+ *                            DELETE on rotation, PUT ML_Training_Data/record_NNN
+ *                            (or ML_Training_Chunks/chunk_NNN with --ml-batch)
+ *   - readFirebaseActions(): 5x GET <user>/Actions/action_n
+ *
+ * Build and run from the project root:
+ *   g++ -O2 -std=c++17 -pthread -Ilib/WindowStats -Ilib/Telemetry -Itools/common \
+ *       tools/rtdb_loadgen/rtdb_loadgen.cpp lib/Telemetry/MlBatch.cpp -o rtdb_loadgen
+ *   ./rtdb_loadgen --devices 1,10,100,500 --duration 20
+ *
+ * Options:
+ *   --devices a,b,c     device counts to sweep (default 1,10,100)
+ *   --duration S        seconds per step (default 15)
+ *   --interval-ms MS    cycle period per device, 0 = back-to-back (default 5000)
+ *   --layout L          per-device: every device under its own Device%04d tree
+ *                       shared:     every device under "User1" (today's hardcoded USER_NAME)
+ *   --batch             send the four live nodes as one PATCH on Sensor_Data
+ *   --ml-batch K        upload ML samples as columnar chunks of K (ML_BATCH_SIZE)
+ */
+#include <Telemetry.h>
+#include <MlBatch.h>
+#include <HostJson.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static const int MAX_ML_RECORDS = 100;   // Same rotation limit as main.cpp
+
+// ------------------------------------------------------------------
+// RTDB REST stand-in
+// ------------------------------------------------------------------
+
+class RtdbServer {
+public:
+  bool start() {
+    listenFd_ = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    if (bind(listenFd_, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(listenFd_, 1024) != 0) {
+      perror("rtdb server");
+      return false;
+    }
+    socklen_t len = sizeof(addr);
+    getsockname(listenFd_, (sockaddr*)&addr, &len);
+    port_ = ntohs(addr.sin_port);
+
+    std::thread([this]() { acceptLoop(); }).detach();
+    return true;
+  }
+
+  int port() const { return port_; }
+
+  void reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    store_.clear();
+  }
+
+  // Number of stored nodes whose path contains the given fragment
+  size_t countNodes(const std::string &fragment) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t n = 0;
+    for (const auto &entry : store_) {
+      if (entry.first.find(fragment) != std::string::npos) n++;
+    }
+    return n;
+  }
+
+private:
+  int listenFd_ = -1;
+  int port_ = 0;
+  std::mutex mutex_;
+  std::map<std::string, std::string> store_;   // Path -> serialised JSON value
+
+  void acceptLoop() {
+    for (;;) {
+      int fd = accept(listenFd_, nullptr, nullptr);
+      if (fd < 0) continue;
+      std::thread([this, fd]() { serve(fd); }).detach();
+    }
+  }
+
+  void serve(int fd) {
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    std::string buffer;
+    char chunk[8192];
+
+    for (;;) {
+      size_t headerEnd;
+      while ((headerEnd = buffer.find("\r\n\r\n")) == std::string::npos) {
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) { close(fd); return; }
+        buffer.append(chunk, n);
+      }
+
+      std::string header = buffer.substr(0, headerEnd);
+      size_t contentLength = 0;
+      size_t cl = header.find("Content-Length: ");
+      if (cl != std::string::npos) contentLength = strtoul(header.c_str() + cl + 16, nullptr, 10);
+
+      while (buffer.size() < headerEnd + 4 + contentLength) {
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) { close(fd); return; }
+        buffer.append(chunk, n);
+      }
+      std::string body = buffer.substr(headerEnd + 4, contentLength);
+      buffer.erase(0, headerEnd + 4 + contentLength);
+
+      std::string method = header.substr(0, header.find(' '));
+      size_t pathStart = header.find(' ') + 2;   // Skip leading '/'
+      std::string path = header.substr(pathStart, header.find(".json", pathStart) - pathStart);
+
+      std::string response = handle(method, path, body);
+      std::string reply = "HTTP/1.1 200 OK\r\nContent-Type: application/json; charset=utf-8\r\n"
+                          "Connection: keep-alive\r\nContent-Length: " +
+                          std::to_string(response.size()) + "\r\n\r\n" + response;
+      if (send(fd, reply.data(), reply.size(), MSG_NOSIGNAL) < 0) { close(fd); return; }
+    }
+  }
+
+  std::string handle(const std::string &method, const std::string &path, const std::string &body) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (method == "GET") {
+      auto it = store_.find(path);
+      return it == store_.end() ? "null" : it->second;
+    }
+    if (method == "DELETE") {
+      auto it = store_.lower_bound(path);
+      while (it != store_.end() && it->first.compare(0, path.size(), path) == 0) {
+        it = store_.erase(it);
+      }
+      return "null";
+    }
+    // PUT and PATCH both store the body at the path (no child merge) and echo it like the real RTDB
+    store_[path] = body;
+    return body;
+  }
+};
+
+// ------------------------------------------------------------------
+// Simulated device
+// ------------------------------------------------------------------
+
+struct DeviceStats {
+  uint64_t requests = 0;
+  uint64_t bytesSent = 0;
+  uint64_t bytesReceived = 0;
+  uint64_t samples = 0;
+  uint64_t errors = 0;
+  std::vector<double> latencyUs;
+};
+
+class Device {
+public:
+  Device(int port, std::string user, bool batch, int mlBatch, uint32_t seed)
+    : port_(port), user_(std::move(user)), batch_(batch), mlBatch_(mlBatch), rng_(seed) {}
+
+  ~Device() { if (fd_ >= 0) close(fd_); }
+
+  void run(Clock::time_point until, int intervalMs, DeviceStats &stats) {
+    stats_ = &stats;
+    // Spread device start times over one interval, like a real fleet
+    if (intervalMs > 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(rng_() % intervalMs));
+    }
+    Clock::time_point next = Clock::now();
+    while (Clock::now() < until) {
+      cycle();
+      stats.samples++;
+      if (intervalMs > 0) {
+        next += std::chrono::milliseconds(intervalMs);
+        std::this_thread::sleep_until(next);
+      }
+    }
+  }
+
+private:
+  int port_;
+  std::string user_;
+  bool batch_;
+  int mlBatch_;
+  MlBatch chunk_;
+  std::mt19937 rng_;
+  int fd_ = -1;
+  DeviceStats* stats_ = nullptr;
+  SensorSample sample_ = { 60, 29, 28, 33, 0.1f, 0.2f, 9.8f, 0, 0, 0, 31, 12, 400, 1760000000000000LL };
+
+  void cycle() {
+    std::normal_distribution<float> noise(0.0f, 0.05f);
+    WindowStats window[WF_COUNT];
+    // Two sensor reads per 5 s window, matching the acquisition task cadence
+    for (int read = 0; read < 2; read++) {
+      float* fields[] = {
+        &sample_.humidity, &sample_.temperature, &sample_.ambient, &sample_.object,
+        &sample_.accelX, &sample_.accelY, &sample_.accelZ, &sample_.gyroX, &sample_.gyroY,
+        &sample_.gyroZ, &sample_.temperatureMPU
+      };
+      for (float* field : fields) *field += noise(rng_);
+      const float values[WF_COUNT] = {
+        sample_.humidity, sample_.temperature, sample_.ambient, sample_.object,
+        sample_.accelX, sample_.accelY, sample_.accelZ, sample_.gyroX, sample_.gyroY,
+        sample_.gyroZ, sample_.temperatureMPU, (float)sample_.tvoc, (float)sample_.eco2
+      };
+      for (int f = 0; f < WF_COUNT; f++) window[f].add(values[f]);
+    }
+
+    // 1. saveFirebaseActions()
+    if (batch_) {
+      HostJson json;
+      for (int node = 0; node < LIVE_NODE_COUNT; node++) {
+        HostJson nodeJson;
+        buildLivePayload(nodeJson, (LiveNode)node, sample_);
+        json.set(LIVE_NODE_NAMES[node], nodeJson);
+      }
+      request("PATCH", user_ + "/Sensor_Data", json.toString());
+    } else {
+      for (int node = 0; node < LIVE_NODE_COUNT; node++) {
+        HostJson json;
+        buildLivePayload(json, (LiveNode)node, sample_);
+        request("PUT", user_ + "/Sensor_Data/" + LIVE_NODE_NAMES[node], json.toString());
+      }
+    }
+
+    static const char* const actions[ACTION_COUNT] = { "OFF", "OFF", "OFF", "OFF", "OFF" };
+
+    // 2b. saveToMlBatch(): one columnar chunk every mlBatch_ samples
+    if (mlBatch_ > 0) {
+      MlBatchRow* row = chunk_.nextRow();
+      row->timeMs = 123456789.0 + stats_->samples * 5000.0;
+      row->sample = sample_;
+      row->actionsOn = actionsOnMask(actions);
+      for (int f = 0; f < WF_COUNT; f++) row->window[f] = window[f];
+      chunk_.push();
+      if (chunk_.size() >= mlBatch_) {
+        static thread_local char buffer[32768];
+        size_t length = chunk_.encode(buffer, sizeof(buffer), 0x0F, true);
+        chunk_.clear();
+        std::string countPath = user_ + "/ML_Training_Meta/chunk_count";
+        int count = atoi(request("GET", countPath, "").c_str()) + 1;
+        if (count > MAX_ML_RECORDS / mlBatch_) {
+          count = 1;
+          request("DELETE", user_ + "/ML_Training_Chunks", "");
+        }
+        request("PUT", countPath, std::to_string(count));
+        char chunkPath[48];
+        snprintf(chunkPath, sizeof(chunkPath), "/ML_Training_Chunks/chunk_%03d", count);
+        request("PUT", user_ + chunkPath, std::string(buffer, length));
+      }
+    } else {
+      saveRecord(window, actions);
+    }
+
+    // 3. readFirebaseActions()
+    for (int i = 1; i <= ACTION_COUNT; i++) {
+      request("GET", user_ + "/Actions/action_" + std::to_string(i), "");
+    }
+  }
+
+  // 2a. saveToFirestore() with manageMLDataRotation()
+  void saveRecord(const WindowStats* window, const char* const* actions) {
+    std::string countPath = user_ + "/ML_Training_Meta/record_count";
+    std::string countBody = request("GET", countPath, "");
+    int count = atoi(countBody.c_str()) + 1;
+    if (count > MAX_ML_RECORDS) {
+      count = 1;
+      request("DELETE", user_ + "/ML_Training_Data", "");
+    }
+    request("PUT", countPath, std::to_string(count));
+
+    char docPath[48];
+    snprintf(docPath, sizeof(docPath), "/ML_Training_Data/record_%03d", count);
+    HostJson record;
+    buildMlRecord(record, sample_, 0x0F, window, actions, 123456789.0);
+    request("PUT", user_ + docPath, record.toString());
+  }
+
+  bool connectServer() {
+    fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port_);
+    if (connect(fd_, (sockaddr*)&addr, sizeof(addr)) != 0) {
+      close(fd_);
+      fd_ = -1;
+      return false;
+    }
+    return true;
+  }
+
+  std::string request(const char* method, const std::string &path, const std::string &body) {
+    if (fd_ < 0 && !connectServer()) {
+      stats_->errors++;
+      return "";
+    }
+
+    std::string req = std::string(method) + " /" + path + ".json?auth=TOKEN HTTP/1.1\r\n"
+                      "Host: localhost\r\nConnection: keep-alive\r\n"
+                      "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+
+    Clock::time_point start = Clock::now();
+    if (send(fd_, req.data(), req.size(), MSG_NOSIGNAL) < 0) {
+      close(fd_);
+      fd_ = -1;
+      stats_->errors++;
+      return "";
+    }
+
+    std::string buffer;
+    char chunk[8192];
+    size_t headerEnd;
+    while ((headerEnd = buffer.find("\r\n\r\n")) == std::string::npos) {
+      ssize_t n = recv(fd_, chunk, sizeof(chunk), 0);
+      if (n <= 0) { close(fd_); fd_ = -1; stats_->errors++; return ""; }
+      buffer.append(chunk, n);
+    }
+    size_t cl = buffer.find("Content-Length: ");
+    size_t contentLength = strtoul(buffer.c_str() + cl + 16, nullptr, 10);
+    while (buffer.size() < headerEnd + 4 + contentLength) {
+      ssize_t n = recv(fd_, chunk, sizeof(chunk), 0);
+      if (n <= 0) { close(fd_); fd_ = -1; stats_->errors++; return ""; }
+      buffer.append(chunk, n);
+    }
+    double us = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+
+    stats_->requests++;
+    stats_->bytesSent += req.size();
+    stats_->bytesReceived += buffer.size();
+    stats_->latencyUs.push_back(us);
+    return buffer.substr(headerEnd + 4, contentLength);
+  }
+};
+
+// ------------------------------------------------------------------
+// Driver
+// ------------------------------------------------------------------
+
+static double percentile(std::vector<double> &sorted, double p) {
+  if (sorted.empty()) return 0.0;
+  size_t index = (size_t)(p * (sorted.size() - 1));
+  return sorted[index];
+}
+
+int main(int argc, char** argv) {
+  std::vector<int> deviceCounts = { 1, 10, 100 };
+  int durationS = 15;
+  int intervalMs = 5000;
+  bool shared = false;
+  bool batch = false;
+  int mlBatch = 0;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--devices" && i + 1 < argc) {
+      deviceCounts.clear();
+      std::string list = argv[++i];
+      size_t pos = 0;
+      while (pos < list.size()) {
+        deviceCounts.push_back(atoi(list.c_str() + pos));
+        size_t comma = list.find(',', pos);
+        if (comma == std::string::npos) break;
+        pos = comma + 1;
+      }
+    } else if (arg == "--duration" && i + 1 < argc) {
+      durationS = atoi(argv[++i]);
+    } else if (arg == "--interval-ms" && i + 1 < argc) {
+      intervalMs = atoi(argv[++i]);
+    } else if (arg == "--layout" && i + 1 < argc) {
+      shared = std::string(argv[++i]) == "shared";
+    } else if (arg == "--batch") {
+      batch = true;
+    } else if (arg == "--ml-batch" && i + 1 < argc) {
+      mlBatch = std::min(atoi(argv[++i]), ML_BATCH_CAPACITY);
+    } else {
+      fprintf(stderr, "usage: %s [--devices a,b,c] [--duration S] [--interval-ms MS] "
+                      "[--layout per-device|shared] [--batch] [--ml-batch K]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  RtdbServer server;
+  if (!server.start()) return 1;
+
+  printf("layout=%s batch=%s ml-batch=%d interval=%d ms duration=%d s\n",
+         shared ? "shared" : "per-device", batch ? "yes" : "no", mlBatch, intervalMs, durationS);
+  printf("%8s %10s %10s %10s %11s %9s %9s %9s %9s %7s %9s\n",
+         "devices", "samples", "req/s", "req/smpl", "bytes/smpl",
+         "p50 us", "p95 us", "p99 us", "max us", "errors", "ML docs");
+
+  for (int devices : deviceCounts) {
+    server.reset();
+    std::vector<DeviceStats> stats(devices);
+    std::vector<std::thread> threads;
+    Clock::time_point start = Clock::now();
+    Clock::time_point until = start + std::chrono::seconds(durationS);
+
+    for (int d = 0; d < devices; d++) {
+      char user[24];
+      snprintf(user, sizeof(user), "Device%04d", d);
+      threads.emplace_back([&, d, user]() {
+        Device device(server.port(), shared ? "User1" : user, batch, mlBatch, 1000 + d);
+        device.run(until, intervalMs, stats[d]);
+      });
+    }
+    for (auto &t : threads) t.join();
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    DeviceStats total;
+    for (auto &s : stats) {
+      total.requests += s.requests;
+      total.bytesSent += s.bytesSent;
+      total.bytesReceived += s.bytesReceived;
+      total.samples += s.samples;
+      total.errors += s.errors;
+      total.latencyUs.insert(total.latencyUs.end(), s.latencyUs.begin(), s.latencyUs.end());
+    }
+    std::sort(total.latencyUs.begin(), total.latencyUs.end());
+    double samples = total.samples ? (double)total.samples : 1.0;
+
+    printf("%8d %10llu %10.0f %10.1f %11.0f %9.0f %9.0f %9.0f %9.0f %7llu %9zu\n",
+           devices, (unsigned long long)total.samples, total.requests / elapsed,
+           total.requests / samples, (total.bytesSent + total.bytesReceived) / samples,
+           percentile(total.latencyUs, 0.50), percentile(total.latencyUs, 0.95),
+           percentile(total.latencyUs, 0.99),
+           total.latencyUs.empty() ? 0.0 : total.latencyUs.back(),
+           (unsigned long long)total.errors, server.countNodes("/ML_Training_"));
+  }
+  return 0;
+}
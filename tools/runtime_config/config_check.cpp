@@ -0,0 +1,141 @@
+/**
+ * Offline check of a <USER>/Config document before it is pushed to the RTDB.
+ *
+ * Runs every top-level key through the firmware's runtimeConfigSet() and
+ * reports the result the device would write to <USER>/Config_Status. Keys
+ * the document leaves out take the device's built-in defaults (the
+ * #defines in src/main.cpp) and are listed as such.
+ *
+ * Build from the project root:
+ *   g++ -O2 -std=c++17 -Ilib/RuntimeConfig tools/runtime_config/config_check.cpp \
+ *       lib/RuntimeConfig/RuntimeConfig.cpp -o config_check
+ *
+ * Usage:
+ *   config_check <config.json | ->
+ *
+ * The exit status is 0 if the device would apply the document. Push it with
+ * e.g. the Firebase console or
+ *   curl -X PUT -d @config.json "$DATABASE_URL/User1/Config.json?auth=$TOKEN"
+ * and raise "version" every time - the device ignores versions it already has.
+ */
+#include <RuntimeConfig.h>
+
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Split a flat JSON object into (key, raw value text) pairs
+ * Nested objects and arrays are kept as raw text, which the device rejects as a bad value.
+ */
+static bool parseFlatObject(const std::string &text, std::vector<std::pair<std::string, std::string>> &members) {
+  size_t pos = 0;
+  auto skipSpace = [&]() { while (pos < text.size() && isspace((unsigned char)text[pos])) pos++; };
+  auto readString = [&](std::string &out) {
+    if (pos >= text.size() || text[pos] != '"') return false;
+    size_t start = pos++;
+    while (pos < text.size() && text[pos] != '"') pos += text[pos] == '\\' ? 2 : 1;
+    if (pos >= text.size()) return false;
+    out = text.substr(start, ++pos - start);
+    return true;
+  };
+
+  skipSpace();
+  if (pos >= text.size() || text[pos++] != '{') return false;
+  skipSpace();
+  if (pos < text.size() && text[pos] == '}') return true;
+  for (;;) {
+    std::string key, value;
+    skipSpace();
+    if (!readString(key)) return false;
+    skipSpace();
+    if (pos >= text.size() || text[pos++] != ':') return false;
+    skipSpace();
+    if (pos < text.size() && text[pos] == '"') {
+      if (!readString(value)) return false;
+    } else {
+      size_t start = pos;
+      int depth = 0;
+      while (pos < text.size() && (depth > 0 || (text[pos] != ',' && text[pos] != '}'))) {
+        if (text[pos] == '{' || text[pos] == '[') depth++;
+        if (text[pos] == '}' || text[pos] == ']') depth--;
+        pos++;
+      }
+      value = text.substr(start, pos - start);
+      while (!value.empty() && isspace((unsigned char)value.back())) value.pop_back();
+    }
+    members.push_back({ key.substr(1, key.size() - 2), value });
+    skipSpace();
+    if (pos < text.size() && text[pos] == ',') {
+      pos++;
+      continue;
+    }
+    return pos < text.size() && text[pos] == '}';
+  }
+}
+
+int main(int argc, char** argv) {
+  if (argc != 2) {
+    fprintf(stderr, "usage: %s <config.json | ->\n", argv[0]);
+    return 2;
+  }
+  FILE* in = strcmp(argv[1], "-") ? fopen(argv[1], "r") : stdin;
+  if (!in) {
+    perror(argv[1]);
+    return 2;
+  }
+  std::string text;
+  char chunk[512];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), in)) > 0) {
+    text.append(chunk, n);
+  }
+  if (in != stdin) {
+    fclose(in);
+  }
+
+  std::vector<std::pair<std::string, std::string>> members;
+  if (!parseFlatObject(text, members)) {
+    fprintf(stderr, "%s: not a JSON object\n", argv[1]);
+    return 1;
+  }
+
+  RuntimeConfig candidate;
+  memset(&candidate, 0, sizeof(candidate));
+  RuntimeConfigResult result = CONFIG_OK;
+  std::vector<std::string> seen;
+  for (const auto &member : members) {
+    RuntimeConfigResult keyResult = runtimeConfigSet(candidate, member.first.c_str(), member.second.c_str());
+    printf("  %-18s %-14s %s\n", member.first.c_str(), member.second.c_str(), RUNTIME_CONFIG_RESULT_NAMES[keyResult]);
+    if (keyResult != CONFIG_OK && result == CONFIG_OK) {
+      result = keyResult;
+    }
+    seen.push_back(member.first);
+  }
+
+  auto listDefault = [&](const char* key) {
+    for (const auto &name : seen) {
+      if (name == key) return;
+    }
+    printf("  %-18s %-14s default\n", key, "-");
+  };
+#define RUNTIME_CONFIG_DEFAULT(name, member, min, max) listDefault(name);
+  RUNTIME_CONFIG_FIELDS(RUNTIME_CONFIG_DEFAULT)
+#undef RUNTIME_CONFIG_DEFAULT
+  listDefault("target_phone");
+
+  // The device fails a document without a version after parsing every key
+  if (result == CONFIG_OK && candidate.version == 0) {
+    result = CONFIG_NO_VERSION;
+  }
+  printf("result: %s", RUNTIME_CONFIG_RESULT_NAMES[result]);
+  if (result == CONFIG_OK) {
+    printf(" (applied if version %lu is above the device's active version)", (unsigned long)candidate.version);
+  }
+  printf("\n");
+  return result == CONFIG_OK ? 0 : 1;
+}
@@ -0,0 +1,186 @@
+/**
+ * Host simulation of the epoch clock (lib/TimeService).
+ *
+ * A monotonic timer runs --drift-ppm fast against true time. Every
+ * --sync-s seconds the firmware's TimeService gets an SNTP observation off
+ * by up to +-jitter, as syncTimeWithNTP()'s callback would feed it. The
+ * clock is read once a second and compared with true time.
+ *
+ * Cases (all run unless --case picks one):
+ *   drift   steady drift, small jitter
+ *   jitter  steady drift, noisy SNTP
+ *   slew    reference time moves +250 ms mid-run: must be slewed in, never stepped,
+ *           and stamps must not go backwards. One sync cannot tell a shift from
+ *           drift, so part of it lands in the drift estimate and takes a few
+ *           syncs to wash out; the case allows two hours to settle
+ *   step    reference time moves +5 s mid-run: must be stepped in one sync
+ *
+ * Reported per case:
+ *   max err    worst |epoch - true| after --warmup-s, ms. The drift estimate is
+ *              smoothed 1:1 with each new measurement, so its error halves per
+ *              sync and the first hour or so is still converging.
+ *   mean err   mean |epoch - true| after warm-up, ms
+ *   settle     for slew/step: seconds from the shift until the error is back under the bound
+ *   back       stamps earlier than the previous stamp
+ *   steps      TimeSyncQuality::stepCount
+ *
+ * Build from the project root:
+ *   g++ -O2 -std=c++17 -Ilib/TimeService tools/time_sim/time_sim.cpp \
+ *       lib/TimeService/TimeService.cpp -o time_sim
+ *
+ * Usage:
+ *   time_sim [--case drift|jitter|slew|step] [--drift-ppm 40] [--sync-s 600] [--hours 24]
+ *            [--warmup-s 7200] [--seed 1]
+ *
+ * Exits non-zero if a case breaks its bound, goes backwards, or steps when it should slew.
+ */
+#include <TimeService.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <random>
+
+struct SimCase {
+  const char* name;
+  double jitterMs;       // SNTP observation error, uniform +-
+  double shiftMs;        // Reference time moves by this much at half time (0 = none)
+  double boundMs;        // Max error allowed after warm-up (outside the settle window)
+  double settleS;        // Time allowed after the shift to get back under the bound
+  uint32_t expectSteps;  // Including the first fix
+};
+
+static const SimCase CASES[] = {
+  { "drift",  1.0,     0.0,  2.0,    0.0, 1 },
+  { "jitter", 20.0,    0.0,  40.0,   0.0, 1 },
+  { "slew",   1.0,   250.0,  2.0, 7200.0, 1 },
+  { "step",   1.0,  5000.0,  2.0, 1200.0, 2 },
+};
+
+struct SimParams {
+  const char* only = NULL;
+  double driftPpm = 40;
+  double syncS = 600;
+  double hours = 24;
+  double warmupS = 7200;
+  unsigned seed = 1;
+};
+
+struct SimResult {
+  double maxErrMs = 0;
+  double sumErrMs = 0;
+  long samples = 0;
+  double settleS = 0;
+  long backwards = 0;
+  uint32_t steps = 0;
+  bool inBound = true;
+};
+
+static SimResult runCase(const SimCase &c, const SimParams &p) {
+  std::mt19937 rng(p.seed);
+  std::uniform_real_distribution<double> jitter(-c.jitterMs * 1000.0, c.jitterMs * 1000.0);
+
+  const int64_t epochBaseUs = 1760000000LL * 1000000;
+  const int64_t totalS = (int64_t)(p.hours * 3600);
+  const int64_t shiftAtS = c.shiftMs != 0 ? totalS / 2 : -1;
+  const int64_t warmupS = (int64_t)p.warmupS;
+
+  TimeService clock;
+  SimResult r;
+  int64_t lastStamp = 0;
+  int64_t nextSyncS = 5;   // First fix a few seconds after boot, as with SNTP
+  int64_t lastOutOfBoundS = -1;
+
+  for (int64_t t = 0; t <= totalS; t++) {
+    // True time since boot, and the monotonic timer running drift-ppm fast
+    int64_t trueUs = t * 1000000;
+    int64_t monoUs = trueUs + (int64_t)(trueUs * p.driftPpm * 1e-6);
+    int64_t refEpochUs = epochBaseUs + trueUs + (shiftAtS >= 0 && t >= shiftAtS ? (int64_t)(c.shiftMs * 1000) : 0);
+
+    if (t == nextSyncS) {
+      clock.onSync(monoUs, refEpochUs + (int64_t)jitter(rng));
+      nextSyncS += (int64_t)p.syncS;
+    }
+    if (!clock.synced()) {
+      continue;
+    }
+
+    int64_t stamp = clock.epochUs(monoUs);
+    if (lastStamp != 0 && stamp < lastStamp) {
+      r.backwards++;
+    }
+    lastStamp = stamp;
+
+    double errMs = fabs((double)(stamp - refEpochUs)) / 1000.0;
+    if (t < warmupS) {
+      continue;
+    }
+    bool settling = shiftAtS >= 0 && t >= shiftAtS && t < shiftAtS + (int64_t)c.settleS;
+    if (errMs > c.boundMs) {
+      lastOutOfBoundS = t;
+      if (!settling) {
+        r.inBound = false;
+      }
+    }
+    if (!settling) {
+      r.maxErrMs = errMs > r.maxErrMs ? errMs : r.maxErrMs;
+      r.sumErrMs += errMs;
+      r.samples++;
+    }
+  }
+
+  if (shiftAtS >= 0) {
+    r.settleS = lastOutOfBoundS >= shiftAtS ? (double)(lastOutOfBoundS + 1 - shiftAtS) : 0.0;
+  }
+  r.steps = clock.quality(0).stepCount;
+  return r;
+}
+
+int main(int argc, char** argv) {
+  SimParams p;
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    const char* value = i + 1 < argc ? argv[++i] : NULL;
+    if (!value) {
+      fprintf(stderr, "missing value for %s\n", arg);
+      return 2;
+    }
+    if (!strcmp(arg, "--case")) p.only = value;
+    else if (!strcmp(arg, "--drift-ppm")) p.driftPpm = atof(value);
+    else if (!strcmp(arg, "--sync-s")) p.syncS = atof(value);
+    else if (!strcmp(arg, "--hours")) p.hours = atof(value);
+    else if (!strcmp(arg, "--warmup-s")) p.warmupS = atof(value);
+    else if (!strcmp(arg, "--seed")) p.seed = (unsigned)atoi(value);
+    else {
+      fprintf(stderr, "unknown option %s\n", arg);
+      return 2;
+    }
+  }
+
+  printf("drift %+.0f ppm, sync every %.0f s, %.0f h, warm-up %.0f s\n\n", p.driftPpm, p.syncS, p.hours, p.warmupS);
+  printf("%-8s %9s %9s %9s %9s %9s %5s %6s  %s\n",
+         "case", "jitter ms", "shift ms", "max err", "mean err", "settle s", "back", "steps", "result");
+  int failures = 0;
+  int run = 0;
+  for (const SimCase &c : CASES) {
+    if (p.only && strcmp(p.only, c.name)) {
+      continue;
+    }
+    run++;
+    SimResult r = runCase(c, p);
+    bool ok = r.inBound && r.backwards == 0 && r.steps == c.expectSteps;
+    printf("%-8s %9.1f %9.0f %9.3f %9.3f %9.0f %5ld %6u  %s\n",
+           c.name, c.jitterMs, c.shiftMs, r.maxErrMs, r.samples ? r.sumErrMs / r.samples : 0.0,
+           r.settleS, r.backwards, r.steps, ok ? "PASS" : "FAIL");
+    if (!ok) {
+      failures++;
+    }
+  }
+  if (run == 0) {
+    fprintf(stderr, "unknown case %s\n", p.only);
+    return 2;
+  }
+  return failures == 0 ? 0 : 1;
+}
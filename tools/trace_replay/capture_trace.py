@@ -0,0 +1,48 @@
+#!/usr/bin/env python3
+"""Pull a sensor trace off a device built with ENABLE_TRACE_RECORDING.
+
+Usage: capture_trace.py <serial port> <out.bin> [--previous]
+
+Sends 'd' (current boot) or 'p' (previous boot) on the console and saves the
+raw bytes between "TRACE BEGIN <n>" and "TRACE END". Requires pyserial.
+"""
+import sys
+
+import serial
+
+
+def main():
+    if len(sys.argv) < 3:
+        print(__doc__)
+        return 2
+
+    port, out_path = sys.argv[1], sys.argv[2]
+    command = b"p" if "--previous" in sys.argv[3:] else b"d"
+
+    with serial.Serial(port, 115200, timeout=15) as link:
+        link.reset_input_buffer()
+        link.write(command)
+
+        # The heartbeat loop polls the console every 10 s, so wait for the marker
+        while True:
+            line = link.readline()
+            if not line:
+                print("Timed out waiting for TRACE BEGIN")
+                return 1
+            if line.startswith(b"TRACE BEGIN"):
+                length = int(line.split()[2])
+                break
+
+        data = link.read(length)
+        if len(data) != length:
+            print("Short read: got %d of %d bytes" % (len(data), length))
+            return 1
+
+    with open(out_path, "wb") as f:
+        f.write(data)
+    print("Saved %d bytes to %s" % (length, out_path))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
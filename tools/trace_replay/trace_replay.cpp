@@ -0,0 +1,348 @@
+/**
+ * Host replay backend for sensor traces recorded with ENABLE_TRACE_RECORDING.
+ *
+ * Feeds each raw reading through the same acquisition state updates the
+ * read functions perform (traceApply) and closes an upload window every
+ * --upload-interval-ms of trace time, building the live and ML payloads
+ * with the shared Telemetry builders.
+ *
+ * Build from the project root:
+ *   g++ -O2 -std=c++17 -Ilib/WindowStats -Ilib/Telemetry -Ilib/SensorTrace -Ilib/AnomalyBurst -Itools/common \
+ *       tools/trace_replay/trace_replay.cpp lib/SensorTrace/SensorTrace.cpp lib/Telemetry/MlBatch.cpp \
+ *       lib/AnomalyBurst/AnomalyDetector.cpp lib/AnomalyBurst/BurstRecorder.cpp -o trace_replay
+ *
+ * Usage:
+ *   trace_replay <trace.bin> [--speed 1|max] [--upload-interval-ms MS] [--emit out.jsonl]
+ *   trace_replay <trace.bin> --burst [--z 4.0] [--burst-ms MS] [--pre-rows N] [--alpha A] [--warmup N]
+ *   trace_replay --synth <trace.bin> [--seconds N] [--event-at S]   write a synthetic trace at device cadence
+ *
+ * --emit writes one ML record per line, so two runs (e.g. before and after a
+ * detector change) can be diffed for regressions.
+ *
+ * --burst also runs the firmware's anomaly scoring and burst capture
+ * (ENABLE_ANOMALY_BURST) on every acquisition cycle, then reports each
+ * trigger and the bytes burst chunks would add to the regular uploads.
+ * Defaults match src/main.cpp. The trace keeps its recorded cadence, so
+ * bursts replay at the normal sensor period rather than the faster burst
+ * period. --synth --event-at S adds a 20 s disturbance (object temperature
+ * step and shaking) at S seconds.
+ */
+#include <AnomalyDetector.h>
+#include <BurstRecorder.h>
+#include <HostJson.h>
+#include <MlBatch.h>
+#include <SensorTrace.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static bool readFile(const char* path, std::vector<uint8_t> &data) {
+  FILE* f = fopen(path, "rb");
+  if (!f) {
+    perror(path);
+    return false;
+  }
+  uint8_t chunk[4096];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+    data.insert(data.end(), chunk, chunk + n);
+  }
+  fclose(f);
+  return true;
+}
+
+struct BurstOptions {
+  bool enabled = false;
+  float z = 5.0f;               // ANOMALY_Z_TENTHS / 10
+  uint32_t burstMs = 30000;     // BURST_MS
+  uint32_t maxBurstMs = 120000; // BURST_MAX_MS
+  uint8_t preRows = 12;         // BURST_PRE_TRIGGER_ROWS
+  float alpha = 0.05f;          // ANOMALY_EWMA_ALPHA
+  uint16_t warmup = 20;         // ANOMALY_WARMUP_SAMPLES
+};
+
+/**
+ * @brief The sensor task's anomaly scoring and burst ring, with an uploader that never lags
+ */
+class BurstReplay {
+public:
+  explicit BurstReplay(const BurstOptions &options)
+      : options_(options), detector_(options.alpha, options.warmup) {
+    recorder_.configure(options.preRows, options.burstMs, options.maxBurstMs);
+  }
+
+  /**
+   * @brief One finished acquisition cycle
+   */
+  void observe(const SensorSample &sample, uint8_t mask, uint64_t timeUs) {
+    AnomalyScore score = detector_.update(sample, mask);
+    BurstEvent event = recorder_.observe(sample, mask, (int64_t)(timeUs / 1000), score,
+                                         score.z >= options_.z, (uint32_t)(timeUs / 1000));
+    cycles_++;
+    if (event == BURST_STARTED) {
+      printf("  %8.1f s  burst %u: %s/%s z=%.1f value %.3f (%u history rows)\n", timeUs / 1e6,
+             recorder_.lastTrigger().burst, LIVE_NODE_NAMES[SENSOR_FIELDS[score.field].node], SENSOR_FIELDS[score.field].name,
+             score.z, score.value, recorder_.lastTrigger().preTriggerRows);
+    }
+    // Upload a chunk whenever one is full, and the tail once the burst is over
+    while (recorder_.pending() >= BURST_CHUNK_ROWS || (!recorder_.active() && recorder_.pending() > 0)) {
+      uploadChunk();
+    }
+  }
+
+  void finish() {
+    while (recorder_.pending() > 0) {
+      uploadChunk();
+    }
+  }
+
+  void report(uint64_t regularBytes) const {
+    printf("Bursts:     %u, %llu of %llu cycles uploaded in %llu chunks, %llu bytes (+%.1f%% over regular uploads)\n",
+           recorder_.bursts(), (unsigned long long)rows_, (unsigned long long)cycles_,
+           (unsigned long long)chunks_, (unsigned long long)bytes_,
+           regularBytes ? 100.0 * bytes_ / regularBytes : 0.0);
+  }
+
+private:
+  static const size_t BURST_CHUNK_ROWS = 12;   // As in src/main.cpp
+
+  void uploadChunk() {
+    static BurstRow rows[BURST_CHUNK_ROWS];
+    static MlBatch batch;
+    static char buffer[8192];
+    size_t count = recorder_.peek(rows, BURST_CHUNK_ROWS);
+    batch.clear();
+    uint8_t mask = 0;
+    for (size_t i = 0; i < count; i++) {
+      MlBatchRow* row = batch.nextRow();
+      row->sample = rows[i].sample;
+      row->timeMs = (double)rows[i].timeMs;
+      row->actionsOn = 0;
+      mask |= rows[i].mask;
+      batch.push();
+    }
+    bytes_ += batch.encode(buffer, sizeof(buffer), mask, false);
+    rows_ += count;
+    chunks_++;
+    recorder_.commit();
+  }
+
+  BurstOptions options_;
+  AnomalyDetector detector_;
+  BurstRecorder recorder_;
+  uint64_t cycles_ = 0;
+  uint64_t rows_ = 0;
+  uint64_t chunks_ = 0;
+  uint64_t bytes_ = 0;
+};
+
+/**
+ * @brief Write a synthetic trace with the sensor task's ~2.6 s cycle
+ */
+static int synthesise(const char* path, int seconds, int eventAtS) {
+  std::vector<uint8_t> out(TRACE_HEADER_SIZE);
+  traceWriteHeader(out.data());
+
+  std::mt19937 rng(42);
+  std::normal_distribution<float> noise(0.0f, 1.0f);
+  uint64_t lastUs = 0;
+  uint8_t record[TRACE_MAX_RECORD];
+
+  for (uint64_t t = 0; t < (uint64_t)seconds * 1000000ULL; t += 2600000ULL) {
+    float minutes = t / 60e6f;
+    float aht[] = { 60.0f + 5.0f * sinf(minutes / 10.0f) + 0.2f * noise(rng), 29.0f + 0.05f * noise(rng) };
+    float mlx[] = { 28.5f + 0.02f * noise(rng), 33.0f + 0.3f * noise(rng) };
+    float mpu[] = { 0.1f * noise(rng), 0.1f * noise(rng), 9.81f + 0.05f * noise(rng),
+                    0.01f * noise(rng), 0.01f * noise(rng), 0.01f * noise(rng), 31.0f };
+    float sgp[] = { (float)(12 + (int)fabsf(4.0f * noise(rng))), (float)(400 + (int)fabsf(20.0f * noise(rng))) };
+    if (eventAtS >= 0 && t >= (uint64_t)eventAtS * 1000000ULL && t < (uint64_t)(eventAtS + 20) * 1000000ULL) {
+      mlx[1] += 3.0f;   // Hot object in view
+      for (int axis = 0; axis < 3; axis++) {
+        mpu[axis] += 2.0f * noise(rng);
+        mpu[3 + axis] += 0.5f * noise(rng);
+      }
+    }
+
+    // Same order and spacing as TaskSensorReadings (MPU read blocks ~500 ms)
+    const float* values[] = { aht, mlx, mpu, sgp };
+    const uint64_t offsets[] = { 0, 2000, 4000, 504000 };
+    for (int sensor = 0; sensor < TRACE_SENSOR_COUNT; sensor++) {
+      size_t n = traceEncode(record, sizeof(record), lastUs, sensor, t + offsets[sensor], values[sensor]);
+      out.insert(out.end(), record, record + n);
+    }
+  }
+
+  FILE* f = fopen(path, "wb");
+  if (!f) {
+    perror(path);
+    return 1;
+  }
+  fwrite(out.data(), 1, out.size(), f);
+  fclose(f);
+  printf("Wrote %zu bytes to %s\n", out.size(), path);
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  const char* tracePath = NULL;
+  const char* emitPath = NULL;
+  const char* synthPath = NULL;
+  bool realTime = true;
+  double speed = 1.0;
+  uint64_t uploadIntervalUs = 5000000ULL;
+  int synthSeconds = 600;
+  int eventAtS = -1;
+  BurstOptions burstOptions;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--speed") && i + 1 < argc) {
+      i++;
+      realTime = strcmp(argv[i], "max") != 0;
+      speed = realTime ? atof(argv[i]) : 0.0;
+      if (realTime && speed <= 0.0) speed = 1.0;
+    } else if (!strcmp(argv[i], "--upload-interval-ms") && i + 1 < argc) {
+      uploadIntervalUs = strtoull(argv[++i], NULL, 10) * 1000ULL;
+    } else if (!strcmp(argv[i], "--emit") && i + 1 < argc) {
+      emitPath = argv[++i];
+    } else if (!strcmp(argv[i], "--synth") && i + 1 < argc) {
+      synthPath = argv[++i];
+    } else if (!strcmp(argv[i], "--seconds") && i + 1 < argc) {
+      synthSeconds = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--event-at") && i + 1 < argc) {
+      eventAtS = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--burst")) {
+      burstOptions.enabled = true;
+    } else if (!strcmp(argv[i], "--z") && i + 1 < argc) {
+      burstOptions.z = atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--burst-ms") && i + 1 < argc) {
+      burstOptions.burstMs = strtoul(argv[++i], NULL, 10);
+    } else if (!strcmp(argv[i], "--pre-rows") && i + 1 < argc) {
+      burstOptions.preRows = (uint8_t)atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--alpha") && i + 1 < argc) {
+      burstOptions.alpha = atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--warmup") && i + 1 < argc) {
+      burstOptions.warmup = (uint16_t)atoi(argv[++i]);
+    } else if (argv[i][0] != '-') {
+      tracePath = argv[i];
+    } else {
+      tracePath = NULL;
+      break;
+    }
+  }
+
+  if (synthPath) {
+    return synthesise(synthPath, synthSeconds, eventAtS);
+  }
+  if (!tracePath) {
+    fprintf(stderr, "usage: %s <trace.bin> [--speed 1|max] [--upload-interval-ms MS] [--emit out.jsonl]\n"
+                    "          [--burst [--z Z] [--burst-ms MS] [--pre-rows N] [--alpha A] [--warmup N]]\n"
+                    "       %s --synth <trace.bin> [--seconds N] [--event-at S]\n", argv[0], argv[0]);
+    return 2;
+  }
+
+  std::vector<uint8_t> data;
+  if (!readFile(tracePath, data)) {
+    return 1;
+  }
+  TraceReader reader(data.data(), data.size());
+  if (!reader.valid()) {
+    fprintf(stderr, "%s: not a sensor trace (bad header)\n", tracePath);
+    return 1;
+  }
+
+  FILE* emit = emitPath ? fopen(emitPath, "w") : NULL;
+  static const char* const actions[ACTION_COUNT] = { "OFF", "OFF", "OFF", "OFF", "OFF" };
+
+  SensorSample sample = {};
+  WindowStats window[WF_COUNT];
+  uint8_t seenMask = 0;
+  uint64_t events = 0;
+  uint64_t uploads = 0;
+  uint64_t payloadBytes = 0;
+  uint64_t nextUploadUs = uploadIntervalUs;
+  uint64_t lastTimeUs = 0;
+  BurstReplay burst(burstOptions);
+  int lastSensor = TRACE_SENSOR_COUNT;
+  uint8_t cycleMask = 0;
+  if (burstOptions.enabled) {
+    printf("Triggers (z >= %.1f):\n", burstOptions.z);
+  }
+
+  Clock::time_point start = Clock::now();
+  TraceEvent event;
+  while (reader.next(event)) {
+    if (realTime) {
+      std::this_thread::sleep_until(start + std::chrono::microseconds((uint64_t)(event.timeUs / speed)));
+    }
+
+    // Upload stage: close every window that ended before this reading
+    while (event.timeUs >= nextUploadUs) {
+      for (int node = 0; node < LIVE_NODE_COUNT; node++) {
+        HostJson live;
+        buildLivePayload(live, (LiveNode)node, sample);
+        payloadBytes += live.toString().size();
+      }
+      HostJson record;
+      buildMlRecord(record, sample, seenMask, window, actions, nextUploadUs / 1000.0);
+      std::string json = record.toString();
+      payloadBytes += json.size();
+      if (emit) {
+        fprintf(emit, "%s\n", json.c_str());
+      }
+      for (int f = 0; f < WF_COUNT; f++) {
+        window[f].reset();
+      }
+      uploads++;
+      nextUploadUs += uploadIntervalUs;
+    }
+
+    // Sensors are read in TraceSensor order, so a repeat or lower index starts the next cycle
+    if (burstOptions.enabled && event.sensor <= lastSensor && cycleMask != 0) {
+      burst.observe(sample, cycleMask, lastTimeUs);
+      cycleMask = 0;
+    }
+    lastSensor = event.sensor;
+    cycleMask |= 1 << event.sensor;
+
+    // Acquisition stage
+    traceApply(event, sample, window);
+    seenMask |= 1 << event.sensor;   // TraceSensor order matches SensorBit order
+    lastTimeUs = event.timeUs;
+    events++;
+  }
+
+  if (burstOptions.enabled) {
+    if (cycleMask != 0) {
+      burst.observe(sample, cycleMask, lastTimeUs);
+    }
+    burst.finish();
+  }
+
+  double wall = std::chrono::duration<double>(Clock::now() - start).count();
+  double traced = lastTimeUs / 1e6;
+  if (emit) {
+    fclose(emit);
+  }
+
+  printf("Trace:      %s (%zu bytes, %.2f bytes/reading)\n", tracePath, data.size(),
+         events ? (double)(data.size() - TRACE_HEADER_SIZE) / events : 0.0);
+  printf("Readings:   %llu over %.1f s of trace time\n", (unsigned long long)events, traced);
+  printf("Uploads:    %llu windows, %.0f payload bytes/window\n", (unsigned long long)uploads,
+         uploads ? (double)payloadBytes / uploads : 0.0);
+  if (burstOptions.enabled) {
+    burst.report(payloadBytes);
+  }
+  printf("Wall time:  %.3f s (%.0fx real time, %.0f readings/s)\n", wall,
+         wall > 0 ? traced / wall : 0.0, wall > 0 ? events / wall : 0.0);
+  return 0;
+}
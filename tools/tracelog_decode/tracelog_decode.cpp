@@ -0,0 +1,190 @@
+/**
+ * Host decoder for the binary trace logger (lib/TraceLog).
+ *
+ * Reads a raw serial capture, formats every log frame with the shared
+ * TraceLogFormats.h table and passes any plain text in between (boot
+ * messages, console replies) through unchanged.
+ *
+ * Build from the project root:
+ *   g++ -O2 -std=c++17 -Ilib/TraceLog tools/tracelog_decode/tracelog_decode.cpp \
+ *       lib/TraceLog/TraceLog.cpp -o tracelog_decode
+ *
+ * Capture, e.g.:
+ *   pio device monitor --raw -b 115200 > capture.bin     (or: cat /dev/ttyUSB0 > capture.bin)
+ *
+ * Usage:
+ *   tracelog_decode <capture.bin | -> [--level 0-3] [--no-text] [--stats]
+ *
+ * Output: "<seconds since first record> <core> <level> <message>" per record.
+ * Send '0'..'3' on the device console to change the level at runtime.
+ */
+#include <TraceLog.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#define TRACELOG_FORMAT(id, level, format) format,
+static const char* const FORMATS[TL_FORMAT_COUNT] = { TRACELOG_FORMATS(TRACELOG_FORMAT) };
+#undef TRACELOG_FORMAT
+
+#define TRACELOG_NAME(id, level, format) #id,
+static const char* const NAMES[TL_FORMAT_COUNT] = { TRACELOG_FORMATS(TRACELOG_NAME) };
+#undef TRACELOG_NAME
+
+/**
+ * @brief Apply a format string to raw argument words
+ */
+static std::string formatRecord(const char* format, const TraceLogRecord &record) {
+  std::string out;
+  uint8_t arg = 0;
+  char buffer[64];
+
+  for (const char* p = format; *p; p++) {
+    if (*p != '%') {
+      out += *p;
+      continue;
+    }
+    if (p[1] == '%') {
+      out += '%';
+      p++;
+      continue;
+    }
+
+    // Collect the conversion spec (flags, width, precision, type)
+    std::string spec = "%";
+    p++;
+    while (*p && strchr("-+ #0123456789.", *p)) {
+      spec += *p++;
+    }
+    if (!*p) {
+      break;
+    }
+    char type = *p;
+
+    if (arg >= record.argCount) {
+      out += "<missing>";
+      continue;
+    }
+    uint32_t bits = record.args[arg++];
+    if (type == 'f') {
+      float value;
+      memcpy(&value, &bits, sizeof(value));
+      snprintf(buffer, sizeof(buffer), (spec + 'f').c_str(), value);
+    } else if (type == 'd') {
+      snprintf(buffer, sizeof(buffer), (spec + 'd').c_str(), (int32_t)bits);
+    } else if (type == 'x' || type == 'u') {
+      snprintf(buffer, sizeof(buffer), (spec + type).c_str(), bits);
+    } else {
+      snprintf(buffer, sizeof(buffer), "<%%%c?>", type);
+    }
+    out += buffer;
+  }
+  return out;
+}
+
+int main(int argc, char** argv) {
+  const char* path = NULL;
+  int maxLevel = TL_DEBUG;
+  bool showText = true;
+  bool showStats = false;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--level") && i + 1 < argc) {
+      maxLevel = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--no-text")) {
+      showText = false;
+    } else if (!strcmp(argv[i], "--stats")) {
+      showStats = true;
+    } else if (!path && (argv[i][0] != '-' || !strcmp(argv[i], "-"))) {
+      path = argv[i];
+    } else {
+      path = NULL;
+      break;
+    }
+  }
+  if (!path) {
+    fprintf(stderr, "usage: %s <capture.bin | -> [--level 0-3] [--no-text] [--stats]\n", argv[0]);
+    return 2;
+  }
+
+  FILE* f = strcmp(path, "-") ? fopen(path, "rb") : stdin;
+  if (!f) {
+    perror(path);
+    return 1;
+  }
+  std::vector<uint8_t> data;
+  uint8_t chunk[4096];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+    data.insert(data.end(), chunk, chunk + n);
+  }
+  if (f != stdin) {
+    fclose(f);
+  }
+
+  uint64_t counts[TL_FORMAT_COUNT] = {};
+  uint64_t frames = 0;
+  uint64_t unknown = 0;
+  uint64_t textBytes = 0;
+
+  // The device timer wraps every ~71 minutes; unwrap it into 64 bits. Deltas are
+  // signed because the two cores' records (and drop notices) are not strictly ordered.
+  bool haveTime = false;
+  uint32_t lastRaw = 0;
+  int64_t timeUs = 0;
+  int64_t firstUs = 0;
+
+  size_t pos = 0;
+  while (pos < data.size()) {
+    TraceLogRecord record;
+    size_t length = data[pos] == TRACELOG_SYNC0
+                  ? traceLogParseFrame(&data[pos], data.size() - pos, record) : 0;
+    if (length == 0) {
+      if (showText) {
+        fputc(data[pos], stdout);
+      }
+      textBytes++;
+      pos++;
+      continue;
+    }
+    pos += length;
+    frames++;
+
+    if (!haveTime) {
+      timeUs = firstUs = record.timeUs;
+      haveTime = true;
+    } else {
+      timeUs += (int32_t)(record.timeUs - lastRaw);
+    }
+    lastRaw = record.timeUs;
+
+    if (record.formatId >= TL_FORMAT_COUNT) {
+      printf("%12.6f c%u ? unknown format id %u (newer firmware?)\n",
+             (timeUs - firstUs) / 1e6, record.core, record.formatId);
+      unknown++;
+      continue;
+    }
+    counts[record.formatId]++;
+    uint8_t level = TRACELOG_LEVELS[record.formatId];
+    if (level > maxLevel) {
+      continue;
+    }
+    printf("%12.6f c%u %s %s\n", (timeUs - firstUs) / 1e6, record.core,
+           TRACELOG_LEVEL_NAMES[level], formatRecord(FORMATS[record.formatId], record).c_str());
+  }
+
+  if (showStats) {
+    fprintf(stderr, "\n%llu frames, %llu unknown ids, %llu text bytes\n",
+            (unsigned long long)frames, (unsigned long long)unknown, (unsigned long long)textBytes);
+    for (int id = 0; id < TL_FORMAT_COUNT; id++) {
+      if (counts[id]) {
+        fprintf(stderr, "  %-26s %llu\n", NAMES[id], (unsigned long long)counts[id]);
+      }
+    }
+  }
+  return 0;
+}
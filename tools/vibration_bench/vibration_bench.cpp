@@ -0,0 +1,153 @@
+/**
+ * Host-side golden-vector check and benchmark for the vibration FFT kernels.
+ *
+ * Build and run from the project root:
+ *   g++ -O2 -Ilib/VibrationFeatures tools/vibration_bench/vibration_bench.cpp \
+ *       lib/VibrationFeatures/VibrationFeatures.cpp -o vibration_bench
+ *   ./vibration_bench
+ *
+ * Exits non-zero if any golden vector does not match, so it can gate changes
+ * to the kernels before they are flashed.
+ */
+#include <VibrationFeatures.h>
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static int failures = 0;
+
+static void expectNear(const char* what, float actual, float expected, float tolerance) {
+  if (fabsf(actual - expected) > tolerance) {
+    printf("FAIL %s: got %f, expected %f\n", what, actual, expected);
+    failures++;
+  }
+}
+
+/**
+ * @brief 8-point FFT of [1 2 3 4 0 0 0 0] against a reference DFT
+ */
+static void goldenFft8() {
+  static const float expected[16] = {
+    10.0f, 0.0f,   -0.414214f, -7.242641f, -2.0f, 2.0f,  2.414214f, -1.242641f,
+    -2.0f, 0.0f,    2.414214f,  1.242641f, -2.0f, -2.0f, -0.414214f, 7.242641f
+  };
+  float data[16] = { 1, 0, 2, 0, 3, 0, 4, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+  vibrationFft(data, 8);
+  for (int i = 0; i < 16; i++) {
+    char what[32];
+    snprintf(what, sizeof(what), "fft8[%d]", i);
+    expectNear(what, data[i], expected[i], 1e-4f);
+  }
+}
+
+/**
+ * @brief Impulse in, flat unit spectrum out
+ */
+static void goldenImpulse() {
+  float data[2 * VIBRATION_FFT_SIZE] = { 0 };
+  data[0] = 1.0f;
+  vibrationFft(data, VIBRATION_FFT_SIZE);
+  for (int k = 0; k < VIBRATION_FFT_SIZE; k++) {
+    expectNear("impulse re", data[2 * k], 1.0f, 1e-5f);
+    expectNear("impulse im", data[2 * k + 1], 0.0f, 1e-5f);
+  }
+}
+
+/**
+ * @brief 8 Hz tremor-like tone sampled at 100 Hz on top of gravity
+ */
+static void goldenTone() {
+  const float rate = 100.0f;
+  float samples[VIBRATION_FFT_SIZE];
+  for (int i = 0; i < VIBRATION_FFT_SIZE; i++) {
+    samples[i] = 9.81f + 0.5f * sinf(2.0f * (float)M_PI * 8.0f * i / rate);
+  }
+
+  VibrationFeatures f;
+  vibrationCompute(samples, rate, f);
+  expectNear("tone dominantHz", f.dominantHz, 8.0f, rate / VIBRATION_FFT_SIZE);
+  expectNear("tone rms", f.rms, 0.5f / sqrtf(2.0f), 0.02f);
+  if (f.bandEnergy[1] < 0.9f * (f.bandEnergy[0] + f.bandEnergy[1] + f.bandEnergy[2] + f.bandEnergy[3])) {
+    printf("FAIL tone: 4-12 Hz band does not hold the energy\n");
+    failures++;
+  }
+  if (f.spectralEntropy > 0.3f) {
+    printf("FAIL tone: entropy %f too high for a pure tone\n", f.spectralEntropy);
+    failures++;
+  }
+}
+
+/**
+ * @brief Uniform noise spreads energy, so entropy should be close to 1
+ */
+static void goldenNoise() {
+  float samples[VIBRATION_FFT_SIZE];
+  srand(1234);
+  for (int i = 0; i < VIBRATION_FFT_SIZE; i++) {
+    samples[i] = (float)rand() / RAND_MAX - 0.5f;
+  }
+
+  VibrationFeatures f;
+  vibrationCompute(samples, 100.0f, f);
+  if (f.spectralEntropy < 0.8f) {
+    printf("FAIL noise: entropy %f too low for white noise\n", f.spectralEntropy);
+    failures++;
+  }
+}
+
+template <typename Fn>
+static double timeNs(int iterations, Fn fn) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) {
+    fn();
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+}
+
+int main() {
+  if (!vibrationInit()) {
+    printf("vibrationInit failed\n");
+    return 1;
+  }
+  printf("Backend: %s, FFT size %d\n", vibrationBackend(), VIBRATION_FFT_SIZE);
+
+  goldenFft8();
+  goldenImpulse();
+  goldenTone();
+  goldenNoise();
+  printf("Golden vectors: %s\n", failures == 0 ? "PASS" : "FAIL");
+
+  // Benchmark the raw FFT and the full feature pipeline
+  static float data[2 * VIBRATION_FFT_SIZE];
+  float samples[VIBRATION_FFT_SIZE];
+  for (int i = 0; i < VIBRATION_FFT_SIZE; i++) {
+    samples[i] = sinf(0.3f * i) + 0.1f * ((float)rand() / RAND_MAX);
+  }
+  VibrationFeatures f;
+  volatile float sink = 0.0f;
+
+  const int iterations = 20000;
+  double fftNs = timeNs(iterations, [&]() {
+    for (int i = 0; i < VIBRATION_FFT_SIZE; i++) {
+      data[2 * i] = samples[i];
+      data[2 * i + 1] = 0.0f;
+    }
+    vibrationFft(data, VIBRATION_FFT_SIZE);
+    sink = sink + data[2];
+  });
+  double computeNs = timeNs(iterations, [&]() {
+    vibrationCompute(samples, 100.0f, f);
+    sink = sink + f.dominantHz;
+  });
+
+  printf("FFT (%d pt):        %8.0f ns/window\n", VIBRATION_FFT_SIZE, fftNs);
+  printf("Feature pipeline:   %8.0f ns/window\n", computeNs);
+  return failures == 0 ? 0 : 1;
+}